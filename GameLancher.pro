@@ -21,12 +21,34 @@ SOURCES += \
     main.cpp \
     mainwindow.cpp \
     appinfo.cpp \
+    appstore.cpp \
     appmanager.cpp \
+    catalogjournal.cpp \
+    filelock.cpp \
+    catalogsaver.cpp \
+    catalogjson.cpp \
+    iconrepairqueue.cpp \
+    searchindex.cpp \
+    searchsession.cpp \
+    searchworker.cpp \
+    fuzzymatcher.cpp \
+    frecencyindex.cpp \
+    catalogsnapshot.cpp \
+    catalogversion.cpp \
     applauncher.cpp \
     iconextractor.cpp \
     addappdialog.cpp \
     categorymanager.cpp \
     appdiscovery.cpp \
+    directoryindex.cpp \
+    keywordautomaton.cpp \
+    exclusionmatcher.cpp \
+    pathtrie.cpp \
+    excludelist.cpp \
+    fileidentity.cpp \
+    categoryclassifier.cpp \
+    displaynamecleaner.cpp \
+    directoryscanner.cpp \
     appdiscoverydialog.cpp \
     applistmodel.cpp \
     appicondelegate.cpp
@@ -34,12 +56,36 @@ SOURCES += \
 HEADERS += \
     mainwindow.h \
     appinfo.h \
+    appstore.h \
+    chunkedvector.h \
+    shardedhash.h \
     appmanager.h \
+    catalogjournal.h \
+    filelock.h \
+    catalogsaver.h \
+    catalogjson.h \
+    iconrepairqueue.h \
+    searchindex.h \
+    searchsession.h \
+    searchworker.h \
+    fuzzymatcher.h \
+    frecencyindex.h \
+    catalogsnapshot.h \
+    catalogversion.h \
     applauncher.h \
     iconextractor.h \
     addappdialog.h \
     categorymanager.h \
     appdiscovery.h \
+    directoryindex.h \
+    keywordautomaton.h \
+    exclusionmatcher.h \
+    pathtrie.h \
+    excludelist.h \
+    fileidentity.h \
+    categoryclassifier.h \
+    displaynamecleaner.h \
+    directoryscanner.h \
     appdiscoverydialog.h \
     applistmodel.h \
     appicondelegate.h
@@ -1,5 +1,6 @@
 #include "addappdialog.h"
 #include "ui_addappdialog.h"
+#include "displaynamecleaner.h"
 #include <QDebug>
 #include <QApplication>
 #include <QStyle>
@@ -313,11 +314,10 @@ void AddAppDialog::setDefaultAppName()
     }
     
     QFileInfo fileInfo(path);
-    QString baseName = fileInfo.baseName();
     
-    // 名前フィールドが空の場合のみ設定
+    // 名前フィールドが空の場合のみ設定（自動検出と同じ規則で表示名にする）
     if (ui->nameLineEdit->text().trimmed().isEmpty()) {
-        ui->nameLineEdit->setText(baseName);
+        ui->nameLineEdit->setText(DisplayNameCleaner::clean(fileInfo.baseName()));
     }
 }
 
@@ -1,11 +1,22 @@
 #include "appdiscovery.h"
+#include "directoryscanner.h"
+#include "displaynamecleaner.h"
 #include <QDebug>
 #include <QCoreApplication>
 #include <QThread>
 #include <QFileIconProvider>
-#include <QRegularExpression>
 #include <QMimeDatabase>
 #include <QMimeType>
+#include <QSet>
+#include <QStringView>
+
+namespace {
+
+// appsDiscovered で一度に通知する最大件数と、溜めておく最長時間（ms）
+const int DiscoveredBatchSize = 64;
+const int DiscoveredBatchInterval = 100;
+
+}
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -18,9 +29,12 @@
 
 AppDiscovery::AppDiscovery(QObject *parent)
     : QObject(parent)
-    , m_canceled(false)
+    , m_canceled(0)
     , m_currentProgress(0)
     , m_totalProgress(0)
+    , m_indexLoaded(false)
+    , m_mergeLinkedFiles(false)
+    , m_categoryRulesSize(-1)
 {
 }
 
@@ -30,11 +44,14 @@ QList<AppInfo> AppDiscovery::scanFolder(const QString &path, bool recursive)
     ScanOptions options;
     options.maxDepth = recursive ? 5 : 1;
     
+    // 開始通知より前に戻す（通知を受けてからの中止要求を取りこぼさない）
+    m_canceled.storeRelaxed(0);
+    resetDuplicateFilter(options.mergeLinkedFiles);
     emit scanStarted();
-    m_canceled = false;
     
-    scanFolderRecursive(path, results, options, 0);
+    results = scanDirectories(QStringList() << path, options);
     
+    flushDiscovered(true);
     emit scanFinished(results.size());
     return results;
 }
@@ -48,82 +65,184 @@ QList<AppInfo> AppDiscovery::scanFoldersInternal(const QStringList &paths, const
 {
     QList<AppInfo> results;
     
+    // 単独のスキャンとして呼ばれたときだけ、中止要求と重複判定をここで初期化する
+    // （discoverAllApps からは emitSignals == false で呼ばれ、呼び出し元の状態をそのまま使う。
+    //   ここで中止フラグを戻すと、全体スキャン中に出された中止が消えてしまう）
     if (emitSignals) {
+        m_canceled.storeRelaxed(0);
+        resetDuplicateFilter(options.mergeLinkedFiles);
         emit scanStarted();
     }
-    m_canceled = false;
     
-    m_totalProgress = paths.size();
-    m_currentProgress = 0;
-    
-    for (const QString &path : paths) {
-        if (m_canceled) {
-            if (emitSignals) {
-                emit scanCanceled();
-            }
-            return results;
-        }
-        
+    // すべてのパスを1回のスキャンで並行して辿る（ドライブが違えばI/Oも並行する）
+    results = scanDirectories(paths, options);
+    if (m_canceled.loadRelaxed()) {
         if (emitSignals) {
-            emit scanProgress(m_currentProgress, m_totalProgress, path);
+            flushDiscovered(true);
+            emit scanCanceled();
         }
-        scanFolderRecursive(path, results, options, 0);
-        m_currentProgress++;
-        
-        QCoreApplication::processEvents();
+        return results;
     }
     
-    // 重複を除去
-    results = mergeDuplicates(results);
-    
     if (emitSignals) {
+        flushDiscovered(true);
         emit scanFinished(results.size());
     }
     return results;
 }
 
-void AppDiscovery::scanFolderRecursive(const QString &path, QList<AppInfo> &results, 
-                                     const ScanOptions &options, int currentDepth)
+QList<AppInfo> AppDiscovery::scanDirectories(const QStringList &paths, const ScanOptions &options,
+                                             const QString &fallbackCategory)
 {
-    if (m_canceled || currentDepth >= options.maxDepth) {
-        return;
+    // 前回から変わっていないフォルダは列挙を省く
+    if (!m_indexLoaded) {
+        m_directoryIndex.load(getIndexFilePath());
+        m_indexLoaded = true;
     }
+    refreshCategoryRules();
     
-    if (shouldExcludePath(path, options)) {
-        return;
+    // 除外パターン・除外パスはスキャンごとに1回だけ組み立てる
+    const ExclusionMatcher excludeMatcher(options.excludePatterns);
+    PathTrie excludedPaths;
+    for (const QString &excludePath : options.excludePaths) {
+        excludedPaths.insert(excludePath);
+    }
+    
+    DirectoryScanner scanner;
+    scanner.setCancelFlag(&m_canceled);
+    scanner.setNameFilters(QStringList() << "*.exe");
+    scanner.setIndex(&m_directoryIndex);
+    
+    // 以下2つはスキャナーのワーカースレッドから呼ばれる（options と自身の状態は読むだけ）
+    scanner.setDirectoryFilter([this, &excludedPaths](const QString &path) {
+        return shouldExcludePath(path, excludedPaths);
+    });
+    scanner.setFileHandler([this, &excludeMatcher, &excludedPaths, &fallbackCategory](const QFileInfo &fileInfo, AppInfo *app) {
+        if (!isValidExecutable(fileInfo) || shouldExcludeFile(fileInfo, excludeMatcher)
+            || excludedPaths.coversPath(fileInfo.absoluteFilePath())) {
+            return false;
+        }
+        *app = createAppInfoFromFile(fileInfo);
+        if (!fallbackCategory.isEmpty() && app->category == "その他") {
+            app->category = fallbackCategory;
+        }
+        return !app->name.isEmpty();
+    });
+    
+    // 回収と進捗はこのスレッドで一定間隔ごとに行われる
+    // 重複は回収したその場で落とすので、結果にも通知にも最初に見つかった1件だけが残る
+    QList<AppInfo> results;
+    scanner.setResultHandler([this, &results](const QList<AppInfo> &apps) {
+        const QList<AppInfo> uniqueApps = filterDuplicates(apps);
+        results.append(uniqueApps);
+        queueDiscovered(uniqueApps);
+    });
+    scanner.setProgressHandler([this](int scanned, int queued, const QString &currentPath) {
+        m_currentProgress = scanned;
+        m_totalProgress = queued;
+        emit scanProgress(scanned, queued, currentPath);
+        flushDiscovered(false);
+    });
+    
+    scanner.scan(paths, options.maxDepth);
+    if (m_directoryIndex.isDirty()) {
+        m_directoryIndex.save(getIndexFilePath());
+    }
+    return results;
+}
+
+QString AppDiscovery::getIndexFilePath() const
+{
+    // 除外リストと同じくアプリケーション実行ディレクトリ下に置く
+    return QDir(QApplication::applicationDirPath()).filePath("scan_index.bin");
+}
+
+void AppDiscovery::refreshCategoryRules()
+{
+    // スキャンのたびに更新日時だけ確かめ、編集されていれば読み直す（ワーカーが動く前に呼ぶ）
+    const QString filePath = CategoryClassifier::defaultFilePath();
+    QFileInfo fileInfo(filePath);
+    if (!fileInfo.exists()) {
+        // 初回は組み込みの規則を書き出して、編集できるようにする
+        m_categoryClassifier = CategoryClassifier();
+        if (!CategoryClassifier::writeRules(filePath, m_categoryClassifier.rules())) {
+            return;
+        }
+        fileInfo.refresh();
     }
     
-    QDir dir(path);
-    if (!dir.exists()) {
+    if (fileInfo.lastModified() == m_categoryRulesModified && fileInfo.size() == m_categoryRulesSize) {
         return;
     }
+    m_categoryRulesModified = fileInfo.lastModified();
+    m_categoryRulesSize = fileInfo.size();
     
-    // 実行ファイルをスキャン
-    QFileInfoList files = dir.entryInfoList(QStringList() << "*.exe", 
-                                          QDir::Files | QDir::Readable);
-    
-    for (const QFileInfo &fileInfo : files) {
-        if (m_canceled) return;
+    QList<CategoryClassifier::Rule> rules;
+    if (CategoryClassifier::readRules(filePath, &rules)) {
+        m_categoryClassifier = CategoryClassifier(rules);
+        qDebug() << "Loaded" << rules.size() << "category rules from" << filePath;
+    }
+}
+
+void AppDiscovery::resetDuplicateFilter(bool mergeLinkedFiles)
+{
+    m_seenPaths.clear();
+    m_seenFiles.clear();
+    m_mergeLinkedFiles = mergeLinkedFiles;
+}
+
+QList<AppInfo> AppDiscovery::filterDuplicates(const QList<AppInfo> &apps)
+{
+    QList<AppInfo> uniqueApps;
+    for (const AppInfo &app : apps) {
+        const QString normalizedPath = PathTrie::normalize(app.path);
+        if (m_seenPaths.contains(normalizedPath)) {
+            continue;
+        }
+        m_seenPaths.insert(normalizedPath);
         
-        if (isValidExecutable(fileInfo) && !shouldExcludeFile(fileInfo, options)) {
-            AppInfo app = createAppInfoFromFile(fileInfo);
-            if (!app.name.isEmpty()) {
-                results.append(app);
-                emit appDiscovered(app);
+        // 別のパスでも実体が同じなら先に見つかった方を残す（実体が分からないものはパスだけで判定）
+        if (m_mergeLinkedFiles) {
+            FileIdentity identity;
+            if (FileIdentity::of(app.path, &identity)) {
+                if (m_seenFiles.contains(identity)) {
+                    continue;
+                }
+                m_seenFiles.insert(identity);
             }
         }
-        
-        QCoreApplication::processEvents();
+        uniqueApps.append(app);
     }
-    
-    // サブディレクトリを再帰的にスキャン
-    QFileInfoList dirs = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Readable);
-    for (const QFileInfo &dirInfo : dirs) {
-        if (m_canceled) return;
-        
-        scanFolderRecursive(dirInfo.absoluteFilePath(), results, options, currentDepth + 1);
-        QCoreApplication::processEvents();
+    return uniqueApps;
+}
+
+void AppDiscovery::queueDiscovered(const QList<AppInfo> &apps)
+{
+    if (m_pendingApps.isEmpty()) {
+        m_pendingTimer.start();
+    }
+    for (const AppInfo &app : apps) {
+        m_pendingApps.append(app);
+        if (m_pendingApps.size() >= DiscoveredBatchSize) {
+            flushDiscovered(true);
+            m_pendingTimer.start();
+        }
+    }
+    flushDiscovered(false);
+}
+
+void AppDiscovery::flushDiscovered(bool force)
+{
+    if (m_pendingApps.isEmpty()) {
+        return;
     }
+    if (!force && m_pendingTimer.elapsed() < DiscoveredBatchInterval) {
+        return;
+    }
+    
+    QVector<AppInfo> apps;
+    apps.swap(m_pendingApps);
+    emit appsDiscovered(apps);
 }
 
 bool AppDiscovery::isValidExecutable(const QFileInfo &fileInfo)
@@ -140,43 +259,28 @@ bool AppDiscovery::isValidExecutable(const QFileInfo &fileInfo)
     return fileInfo.suffix().toLower() == "exe";
 }
 
-bool AppDiscovery::shouldExcludeFile(const QFileInfo &fileInfo, const ScanOptions &options)
+bool AppDiscovery::shouldExcludeFile(const QFileInfo &fileInfo, const ExclusionMatcher &excludeMatcher)
 {
-    QString fileName = fileInfo.fileName().toLower();
-    
-    for (const QString &pattern : options.excludePatterns) {
-        QRegularExpression regex(QRegularExpression::wildcardToRegularExpression(pattern.toLower()));
-        if (regex.match(fileName).hasMatch()) {
-            return true;
-        }
-    }
-    
-    return false;
+    return excludeMatcher.matches(fileInfo.fileName());
 }
 
-bool AppDiscovery::shouldExcludePath(const QString &path, const ScanOptions &options)
+bool AppDiscovery::shouldExcludePath(const QString &path, const PathTrie &excludedPaths)
 {
-    QString lowerPath = path.toLower();
-    
-    // 一般的な除外パス
-    QStringList commonExcludes = {
+    // 一般的な除外フォルダ（パスのどこかにこの名前のフォルダがあれば除外）
+    static const QSet<QString> commonExcludes = {
         "windows", "system32", "syswow64", "temp", "tmp",
-        "cache", "logs", "recycle", "$recycle.bin"
+        "cache", "logs", "recycler", "$recycle.bin"
     };
     
-    for (const QString &exclude : commonExcludes) {
-        if (lowerPath.contains(exclude)) {
+    const QString normalizedPath = PathTrie::normalize(path);
+    for (QStringView part : QStringView(normalizedPath).tokenize(u'/', Qt::SkipEmptyParts)) {
+        if (commonExcludes.contains(part.toString())) {
             return true;
         }
     }
     
-    for (const QString &excludePath : options.excludePaths) {
-        if (lowerPath.startsWith(excludePath.toLower())) {
-            return true;
-        }
-    }
-    
-    return false;
+    // ユーザーが除外したフォルダとその下
+    return excludedPaths.coversPath(normalizedPath);
 }
 
 AppInfo AppDiscovery::createAppInfoFromFile(const QFileInfo &fileInfo)
@@ -197,27 +301,8 @@ AppInfo AppDiscovery::createAppInfoFromFile(const QFileInfo &fileInfo)
 
 QString AppDiscovery::extractDisplayName(const QFileInfo &fileInfo)
 {
-    QString baseName = fileInfo.baseName();
-    
-    // 一般的な接尾語を除去
-    QStringList suffixesToRemove = {
-        "launcher", "game", "client", "setup", "install", 
-        "x64", "x86", "win32", "win64", "32bit", "64bit"
-    };
-    
-    QString cleanName = baseName;
-    for (const QString &suffix : suffixesToRemove) {
-        QRegularExpression regex("\\b" + suffix + "\\b", QRegularExpression::CaseInsensitiveOption);
-        cleanName.replace(regex, "");
-    }
-    
-    // 余分な空白を除去し、最初の文字を大文字に
-    cleanName = cleanName.trimmed();
-    if (!cleanName.isEmpty()) {
-        cleanName[0] = cleanName[0].toUpper();
-    }
-    
-    return cleanName.isEmpty() ? baseName : cleanName;
+    // 一般的な接尾語（launcher, x64 など）を除去する
+    return DisplayNameCleaner::clean(fileInfo.baseName());
 }
 
 QString AppDiscovery::detectCategory(const QFileInfo &fileInfo)
@@ -230,85 +315,17 @@ QString AppDiscovery::detectCategory(const QFileInfo &fileInfo)
 
 QString AppDiscovery::guessCategory(const QString &name, const QString &path)
 {
-    // ゲーム関連キーワード
-    for (const QString &keyword : getGameKeywords()) {
-        if (name.contains(keyword) || path.contains(keyword)) {
-            return "ゲーム";
-        }
-    }
-    
-    // 開発関連キーワード
-    for (const QString &keyword : getDevelopmentKeywords()) {
-        if (name.contains(keyword) || path.contains(keyword)) {
-            return "開発";
-        }
-    }
-    
-    // ビジネス関連キーワード
-    for (const QString &keyword : getBusinessKeywords()) {
-        if (name.contains(keyword) || path.contains(keyword)) {
-            return "ビジネス";
-        }
-    }
-    
-    // メディア関連キーワード
-    for (const QString &keyword : getMediaKeywords()) {
-        if (name.contains(keyword) || path.contains(keyword)) {
-            return "メディア";
-        }
-    }
-    
-    // ツール関連キーワード
-    for (const QString &keyword : getToolKeywords()) {
-        if (name.contains(keyword) || path.contains(keyword)) {
-            return "ツール";
-        }
-    }
-    
-    return "その他";
-}
-
-QStringList AppDiscovery::getGameKeywords()
-{
-    return QStringList() << "game" << "steam" << "epic" << "gog" << "origin"
-                        << "uplay" << "battle.net" << "minecraft" << "unity"
-                        << "unreal" << "fps" << "rpg" << "mmo" << "arcade";
-}
-
-QStringList AppDiscovery::getDevelopmentKeywords()
-{
-    return QStringList() << "visual studio" << "code" << "dev" << "git"
-                        << "python" << "java" << "node" << "npm" << "compiler"
-                        << "debugger" << "ide" << "editor" << "qt" << "android studio";
-}
-
-QStringList AppDiscovery::getBusinessKeywords()
-{
-    return QStringList() << "office" << "word" << "excel" << "powerpoint"
-                        << "outlook" << "teams" << "zoom" << "skype" << "slack"
-                        << "adobe" << "acrobat" << "reader" << "calculator";
-}
-
-QStringList AppDiscovery::getMediaKeywords()
-{
-    return QStringList() << "vlc" << "media" << "player" << "music" << "video"
-                        << "photo" << "image" << "audio" << "spotify" << "iTunes"
-                        << "photoshop" << "premiere" << "audacity" << "gimp";
-}
-
-QStringList AppDiscovery::getToolKeywords()
-{
-    return QStringList() << "tool" << "utility" << "manager" << "browser"
-                        << "chrome" << "firefox" << "explorer" << "notepad"
-                        << "archive" << "zip" << "rar" << "antivirus" << "clean";
+    return m_categoryClassifier.classify(name, path);
 }
 
 QList<AppInfo> AppDiscovery::discoverAllApps(const ScanOptions &options)
 {
     QList<AppInfo> allApps;
     
+    // 開始通知より前に戻す（通知を受けてからの中止要求を取りこぼさない）
+    m_canceled.storeRelaxed(0);
+    resetDuplicateFilter(options.mergeLinkedFiles);
     emit scanStarted();
-    m_canceled = false;
     
     // オプションに基づいてスキャンパスを構築
     QStringList paths;
@@ -335,7 +352,8 @@ QList<AppInfo> AppDiscovery::discoverAllApps(const ScanOptions &options)
         QList<AppInfo> folderApps = scanFoldersInternal(paths, options, false);
         allApps.append(folderApps);
 
-        if (m_canceled) {
+        if (m_canceled.loadRelaxed()) {
+            flushDiscovered(true);
             emit scanCanceled();
             return allApps;
         }
@@ -343,11 +361,14 @@ QList<AppInfo> AppDiscovery::discoverAllApps(const ScanOptions &options)
     
     // ショートカットをスキャン
     if (options.scanDesktop || options.scanStartMenu) {
-        QList<AppInfo> shortcutApps = discoverShortcuts();
+        QList<AppInfo> shortcutApps = filterDuplicates(discoverShortcuts());
         allApps.append(shortcutApps);
+        // フォルダ・Steam（scanDirectories 内で通知）と同じく、見つけた分を appsDiscovered で流す
+        queueDiscovered(shortcutApps);
     }
     
-    if (m_canceled) {
+    if (m_canceled.loadRelaxed()) {
+        flushDiscovered(true);
         emit scanCanceled();
         return allApps;
     }
@@ -358,10 +379,8 @@ QList<AppInfo> AppDiscovery::discoverAllApps(const ScanOptions &options)
         allApps.append(steamApps);
     }
     
-    // 重複を除去
-    allApps = mergeDuplicates(allApps);
-
     // スキャン完了シグナルを一度だけ発行
+    flushDiscovered(true);
     emit scanFinished(allApps.size());
     return allApps;
 }
@@ -387,15 +406,16 @@ QStringList AppDiscovery::getDefaultScanPaths()
 
 QList<AppInfo> AppDiscovery::mergeDuplicates(const QList<AppInfo> &apps)
 {
+    // スキャン中の重複除去とは別に、任意のリストをパスだけでまとめる
     QList<AppInfo> uniqueApps;
-    QStringList seenPaths;
+    QSet<QString> seenPaths;
+    seenPaths.reserve(apps.size());
     
     for (const AppInfo &app : apps) {
-        QString normalizedPath = QDir::fromNativeSeparators(app.path.toLower());
-        
+        const QString normalizedPath = PathTrie::normalize(app.path);
         if (!seenPaths.contains(normalizedPath)) {
             uniqueApps.append(app);
-            seenPaths.append(normalizedPath);
+            seenPaths.insert(normalizedPath);
         }
     }
     
@@ -404,7 +424,7 @@ QList<AppInfo> AppDiscovery::mergeDuplicates(const QList<AppInfo> &apps)
 
 void AppDiscovery::cancelScan()
 {
-    m_canceled = true;
+    m_canceled.storeRelaxed(1);
     qDebug() << "Scan canceled by user";
 }
 
@@ -426,25 +446,16 @@ QList<AppInfo> AppDiscovery::discoverSteamGames()
     QDir commonDir(commonPath);
     
     if (commonDir.exists()) {
-        QFileInfoList gameDirs = commonDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
-
+        QStringList gamePaths;
+        const QFileInfoList gameDirs = commonDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
         for (const QFileInfo &gameDir : gameDirs) {
-            if (m_canceled) return steamApps;
-
-            ScanOptions options;
-            options.maxDepth = 2;
-
-            // シグナルを発行しないように直接scanFolderRecursiveを使用
-            QList<AppInfo> gameApps;
-            scanFolderRecursive(gameDir.absoluteFilePath(), gameApps, options, 0);
-
-            for (AppInfo &app : gameApps) {
-                if (app.category == "その他") {
-                    app.category = "ゲーム";
-                }
-            }
-            steamApps.append(gameApps);
+            gamePaths.append(gameDir.absoluteFilePath());
         }
+
+        // ゲームフォルダごとに2階層まで、まとめて並行にスキャン
+        ScanOptions options;
+        options.maxDepth = 2;
+        steamApps = scanDirectories(gamePaths, options, "ゲーム");
     }
     
     return steamApps;
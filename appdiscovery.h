@@ -11,7 +11,16 @@
 #include <QStandardPaths>
 #include <QProgressDialog>
 #include <QApplication>
+#include <QAtomicInt>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QSet>
 #include "appinfo.h"
+#include "directoryindex.h"
+#include "exclusionmatcher.h"
+#include "pathtrie.h"
+#include "fileidentity.h"
+#include "categoryclassifier.h"
 
 struct ScanOptions {
     QStringList includePaths;
@@ -22,6 +31,7 @@ struct ScanOptions {
     bool scanStartMenu;
     bool scanProgramFiles;
     bool scanSteam;
+    bool mergeLinkedFiles;      // シンボリックリンク・ハードリンクで同じ実体を指すものを1つにまとめる
     
     ScanOptions() 
         : maxDepth(5)
@@ -29,6 +39,7 @@ struct ScanOptions {
         , scanStartMenu(true)
         , scanProgramFiles(true)
         , scanSteam(true)
+        , mergeLinkedFiles(false)
     {
         // デフォルトの除外パターン
         excludePatterns << "*unins*.exe" << "*uninst*.exe" << "*uninstall*.exe"
@@ -38,6 +49,8 @@ struct ScanOptions {
     }
 };
 
+// スキャンはワーカースレッド上で実行する想定（AppDiscoveryDialog は専用の QThread に移して使う）
+// 見つかったアプリは件数と時間で区切ったまとまりごとに appsDiscovered で通知する。
 class AppDiscovery : public QObject
 {
     Q_OBJECT
@@ -78,26 +91,42 @@ public:
     QStringList getProgramFilesPaths();
     
 public slots:
-    void cancelScan();
+    void cancelScan();      // 任意のスレッドから直接呼べる
 
 signals:
     void scanProgress(int current, int total, const QString &currentPath);
-    void appDiscovered(const AppInfo &app);
+    void appsDiscovered(const QVector<AppInfo> &apps);
     void scanStarted();
     void scanFinished(int totalFound);
     void scanCanceled();
 
 private:
-    bool m_canceled;
+    QAtomicInt m_canceled;      // スキャナーのワーカースレッドからも参照する
     int m_currentProgress;
     int m_totalProgress;
+    QVector<AppInfo> m_pendingApps;     // まだ通知していない発見済みアプリ
+    QElapsedTimer m_pendingTimer;
+    DirectoryIndex m_directoryIndex;    // 前回スキャンしたフォルダの内容（最初のスキャン時に読み込む）
+    bool m_indexLoaded;
+    QSet<QString> m_seenPaths;          // このスキャンで通知済みのパス（正規化済み）
+    QSet<FileIdentity> m_seenFiles;     // 同じく実体（mergeLinkedFiles のときだけ使う）
+    bool m_mergeLinkedFiles;
+    CategoryClassifier m_categoryClassifier;    // スキャン中は書き換えない（ワーカーから読む）
+    QDateTime m_categoryRulesModified;          // 読み込んだ category_rules.json の更新日時とサイズ
+    qint64 m_categoryRulesSize;
     
     // 内部ヘルパー関数
     QList<AppInfo> scanFoldersInternal(const QStringList &paths, const ScanOptions &options, bool emitSignals);
-    void scanFolderRecursive(const QString &path, QList<AppInfo> &results, 
-                           const ScanOptions &options, int currentDepth = 0);
-    bool shouldExcludeFile(const QFileInfo &fileInfo, const ScanOptions &options);
-    bool shouldExcludePath(const QString &path, const ScanOptions &options);
+    QList<AppInfo> scanDirectories(const QStringList &paths, const ScanOptions &options,
+                                   const QString &fallbackCategory = QString());
+    QString getIndexFilePath() const;
+    void refreshCategoryRules();
+    void resetDuplicateFilter(bool mergeLinkedFiles);
+    QList<AppInfo> filterDuplicates(const QList<AppInfo> &apps);
+    void queueDiscovered(const QList<AppInfo> &apps);
+    void flushDiscovered(bool force);
+    bool shouldExcludeFile(const QFileInfo &fileInfo, const ExclusionMatcher &excludeMatcher);
+    bool shouldExcludePath(const QString &path, const PathTrie &excludedPaths);
     AppInfo createAppInfoFromFile(const QFileInfo &fileInfo);
     AppInfo createAppInfoFromShortcut(const QString &shortcutPath);
     QString resolveShortcutTarget(const QString &shortcutPath);
@@ -112,11 +141,6 @@ private:
     
     // カテゴリ判定
     QString guessCategory(const QString &name, const QString &path);
-    QStringList getGameKeywords();
-    QStringList getBusinessKeywords();
-    QStringList getToolKeywords();
-    QStringList getMediaKeywords();
-    QStringList getDevelopmentKeywords();
 };
 
 #endif // APPDISCOVERY_H
\ No newline at end of file
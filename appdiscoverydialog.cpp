@@ -1,6 +1,7 @@
 #include "appdiscoverydialog.h"
 #include "ui_appdiscoverydialog.h"
 #include "iconextractor.h"
+#include "filelock.h"
 #include <QDebug>
 #include <QLabel>
 #include <QApplication>
@@ -12,24 +13,31 @@
 #include <QTextStream>
 #include <QStandardPaths>
 #include <QInputDialog>
-#include <QRegularExpression>
 #include <algorithm>
 
 AppDiscoveryDialog::AppDiscoveryDialog(AppManager *appManager, QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::AppDiscoveryDialog)
     , m_appManager(appManager)
-    , m_appDiscovery(new AppDiscovery(this))
+    , m_appDiscovery(new AppDiscovery)
     , m_scanInProgress(false)
+    , m_stopRequested(false)
+    , m_patternMatcherDirty(true)
 {
     ui->setupUi(this);
     setupUI();
     
-    // AppDiscoveryのシグナル接続
+    // 検索はワーカースレッドで行い、ダイアログはまとめて届く結果を表示するだけにする
+    m_appDiscovery->moveToThread(&m_scanThread);
+    connect(&m_scanThread, &QThread::finished, m_appDiscovery, &QObject::deleteLater);
+    m_scanThread.setObjectName("AppDiscovery");
+    m_scanThread.start();
+    
+    // AppDiscoveryのシグナル接続（キュー接続）
     connect(m_appDiscovery, &AppDiscovery::scanProgress, 
             this, &AppDiscoveryDialog::onScanProgress);
-    connect(m_appDiscovery, &AppDiscovery::appDiscovered, 
-            this, &AppDiscoveryDialog::onAppDiscovered);
+    connect(m_appDiscovery, &AppDiscovery::appsDiscovered, 
+            this, &AppDiscoveryDialog::onAppsDiscovered);
     connect(m_appDiscovery, &AppDiscovery::scanStarted, 
             this, &AppDiscoveryDialog::onScanStarted);
     connect(m_appDiscovery, &AppDiscovery::scanFinished, 
@@ -40,6 +48,10 @@ AppDiscoveryDialog::AppDiscoveryDialog(AppManager *appManager, QWidget *parent)
 
 AppDiscoveryDialog::~AppDiscoveryDialog()
 {
+    // 実行中の検索を止めてからスレッドを終了する
+    m_appDiscovery->cancelScan();
+    m_scanThread.quit();
+    m_scanThread.wait();
     delete ui;
 }
 
@@ -78,6 +90,9 @@ void AppDiscoveryDialog::setupUI()
     connect(ui->addToExcludeButton, &QPushButton::clicked, this, &AppDiscoveryDialog::addToExcludeList);
     connect(ui->addPatternButton, &QPushButton::clicked, this, &AppDiscoveryDialog::addExcludePattern);
     connect(ui->clearPatternsButton, &QPushButton::clicked, this, &AppDiscoveryDialog::clearExcludePatterns);
+    connect(ui->excludePatternsTextEdit, &QTextEdit::textChanged, this, [this]() {
+        m_patternMatcherDirty = true;
+    });
     connect(ui->addSelectedButton, &QPushButton::clicked, this, &AppDiscoveryDialog::addSelectedApps);
     
     connect(ui->resultsTable, &QTableWidget::itemSelectionChanged, 
@@ -110,13 +125,15 @@ void AppDiscoveryDialog::startScan()
     // UIの状態を更新
     setUIEnabled(false);
     m_scanInProgress = true;
+    m_stopRequested = false;
     ui->tabWidget->setTabEnabled(1, true);
     ui->tabWidget->setCurrentIndex(1); // 結果タブに切り替え
     
-    // 検索を開始
-    QTimer::singleShot(100, [this, options]() {
-        m_appDiscovery->discoverAllApps(options);
-    });
+    // 検索を開始（ワーカースレッドで実行）
+    AppDiscovery *discovery = m_appDiscovery;
+    QMetaObject::invokeMethod(m_appDiscovery, [discovery, options]() {
+        discovery->discoverAllApps(options);
+    }, Qt::QueuedConnection);
 }
 
 void AppDiscoveryDialog::stopScan()
@@ -125,6 +142,8 @@ void AppDiscoveryDialog::stopScan()
         return;
     }
     
+    // 検索スレッドはスキャン中でイベントを処理しないので直接呼ぶ
+    m_stopRequested = true;
     m_appDiscovery->cancelScan();
 }
 
@@ -241,31 +260,47 @@ void AppDiscoveryDialog::onScanProgress(int current, int total, const QString &c
     ui->statusLabel->setText(QString("検索中: %1").arg(QFileInfo(currentPath).fileName()));
 }
 
-void AppDiscoveryDialog::onAppDiscovered(const AppInfo &app)
+void AppDiscoveryDialog::onAppsDiscovered(const QVector<AppInfo> &apps)
 {
     // 除外リストとパターンに含まれているかチェック
-    if (!isAppExcluded(app) && !isAppExcludedByPattern(app)) {
-        // アイコン処理のためにコピーを作成
-        AppInfo appCopy = app;
-        addAppToResults(appCopy);
-        m_discoveredApps.append(appCopy);
-        updateSelectedCount();
-        qDebug() << "App discovered and added:" << app.name << "at" << app.path;
-    } else {
-        qDebug() << "App discovered but excluded:" << app.name << "at" << app.path;
+    QList<AppInfo> accepted;
+    for (const AppInfo &app : apps) {
+        if (!isAppExcluded(app) && !isAppExcludedByPattern(app)) {
+            accepted.append(app);
+        } else {
+            qDebug() << "App discovered but excluded:" << app.name << "at" << app.path;
+        }
     }
+    if (accepted.isEmpty()) {
+        return;
+    }
+    
+    // まとめて行を追加し、再描画は最後に1回だけ行う
+    ui->resultsTable->setUpdatesEnabled(false);
+    int row = ui->resultsTable->rowCount();
+    ui->resultsTable->setRowCount(row + accepted.size());
+    for (AppInfo &app : accepted) {
+        // アイコン処理でiconPathが設定される
+        addAppToResults(row++, app);
+        m_discoveredApps.append(app);
+    }
+    ui->resultsTable->setUpdatesEnabled(true);
+    
+    updateSelectedCount();
+    qDebug() << "Added" << accepted.size() << "discovered apps to results";
 }
 
 void AppDiscoveryDialog::onScanStarted()
 {
+    // 検索スレッドが開始する前に中止された場合
+    if (m_stopRequested) {
+        m_appDiscovery->cancelScan();
+    }
+    
     ui->statusLabel->setText("検索を開始しています...");
     ui->progressBar->setValue(0);
     
-    // テキストエリアからパターン数を取得
-    QString patterns = ui->excludePatternsTextEdit->toPlainText();
-    QStringList patternList = patterns.split('\n', Qt::SkipEmptyParts);
-    
-    qDebug() << "Scan started. Exclude list contains" << m_excludeList.size() << "entries, patterns:" << patternList.size();
+    qDebug() << "Scan started. Exclude list contains" << m_excludeList.size() << "entries, patterns:" << patternMatcher().patterns().size();
 }
 
 void AppDiscoveryDialog::onScanFinished(int totalFound)
@@ -328,11 +363,8 @@ void AppDiscoveryDialog::previewApp(int row, int column)
     QMessageBox::information(this, "アプリケーション情報", info);
 }
 
-void AppDiscoveryDialog::addAppToResults(AppInfo &app)
+void AppDiscoveryDialog::addAppToResults(int row, AppInfo &app)
 {
-    int row = ui->resultsTable->rowCount();
-    ui->resultsTable->insertRow(row);
-    
     // チェックボックス
     QCheckBox *checkBox = new QCheckBox();
     checkBox->setChecked(true);
@@ -501,6 +533,7 @@ ScanOptions AppDiscoveryDialog::getCurrentScanOptions()
     options.scanProgramFiles = true;
     options.scanSteam = true;
     options.maxDepth = ui->maxDepthSpinBox->value();
+    options.mergeLinkedFiles = true;    // リンク経由の同じ実行ファイルを一覧に重ねて出さない
     
     // 追加パス（複数）
     for (int i = 0; i < ui->customPathsListWidget->count(); ++i) {
@@ -510,15 +543,11 @@ ScanOptions AppDiscoveryDialog::getCurrentScanOptions()
         }
     }
     
+    // 除外フォルダ（登録したフォルダの下は辿らない）
+    options.excludePaths = m_excludeList.paths();
+    
     // 除外パターン
-    QString patterns = ui->excludePatternsTextEdit->toPlainText();
-    QStringList patternList = patterns.split('\n', Qt::SkipEmptyParts);
-    for (QString &pattern : patternList) {
-        pattern = pattern.trimmed();
-        if (!pattern.isEmpty()) {
-            options.excludePatterns << pattern;
-        }
-    }
+    options.excludePatterns << ExclusionMatcher::parsePatterns(ui->excludePatternsTextEdit->toPlainText());
     
     return options;
 }
@@ -570,21 +599,19 @@ void AppDiscoveryDialog::addToExcludeList()
         return;
     }
     
-    int addedCount = 0;
-    
+    QStringList paths;
     for (const AppInfo &app : selectedApps) {
-        // パスを除外リストに追加
-        QString normalizedPath = QDir::fromNativeSeparators(app.path.toLower());
-        if (!m_excludeList.contains(normalizedPath)) {
-            m_excludeList.append(normalizedPath);
-            addedCount++;
-        }
+        paths.append(app.path);
+    }
+    
+    // 除外リストのファイルに追記する
+    int addedCount = m_excludeList.add(paths);
+    if (addedCount < 0) {
+        QMessageBox::warning(this, "エラー", "除外リストを保存できませんでした。");
+        return;
     }
     
     if (addedCount > 0) {
-        // 除外リストを保存
-        saveExcludeList();
-        
         // 選択されたアプリを結果から除去
         removeSelectedFromResults();
         
@@ -600,21 +627,9 @@ void AppDiscoveryDialog::loadExcludeList()
     QString appDir = QApplication::applicationDirPath();
     
     // 除外パスリストの読み込み
-    QString excludeFilePath = QDir(appDir).filePath("exclude_list.txt");
-    QFile file(excludeFilePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qDebug() << "Exclude list file not found, starting with empty list:" << excludeFilePath;
+    if (!m_excludeList.load()) {
+        qDebug() << "Exclude list file not found, starting with empty list:" << ExcludeList::defaultFilePath();
     } else {
-        QTextStream in(&file);
-        m_excludeList.clear();
-        
-        while (!in.atEnd()) {
-            QString line = in.readLine().trimmed();
-            if (!line.isEmpty()) {
-                m_excludeList.append(line);
-            }
-        }
-        file.close();
         qDebug() << "Loaded exclude list with" << m_excludeList.size() << "entries";
     }
     
@@ -652,30 +667,10 @@ void AppDiscoveryDialog::loadExcludeList()
     qDebug() << "Loaded exclude patterns with" << m_excludePatterns.size() << "entries";
 }
 
-void AppDiscoveryDialog::saveExcludeList()
-{
-    QString appDir = QApplication::applicationDirPath();
-    QString excludeFilePath = QDir(appDir).filePath("exclude_list.txt");
-    
-    QFile file(excludeFilePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qWarning() << "Cannot open exclude list file for writing:" << excludeFilePath;
-        return;
-    }
-    
-    QTextStream out(&file);
-    for (const QString &path : m_excludeList) {
-        out << path << "\n";
-    }
-    
-    file.close();
-    qDebug() << "Saved exclude list with" << m_excludeList.size() << "entries";
-}
-
 bool AppDiscoveryDialog::isAppExcluded(const AppInfo &app)
 {
-    QString normalizedPath = QDir::fromNativeSeparators(app.path.toLower());
-    return m_excludeList.contains(normalizedPath);
+    // 登録したパス自身か、その上位フォルダが登録されていれば除外
+    return m_excludeList.isExcluded(app.path);
 }
 
 void AppDiscoveryDialog::removeSelectedFromResults()
@@ -748,30 +743,25 @@ void AppDiscoveryDialog::addExcludePattern()
 
 bool AppDiscoveryDialog::isAppExcludedByPattern(const AppInfo &app)
 {
-    QString appName = app.name.toLower();
-    QString appPath = app.path.toLower();
-    QString fileName = QFileInfo(app.path).fileName().toLower();
-    
-    // テキストエリアから現在のパターンを読み込み
-    QString patterns = ui->excludePatternsTextEdit->toPlainText();
-    QStringList patternList = patterns.split('\n', Qt::SkipEmptyParts);
-    
-    for (QString pattern : patternList) {
-        pattern = pattern.trimmed().toLower();
-        if (pattern.isEmpty()) continue;
-        
-        // QRegularExpressionを使用してワイルドカードパターンをチェック
-        QRegularExpression regex(QRegularExpression::wildcardToRegularExpression(pattern));
-        
-        // アプリ名、ファイル名、パスのいずれかがパターンにマッチするかチェック
-        if (regex.match(appName).hasMatch() || 
-            regex.match(fileName).hasMatch() || 
-            regex.match(appPath).hasMatch()) {
-            return true;
-        }
+    const ExclusionMatcher &matcher = patternMatcher();
+    if (matcher.isEmpty()) {
+        return false;
     }
     
-    return false;
+    // アプリ名、ファイル名、パスのいずれかがパターンにマッチするかチェック
+    return matcher.matches(app.name)
+        || matcher.matches(QFileInfo(app.path).fileName())
+        || matcher.matches(app.path);
+}
+
+const ExclusionMatcher &AppDiscoveryDialog::patternMatcher()
+{
+    // テキストエリアが編集された後、最初に使うときにコンパイルし直す
+    if (m_patternMatcherDirty) {
+        m_patternMatcher.setPatterns(ExclusionMatcher::parsePatterns(ui->excludePatternsTextEdit->toPlainText()));
+        m_patternMatcherDirty = false;
+    }
+    return m_patternMatcher;
 }
 
 void AppDiscoveryDialog::addPatternToExcludeFile(const QString &pattern)
@@ -779,6 +769,12 @@ void AppDiscoveryDialog::addPatternToExcludeFile(const QString &pattern)
     QString appDir = QApplication::applicationDirPath();
     QString patternFilePath = QDir(appDir).filePath("exclude_patterns.txt");
     
+    FileLock lock(patternFilePath);
+    if (!lock.isLocked()) {
+        qWarning() << "Exclude pattern file is locked by another process:" << patternFilePath;
+        return;
+    }
+    
     QFile file(patternFilePath);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
         qWarning() << "Cannot open exclude pattern file for writing:" << patternFilePath;
@@ -800,21 +796,15 @@ QStringList AppDiscoveryDialog::getExcludePatterns()
 void AppDiscoveryDialog::removeAppsMatchingPattern(const QString &pattern)
 {
     QList<int> rowsToRemove;
+    const ExclusionMatcher matcher(QStringList() << pattern);
     
     for (int row = 0; row < ui->resultsTable->rowCount(); ++row) {
         if (row < m_discoveredApps.size()) {
             const AppInfo &app = m_discoveredApps[row];
             
-            QString appName = app.name.toLower();
-            QString appPath = app.path.toLower();
-            QString fileName = QFileInfo(app.path).fileName().toLower();
-            QString lowerPattern = pattern.toLower();
-            
-            QRegularExpression regex(QRegularExpression::wildcardToRegularExpression(lowerPattern));
-            
-            if (regex.match(appName).hasMatch() || 
-                regex.match(fileName).hasMatch() || 
-                regex.match(appPath).hasMatch()) {
+            if (matcher.matches(app.name) || 
+                matcher.matches(QFileInfo(app.path).fileName()) || 
+                matcher.matches(app.path)) {
                 rowsToRemove.append(row);
             }
         }
@@ -862,8 +852,9 @@ void AppDiscoveryDialog::clearExcludePatterns()
         // ファイルもクリア
         QString appDir = QApplication::applicationDirPath();
         QString patternFilePath = QDir(appDir).filePath("exclude_patterns.txt");
+        FileLock lock(patternFilePath);
         QFile file(patternFilePath);
-        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (lock.isLocked() && file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
             file.close();
         }
         
@@ -9,9 +9,13 @@
 #include <QMessageBox>
 #include <QTimer>
 #include <QCheckBox>
+#include <QThread>
+#include <QVector>
 
 #include "appdiscovery.h"
 #include "appmanager.h"
+#include "exclusionmatcher.h"
+#include "excludelist.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -40,7 +44,7 @@ private slots:
     void addExcludePattern();
     void clearExcludePatterns();
     void onScanProgress(int current, int total, const QString &currentPath);
-    void onAppDiscovered(const AppInfo &app);
+    void onAppsDiscovered(const QVector<AppInfo> &apps);
     void onScanStarted();
     void onScanFinished(int totalFound);
     void onScanCanceled();
@@ -50,17 +54,17 @@ private slots:
 private:
     void setupUI();
     void updateSelectedCount();
-    void addAppToResults(AppInfo &app);
+    void addAppToResults(int row, AppInfo &app);
     ScanOptions getCurrentScanOptions();
     QList<AppInfo> getSelectedApps();
     void setUIEnabled(bool enabled);
     void loadExcludeList();
-    void saveExcludeList();
     bool isAppExcluded(const AppInfo &app);
     void removeSelectedFromResults();
     bool isAppExcludedByPattern(const AppInfo &app);
     void addPatternToExcludeFile(const QString &pattern);
     QStringList getExcludePatterns();
+    const ExclusionMatcher &patternMatcher();
     void removeAppsMatchingPattern(const QString &pattern);
     void updatePathButtonStates();
 
@@ -68,13 +72,17 @@ private:
     
     // Data
     AppManager *m_appManager;
-    AppDiscovery *m_appDiscovery;
+    QThread m_scanThread;
+    AppDiscovery *m_appDiscovery;   // m_scanThread 上で動作する
     QList<AppInfo> m_discoveredApps;
     bool m_scanInProgress;
+    bool m_stopRequested;
     QHash<QString, QPixmap> m_iconCache;  // アイコンキャッシュ
     QHash<QString, QPixmap> m_iconCacheForPath;  // パスベースのアイコンキャッシュ
-    QStringList m_excludeList;  // 除外リスト（パス）
+    ExcludeList m_excludeList;  // 除外リスト（パス）
     QStringList m_excludePatterns;  // 除外パターン（ワイルドカード）
+    ExclusionMatcher m_patternMatcher;  // テキストエリアのパターンをコンパイルしたもの
+    bool m_patternMatcherDirty;
     
     // Constants
     enum ColumnIndex {
@@ -85,14 +85,6 @@ void AppInfo::updateLaunchInfo()
 {
     lastLaunch = QDateTime::currentDateTime();
     launchCount++;
-    clearDisplayCache();  // キャッシュをクリア
-}
-
-void AppInfo::clearDisplayCache() const
-{
-    cachedLastLaunchStr.clear();
-    cachedLastLaunchTime = QDateTime();
-    cachedLaunchCountStr.clear();
 }
 
 bool AppInfo::fileExists() const
@@ -24,14 +24,6 @@ public:
     QDateTime createdAt;    // 作成日時
     QString category;       // カテゴリ名
 
-    // 表示用キャッシュ（mutable: constメソッドから変更可能）
-    mutable QString cachedLastLaunchStr;
-    mutable QDateTime cachedLastLaunchTime;  // キャッシュ生成時刻
-    mutable QString cachedLaunchCountStr;
-
-    // キャッシュをクリア
-    void clearDisplayCache() const;
-
     // JSON変換
     QJsonObject toJson() const;
     void fromJson(const QJsonObject &json);
@@ -47,4 +39,6 @@ public:
     bool fileExists() const;
 };
 
+Q_DECLARE_METATYPE(AppInfo)
+
 #endif // APPINFO_H
\ No newline at end of file
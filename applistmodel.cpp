@@ -1,5 +1,6 @@
 #include "applistmodel.h"
 #include <QDateTime>
+#include <QSet>
 #include <QDebug>
 
 AppListModel::AppListModel(QObject *parent)
@@ -7,6 +8,8 @@ AppListModel::AppListModel(QObject *parent)
     , m_iconCache(nullptr)
     , m_currentPage(0)
     , m_itemsPerPage(50)
+    , m_visibleLimit(-1)
+    , m_positionsValid(false)
 {
 }
 
@@ -20,9 +23,13 @@ int AppListModel::rowCount(const QModelIndex &parent) const
 
     // ページング: 現在のページに表示する行数を返す
     int startIndex = m_currentPage * m_itemsPerPage;
-    int remaining = m_apps.size() - startIndex;
+    int remaining = m_rows.size() - startIndex;
     if (remaining <= 0) return 0;
-    return qMin(remaining, m_itemsPerPage);
+    int count = qMin(remaining, m_itemsPerPage);
+    if (m_visibleLimit >= 0) {
+        count = qMin(count, m_visibleLimit);
+    }
+    return count;
 }
 
 int AppListModel::columnCount(const QModelIndex &parent) const
@@ -36,44 +43,63 @@ int AppListModel::actualIndex(int row) const
     return m_currentPage * m_itemsPerPage + row;
 }
 
+AppStore::Row AppListModel::appAt(int actual) const
+{
+    return m_store.row(m_rows.at(actual));
+}
+
+int AppListModel::findActual(const QString &appId) const
+{
+    if (!m_positionsValid) {
+        rebuildPositions();
+    }
+    int actual = m_positions.value(appId, -1);
+    if (actual < 0) {
+        return -1;
+    }
+
+    // 並びを変えずにストアだけ差し替えた更新でIDが変わっていれば作り直す
+    if (actual >= m_rows.size() || m_store.id(m_rows.at(actual)) != appId) {
+        rebuildPositions();
+        actual = m_positions.value(appId, -1);
+    }
+    return actual;
+}
+
+void AppListModel::rebuildPositions() const
+{
+    m_positions.clear();
+    m_positions.reserve(m_rows.size());
+    for (int i = 0; i < m_rows.size(); ++i) {
+        m_positions.insert(m_store.id(m_rows.at(i)), i);
+    }
+    m_positionsValid = true;
+}
+
+void AppListModel::invalidatePositions()
+{
+    m_positionsValid = false;
+}
+
 QVariant AppListModel::data(const QModelIndex &index, int role) const
 {
     if (!index.isValid())
         return QVariant();
 
     int actual = actualIndex(index.row());
-    if (actual < 0 || actual >= m_apps.size())
+    if (actual < 0 || actual >= m_rows.size() || m_rows.at(actual) < 0)
         return QVariant();
 
-    const AppInfo &app = m_apps.at(actual);
+    // 表示に必要な列だけをストアから読む（整形は表示中の1ページ分だけなので都度行う）
+    const AppStore::Row app = appAt(actual);
 
     switch (role) {
     case Qt::DisplayRole:
         switch (index.column()) {
-        case ColumnName:       return app.name;
-        case ColumnPath:       return app.path;
-        case ColumnLastLaunch: {
-            // キャッシュが有効かチェック（10秒以内なら再利用）
-            QDateTime now = QDateTime::currentDateTime();
-            if (!app.cachedLastLaunchStr.isEmpty() &&
-                app.cachedLastLaunchTime.isValid() &&
-                app.cachedLastLaunchTime.secsTo(now) < 10) {
-                return app.cachedLastLaunchStr;
-            }
-            // キャッシュを更新
-            app.cachedLastLaunchStr = formatLastLaunch(app.lastLaunch);
-            app.cachedLastLaunchTime = now;
-            return app.cachedLastLaunchStr;
-        }
-        case ColumnLaunchCount: {
-            // キャッシュが有効かチェック
-            if (!app.cachedLaunchCountStr.isEmpty()) {
-                return app.cachedLaunchCountStr;
-            }
-            // キャッシュを更新
-            app.cachedLaunchCountStr = formatLaunchCount(app.launchCount);
-            return app.cachedLaunchCountStr;
-        }
+        case ColumnName:        return app.name();
+        case ColumnPath:        return app.path();
+        case ColumnLastLaunch:  return formatLastLaunch(app.lastLaunch());
+        case ColumnLaunchCount: return formatLaunchCount(app.launchCount());
         }
         break;
 
@@ -82,13 +108,13 @@ QVariant AppListModel::data(const QModelIndex &index, int role) const
         break;
 
     case AppIdRole:
-        return app.id;
+        return app.id();
 
     case AppPathRole:
-        return app.path;
+        return app.path();
 
     case IconPathRole:
-        return app.iconPath;
+        return app.iconPath();
     }
 
     return QVariant();
@@ -108,51 +134,72 @@ QVariant AppListModel::headerData(int section, Qt::Orientation orientation, int
     return QVariant();
 }
 
-void AppListModel::setApps(const QList<AppInfo> &apps)
+void AppListModel::setStore(const AppStore &store)
 {
     beginResetModel();
-    m_apps = apps;
+    m_store = store;
+    m_rows.resize(store.size());
+    for (int i = 0; i < m_rows.size(); ++i) {
+        m_rows[i] = i;
+    }
     m_currentPage = 0;  // データ変更時は最初のページへ
+    invalidatePositions();
     endResetModel();
 }
 
-void AppListModel::clear()
+void AppListModel::setRows(const AppStore &store, const QVector<int> &rows)
 {
     beginResetModel();
-    m_apps.clear();
+    m_store = store;    // 暗黙共有なのでコピーは発生しない
+    m_rows = rows;
     m_currentPage = 0;
+    invalidatePositions();
     endResetModel();
 }
 
-void AppListModel::addApp(const AppInfo &app)
+void AppListModel::appendRows(const QVector<int> &rows)
 {
-    // 最後のページに追加される場合のみ表示更新
-    int newIndex = m_apps.size();
-    int newPage = newIndex / m_itemsPerPage;
+    if (rows.isEmpty()) {
+        return;
+    }
 
-    if (newPage == m_currentPage) {
-        int row = newIndex - m_currentPage * m_itemsPerPage;
-        beginInsertRows(QModelIndex(), row, row);
-        m_apps.append(app);
+    // 現在のページに入る分だけ行の挿入を通知する
+    int oldCount = rowCount();
+    int pageStart = m_currentPage * m_itemsPerPage;
+    int newCount = qBound(0, int(m_rows.size() + rows.size()) - pageStart, m_itemsPerPage);
+    if (m_positionsValid) {
+        // 末尾に足すだけなので、作成済みの位置はそのまま使える
+        for (int i = 0; i < rows.size(); ++i) {
+            m_positions.insert(m_store.id(rows.at(i)), m_rows.size() + i);
+        }
+    }
+    if (newCount > oldCount) {
+        beginInsertRows(QModelIndex(), oldCount, newCount - 1);
+        m_rows.append(rows);
         endInsertRows();
     } else {
-        m_apps.append(app);
+        m_rows.append(rows);
     }
 }
 
+void AppListModel::clear()
+{
+    beginResetModel();
+    m_store.clear();
+    m_rows.clear();
+    m_currentPage = 0;
+    invalidatePositions();
+    endResetModel();
+}
+
 void AppListModel::removeApp(const QString &appId)
 {
-    int actual = -1;
-    for (int i = 0; i < m_apps.size(); ++i) {
-        if (m_apps.at(i).id == appId) {
-            actual = i;
-            break;
-        }
-    }
+    int actual = findActual(appId);
 
     if (actual >= 0) {
         beginResetModel();
-        m_apps.removeAt(actual);
+        m_rows.removeAt(actual);
+        invalidatePositions();
         // ページ調整
         if (m_currentPage >= totalPages() && m_currentPage > 0) {
             m_currentPage = totalPages() - 1;
@@ -161,18 +208,16 @@ void AppListModel::removeApp(const QString &appId)
     }
 }
 
-void AppListModel::updateApp(const AppInfo &app)
+void AppListModel::updateApp(const AppStore &store, const QString &appId)
 {
-    int actual = -1;
-    for (int i = 0; i < m_apps.size(); ++i) {
-        if (m_apps.at(i).id == app.id) {
-            actual = i;
-            break;
-        }
+    // 追加・削除を伴わない変更なので、新しいストアでも行番号はそのまま使える
+    // （件数が違う場合は行がずれているので、次の再表示に任せる）
+    if (store.size() != m_store.size()) {
+        return;
     }
-
+    m_store = store;
+    int actual = findActual(appId);
     if (actual >= 0) {
-        m_apps[actual] = app;
         // 現在のページに表示されている場合のみ更新
         int startIndex = m_currentPage * m_itemsPerPage;
         int endIndex = startIndex + rowCount();
@@ -183,42 +228,159 @@ void AppListModel::updateApp(const AppInfo &app)
     }
 }
 
+bool AppListModel::applyChanges(const CatalogVersion &version, const CatalogChangeSet &changes)
+{
+    if (changes.isReset()) {
+        return false;
+    }
+
+    const QStringList removedIds = changes.removed();
+    const QSet<QString> removed(removedIds.cbegin(), removedIds.cend());
+
+    // 表示中の行を新しい版の行に付け替える（削除されたものは -1 にして後で取り除く）
+    QVector<int> removedPositions;
+    QSet<int> present;
+    for (int i = 0; i < m_rows.size(); ++i) {
+        const QString appId = m_store.id(m_rows.at(i));
+        const int row = removed.contains(appId) ? -1 : version.rowOf(appId);
+        m_rows[i] = row;
+        if (row < 0) {
+            removedPositions.append(i);
+        } else {
+            present.insert(row);
+        }
+    }
+    m_store = version.store();
+    invalidatePositions();
+
+    // 削除: 後ろから処理して手前の位置をずらさない
+    const int pageStart = m_currentPage * m_itemsPerPage;
+    m_visibleLimit = rowCount();
+    int k = removedPositions.size() - 1;
+    while (k >= 0 && removedPositions.at(k) >= pageStart) {
+        // 連続した削除は1回の通知にまとめる
+        const int last = removedPositions.at(k);
+        int first = last;
+        while (k > 0 && removedPositions.at(k - 1) == first - 1 && first - 1 >= pageStart) {
+            --k;
+            --first;
+        }
+        --k;
+        const int localFirst = first - pageStart;
+        if (localFirst >= m_visibleLimit) {
+            m_rows.remove(first, last - first + 1);     // ページより後ろ
+            continue;
+        }
+        const int localLast = qMin(last - pageStart, m_visibleLimit - 1);
+        beginRemoveRows(QModelIndex(), localFirst, localLast);
+        m_rows.remove(first, last - first + 1);
+        m_visibleLimit -= localLast - localFirst + 1;
+        endRemoveRows();
+    }
+
+    // ページより前の削除は、ページの先頭から同じ数の行が抜けたことになる
+    const int removedBeforePage = k + 1;
+    if (removedBeforePage > 0) {
+        const int shifted = qMin(removedBeforePage, m_visibleLimit);
+        if (shifted > 0) {
+            beginRemoveRows(QModelIndex(), 0, shifted - 1);
+        }
+        for (int i = removedBeforePage - 1; i >= 0; --i) {
+            m_rows.removeAt(removedPositions.at(i));
+        }
+        if (shifted > 0) {
+            m_visibleLimit -= shifted;
+            endRemoveRows();
+        }
+    }
+
+    // 追加: 末尾に並べる（既に表示している行は重ねない）
+    for (const QString &appId : changes.added()) {
+        const int row = version.rowOf(appId);
+        if (row >= 0 && !present.contains(row)) {
+            m_rows.append(row);
+            present.insert(row);
+        }
+    }
+
+    if (m_currentPage >= totalPages() && m_currentPage > 0) {
+        // 表示中のページが無くなった場合は最後のページへ
+        beginResetModel();
+        m_currentPage = totalPages() - 1;
+        m_visibleLimit = -1;
+        endResetModel();
+        return true;
+    }
+
+    // 削除で空いた分と追加分のうち、このページに入る行の挿入を通知する
+    const int shown = m_visibleLimit;
+    m_visibleLimit = -1;
+    const int count = rowCount();
+    if (count > shown) {
+        m_visibleLimit = shown;
+        beginInsertRows(QModelIndex(), shown, count - 1);
+        m_visibleLimit = -1;
+        endInsertRows();
+    }
+
+    // 更新: 表示中の行だけ再描画する
+    const QStringList updatedIds = changes.updated();
+    if (!updatedIds.isEmpty()) {
+        const QSet<QString> updated(updatedIds.cbegin(), updatedIds.cend());
+        for (int row = 0; row < count; ++row) {
+            if (updated.contains(appAt(pageStart + row).id())) {
+                emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+            }
+        }
+    }
+    return true;
+}
+
 QString AppListModel::getAppId(int row) const
 {
     int actual = actualIndex(row);
-    if (actual >= 0 && actual < m_apps.size()) {
-        return m_apps.at(actual).id;
+    if (actual >= 0 && actual < m_rows.size()) {
+        return appAt(actual).id();
     }
     return QString();
 }
 
 int AppListModel::findRow(const QString &appId) const
 {
-    for (int i = 0; i < m_apps.size(); ++i) {
-        if (m_apps.at(i).id == appId) {
-            // 現在のページ内の行番号を返す
-            int startIndex = m_currentPage * m_itemsPerPage;
-            if (i >= startIndex && i < startIndex + m_itemsPerPage) {
-                return i - startIndex;
-            }
-            return -1;  // 現在のページにない
-        }
+    int i = findActual(appId);
+    if (i < 0) {
+        return -1;
+    }
+    // 現在のページ内の行番号を返す
+    int startIndex = m_currentPage * m_itemsPerPage;
+    if (i >= startIndex && i < startIndex + m_itemsPerPage) {
+        return i - startIndex;
     }
-    return -1;
+    return -1;  // 現在のページにない
 }
 
 AppInfo AppListModel::getApp(int row) const
 {
     int actual = actualIndex(row);
-    if (actual >= 0 && actual < m_apps.size()) {
-        return m_apps.at(actual);
+    if (actual >= 0 && actual < m_rows.size()) {
+        return appAt(actual).toAppInfo();
     }
     return AppInfo();
 }
 
 int AppListModel::appCount() const
 {
-    return m_apps.size();
+    return m_rows.size();
+}
+
+QStringList AppListModel::appPaths() const
+{
+    QStringList result;
+    result.reserve(m_rows.size());
+    for (int i = 0; i < m_rows.size(); ++i) {
+        result.append(appAt(i).path());
+    }
+    return result;
 }
 
 void AppListModel::setIconCache(QMap<QString, QPixmap> *iconCache)
@@ -271,8 +433,8 @@ void AppListModel::setItemsPerPage(int count)
 
 int AppListModel::totalPages() const
 {
-    if (m_apps.isEmpty()) return 0;
-    return (m_apps.size() + m_itemsPerPage - 1) / m_itemsPerPage;
+    if (m_rows.isEmpty()) return 0;
+    return (m_rows.size() + m_itemsPerPage - 1) / m_itemsPerPage;
 }
 
 QString AppListModel::formatLastLaunch(const QDateTime &dateTime)
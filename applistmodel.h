@@ -4,8 +4,12 @@
 #include <QAbstractTableModel>
 #include <QPixmap>
 #include <QMap>
+#include <QHash>
+#include <QVector>
 #include <functional>
 #include "appinfo.h"
+#include "appstore.h"
+#include "catalogversion.h"
 
 class AppListModel : public QAbstractTableModel
 {
@@ -36,17 +40,21 @@ public:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 
     // Data operations
-    void setApps(const QList<AppInfo> &apps);
+    void setStore(const AppStore &store);                               // 全件をカタログ順で表示
+    void setRows(const AppStore &store, const QVector<int> &rows);      // 表示する行（カタログ上の行）
+    void appendRows(const QVector<int> &rows);                          // 検索結果の続き
     void clear();
-    void addApp(const AppInfo &app);
     void removeApp(const QString &appId);
-    void updateApp(const AppInfo &app);
+    void updateApp(const AppStore &store, const QString &appId);        // 行の並びが変わらない更新
+    // 変更を行の削除・挿入として反映する（追加分は末尾へ）。全体の読み直しが必要なら false
+    bool applyChanges(const CatalogVersion &version, const CatalogChangeSet &changes);
 
     // Data access
     QString getAppId(int row) const;
     int findRow(const QString &appId) const;
     AppInfo getApp(int row) const;
     int appCount() const;
+    QStringList appPaths() const;
 
     // Icon management (QPixmap for performance)
     void setIconCache(QMap<QString, QPixmap> *iconCache);
@@ -64,19 +72,29 @@ public:
     int currentPage() const { return m_currentPage; }
     int itemsPerPage() const { return m_itemsPerPage; }
     int totalPages() const;
-    int totalItems() const { return m_apps.size(); }
+    int totalItems() const { return m_rows.size(); }
 
 private:
-    QList<AppInfo> m_apps;
+    AppStore m_store;           // カタログ（AppManagerと暗黙共有）
+    QVector<int> m_rows;        // 表示順 → m_store内の行
     QMap<QString, QPixmap> *m_iconCache;
     std::function<QPixmap(const QString&)> m_iconLoader;
 
     // Pagination
     int m_currentPage;
     int m_itemsPerPage;
+    int m_visibleLimit;         // applyChanges 中に通知済みの表示行数（通常は -1）
 
-    // Helper to get actual index in m_apps
+    // アプリID → m_rows 内の位置（行の並びが変わったら捨て、次の検索時に作り直す）
+    mutable QHash<QString, int> m_positions;
+    mutable bool m_positionsValid;
+
+    // Helper to get actual index in m_rows
     int actualIndex(int row) const;
+    AppStore::Row appAt(int actual) const;
+    int findActual(const QString &appId) const;
+    void rebuildPositions() const;
+    void invalidatePositions();
 };
 
 #endif // APPLISTMODEL_H
@@ -1,5 +1,10 @@
 #include "appmanager.h"
 #include "iconextractor.h"
+#include "catalogsnapshot.h"
+#include "catalogsaver.h"
+#include "catalogjson.h"
+#include "iconrepairqueue.h"
+#include "filelock.h"
 #include <QDir>
 #include <QStandardPaths>
 #include <QApplication>
@@ -7,31 +12,79 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QPixmap>
+#include <QTimer>
+#include <QFileSystemWatcher>
 #include <QDebug>
+#include <utility>
+#include <memory>
+#include <algorithm>
+
+namespace {
+
+// 終了時の保存が他のプロセスの書き込みと競合したときに、取り込んで書き直す回数
+const int MaxConflictRetries = 3;
+
+}
 
 AppManager::AppManager(QObject *parent)
     : QObject(parent)
     , m_categoryManager(new CategoryManager(this))
+    , m_searchSession(&m_searchIndex)
+    , m_published(std::make_shared<const CatalogVersion>())
+    , m_publishTimer(new QTimer(this))
+    , m_saver(new CatalogSaver(this))
+    , m_saveTimer(new QTimer(this))
+    , m_iconRepair(new IconRepairQueue(this))
+    , m_iconPathsDirty(false)
+    , m_batchDepth(0)
+    , m_fileWatcher(new QFileSystemWatcher(this))
+    , m_reloadTimer(new QTimer(this))
+    , m_knownSize(-1)
+    , m_applyingExternal(false)
+    , m_resaveAfterReload(false)
+    , m_reloadInFlight(false)
 {
     m_dataFilePath = getDefaultDataFilePath();
+    m_journal.setJournalPath(getJournalFilePath());
+    
+    // 短時間に続いた保存要求は1回の書き込みにまとめる
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(500);
+    connect(m_saveTimer, &QTimer::timeout, this, &AppManager::submitSave);
+    connect(m_saver, &CatalogSaver::saveFinished, this, &AppManager::onSaveFinished);
+    connect(m_saver, &CatalogSaver::externalChangesRead, this, &AppManager::onExternalChangesRead);
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &AppManager::flush);
+    
+    m_publishTimer->setSingleShot(true);
+    m_publishTimer->setInterval(200);
+    connect(m_publishTimer, &QTimer::timeout, this, &AppManager::finishChange);
+    
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(300);
+    connect(m_reloadTimer, &QTimer::timeout, this, &AppManager::reloadExternalChanges);
+    connect(m_fileWatcher, &QFileSystemWatcher::fileChanged, this, &AppManager::onDataFileChanged);
+    
+    // アイコン保存用ディレクトリ
+    m_iconRepair->setIconDir(QApplication::applicationDirPath() + "/icons");
+    connect(m_iconRepair, &IconRepairQueue::iconRepaired, this, &AppManager::onIconRepaired);
+    connect(m_iconRepair, &IconRepairQueue::finished, this, &AppManager::onIconRepairFinished);
+    
     initializeDataFile();
 }
 
 AppManager::~AppManager()
 {
-    saveApps();
+    flush();
 }
 
 bool AppManager::addApp(const AppInfo &app)
 {
     qDebug() << "AppManager::addApp called with:" << app.name << app.path;
     
-    // 同じパスのアプリが既に存在するかチェック
-    for (const auto &existingApp : m_apps) {
-        if (existingApp.path == app.path) {
-            qWarning() << "App with same path already exists:" << app.path;
-            return false;
-        }
+    // 同じパスのアプリが既に存在するかチェック（パスインデックスでO(1)）
+    if (m_pathIndex.contains(normalizePath(app.path))) {
+        qWarning() << "App with same path already exists:" << app.path;
+        return false;
     }
     
     if (!app.isValid()) {
@@ -86,15 +139,19 @@ bool AppManager::addApp(const AppInfo &app)
         }
     }
     
-    qDebug() << "Adding app to list, current count:" << m_apps.size();
-    m_apps.append(appWithIcon);
-    qDebug() << "App added, new count:" << m_apps.size();
+    qDebug() << "Adding app to list, current count:" << m_store.size();
+    m_store.append(appWithIcon);
+    indexApp(m_store.size() - 1);
+    m_searchIndex.addApp(appWithIcon);
+    m_frecencyIndex.addApp(appWithIcon);
+    m_pendingChanges.markAdded(appWithIcon.id);
+    journal({CatalogJournal::OpAdd, appWithIcon.id, appWithIcon});
+    finishChange();
+    qDebug() << "App added, new count:" << m_store.size();
     
-    emit appAdded(appWithIcon);
-    qDebug() << "appAdded signal emitted";
-    
-    bool saveResult = saveApps();
-    qDebug() << "Save result:" << saveResult;
+    if (m_batchDepth == 0) {
+        emit appAdded(appWithIcon);
+    }
     
     return true;
 }
@@ -105,18 +162,16 @@ int AppManager::addApps(const QList<AppInfo> &apps)
     
     int addedCount = 0;
     
+    // 追加分はまとめて1回の catalogChanged とジャーナル書き込みにする
+    beginBatch();
+    m_store.reserve(m_store.size() + apps.size());
+    m_idIndex.reserve(m_store.size() + apps.size());
+    m_pathIndex.reserve(m_store.size() + apps.size());
+    
     for (const AppInfo &app : apps) {
-        // 同じパスのアプリが既に存在するかチェック
-        bool exists = false;
-        for (const auto &existingApp : m_apps) {
-            if (existingApp.path == app.path) {
-                qWarning() << "App with same path already exists:" << app.path;
-                exists = true;
-                break;
-            }
-        }
-        
-        if (exists) {
+        // 同じパスのアプリが既に存在するかチェック（同一バッチ内の重複も検出される）
+        if (m_pathIndex.contains(normalizePath(app.path))) {
+            qWarning() << "App with same path already exists:" << app.path;
             continue;
         }
         
@@ -125,14 +180,20 @@ int AppManager::addApps(const QList<AppInfo> &apps)
             continue;
         }
         
-        m_apps.append(app);
+        m_store.append(app);
+        indexApp(m_store.size() - 1);
+        m_searchIndex.addApp(app);
+        m_frecencyIndex.addApp(app);
+        m_pendingChanges.markAdded(app.id);
+        journal({CatalogJournal::OpAdd, app.id, app});
         addedCount++;
         qDebug() << "Added app:" << app.name;
     }
     
+    commit();
+    
     if (addedCount > 0) {
         emit appsAdded(addedCount);
-        saveApps();
         qDebug() << "Successfully added" << addedCount << "apps in batch";
     }
     
@@ -142,115 +203,260 @@ int AppManager::addApps(const QList<AppInfo> &apps)
 bool AppManager::removeApp(const QString &appId)
 {
     qDebug() << "AppManager::removeApp - Attempting to remove app with ID:" << appId;
-    for (int i = 0; i < m_apps.size(); ++i) {
-        if (m_apps[i].id == appId) {
-            QString appName = m_apps[i].name;
-            qDebug() << "AppManager::removeApp - Found app at index" << i << ":" << appName;
-            m_apps.removeAt(i);
-            qDebug() << "AppManager::removeApp - App removed from list, emitting signal";
-            emit appRemoved(appId);
-            qDebug() << "AppManager::removeApp - Signal emitted, saving apps";
-            saveApps();
-            qDebug() << "AppManager::removeApp - Successfully removed app:" << appName;
-            return true;
-        }
+    int i = m_idIndex.value(appId, -1);
+    if (i < 0) {
+        qWarning() << "AppManager::removeApp - App not found:" << appId;
+        return false;
+    }
+    
+    QString appName = m_store.name(i);
+    qDebug() << "AppManager::removeApp - Found app at index" << i << ":" << appName;
+    unindexApp(i);
+    m_store.removeAt(i);
+    reindexFrom(i);
+    m_searchIndex.removeApp(appId);
+    m_frecencyIndex.removeApp(appId);
+    m_pendingChanges.markRemoved(appId);
+    journal({CatalogJournal::OpRemove, appId, AppInfo()});
+    finishChange();
+    if (m_batchDepth == 0) {
+        emit appRemoved(appId);
     }
-    qWarning() << "AppManager::removeApp - App not found:" << appId;
-    return false;
+    qDebug() << "AppManager::removeApp - Successfully removed app:" << appName;
+    return true;
 }
 
 bool AppManager::updateApp(const QString &appId, const AppInfo &updatedApp)
 {
-    for (int i = 0; i < m_apps.size(); ++i) {
-        if (m_apps[i].id == appId) {
-            m_apps[i] = updatedApp;
-            emit appUpdated(updatedApp);
-            saveApps();
-            return true;
+    int i = m_idIndex.value(appId, -1);
+    if (i < 0) {
+        return false;
+    }
+    
+    // IDやパスが変わる可能性があるので付け直す
+    unindexApp(i);
+    m_store.replace(i, updatedApp);
+    indexApp(i);
+    m_searchIndex.updateApp(appId, updatedApp);
+    m_frecencyIndex.updateApp(appId, updatedApp);
+    if (updatedApp.id != appId) {
+        m_pendingChanges.markRemoved(appId);
+        m_pendingChanges.markAdded(updatedApp.id);
+    } else {
+        m_pendingChanges.markUpdated(appId);
+    }
+    journal({CatalogJournal::OpUpdate, updatedApp.id, updatedApp});
+    finishChange();
+    if (m_batchDepth == 0) {
+        emit appUpdated(updatedApp);
+    }
+    return true;
+}
+
+int AppManager::removeApps(const QStringList &appIds)
+{
+    // 索引から外してから、ストアの行はまとめて1回で詰める（後続の位置の付け直しも1回）
+    QVector<int> removedSlots;
+    removedSlots.reserve(appIds.size());
+    
+    beginBatch();
+    for (const QString &appId : appIds) {
+        int slot = m_idIndex.value(appId, -1);
+        if (slot < 0) {
+            continue;   // 見つからない・同じIDの重複
         }
+        unindexApp(slot);
+        removedSlots.append(slot);
+        m_searchIndex.removeApp(appId);
+        m_frecencyIndex.removeApp(appId);
+        m_pendingChanges.markRemoved(appId);
+        journal({CatalogJournal::OpRemove, appId, AppInfo()});
+    }
+    
+    if (!removedSlots.isEmpty()) {
+        m_store.removeRows(removedSlots);
+        reindexFrom(*std::min_element(removedSlots.cbegin(), removedSlots.cend()));
+        qDebug() << "AppManager::removeApps - Removed" << removedSlots.size() << "apps";
     }
-    return false;
+    commit();
+    return removedSlots.size();
 }
 
-AppInfo* AppManager::findApp(const QString &appId)
+int AppManager::updateApps(const QList<AppInfo> &apps)
 {
-    for (int i = 0; i < m_apps.size(); ++i) {
-        if (m_apps[i].id == appId) {
-            return &m_apps[i];
+    int updatedCount = 0;
+    beginBatch();
+    for (const AppInfo &app : apps) {
+        if (updateApp(app.id, app)) {
+            updatedCount++;
         }
     }
-    return nullptr;
+    commit();
+    return updatedCount;
+}
+
+void AppManager::beginBatch()
+{
+    ++m_batchDepth;
+}
+
+void AppManager::commit()
+{
+    if (m_batchDepth == 0) {
+        qWarning() << "AppManager::commit called without beginBatch";
+        return;
+    }
+    if (--m_batchDepth == 0) {
+        finishChange();
+    }
+}
+
+AppManager::Batch::Batch(AppManager *manager)
+    : m_manager(manager)
+{
+    m_manager->beginBatch();
+}
+
+AppManager::Batch::~Batch()
+{
+    m_manager->commit();
+}
+
+AppStore::Row AppManager::findApp(const QString &appId) const
+{
+    int i = m_idIndex.value(appId, -1);
+    return i >= 0 ? m_store.row(i) : AppStore::Row();
+}
+
+AppStore AppManager::getStore() const
+{
+    return m_store;
+}
+
+CatalogVersionPtr AppManager::snapshot() const
+{
+    return std::atomic_load(&m_published);
+}
+
+CatalogChangeSet AppManager::changesSince(quint64 version) const
+{
+    return snapshot()->changesSince(version);
 }
 
 QList<AppInfo> AppManager::getApps() const
 {
-    return m_apps;
+    return m_store.toList();
 }
 
 QList<AppInfo> AppManager::searchApps(const QString &keyword) const
 {
-    QList<AppInfo> results;
-    QString lowerKeyword = keyword.toLower();
-    
-    for (const auto &app : m_apps) {
-        if (app.name.toLower().contains(lowerKeyword) ||
-            app.description.toLower().contains(lowerKeyword) ||
-            app.path.toLower().contains(lowerKeyword)) {
-            results.append(app);
-        }
+    if (keyword.isEmpty()) {
+        return getApps();
     }
     
-    return results;
+    // 入力途中の検索は前回の結果を絞り込む（結果はカタログ順）
+    return appsForDocuments(m_searchSession.searchDocuments(keyword));
+}
+
+const SearchIndex &AppManager::getSearchIndex() const
+{
+    return m_searchIndex;
 }
 
 QList<AppInfo> AppManager::getAppsByCategory(const QString &category) const
 {
     if (category == "すべて" || category.isEmpty()) {
-        return m_apps;
+        return getApps();
     }
     
-    QList<AppInfo> results;
-    for (const auto &app : m_apps) {
-        if (app.category == category) {
-            results.append(app);
-        }
-    }
-    return results;
+    return appsForDocuments(m_searchIndex.categoryDocuments(category));
 }
 
 QList<AppInfo> AppManager::searchAppsInCategory(const QString &keyword, const QString &category) const
 {
-    QList<AppInfo> categoryApps = getAppsByCategory(category);
-    
     if (keyword.isEmpty()) {
-        return categoryApps;
+        return getAppsByCategory(category);
     }
     
-    QList<AppInfo> results;
-    QString lowerKeyword = keyword.toLower();
-    
-    for (const auto &app : categoryApps) {
-        if (app.name.toLower().contains(lowerKeyword) ||
-            app.description.toLower().contains(lowerKeyword) ||
-            app.path.toLower().contains(lowerKeyword)) {
-            results.append(app);
-        }
+    // 検索結果の文書IDをカテゴリのビットマップで絞り込んでから AppInfo を取り出す
+    QVector<quint32> docIds = m_searchSession.searchDocuments(keyword);
+    if (category != "すべて" && !category.isEmpty()) {
+        docIds = m_searchIndex.filterCategory(docIds, category);
     }
-    
-    return results;
+    return appsForDocuments(docIds);
 }
 
 int AppManager::getAppCount() const
 {
-    return m_apps.size();
+    return m_store.size();
 }
 
 int AppManager::getAppCountByCategory(const QString &category) const
 {
-    return getAppsByCategory(category).size();
+    if (category == "すべて" || category.isEmpty()) {
+        return m_store.size();
+    }
+    return m_searchIndex.categoryCount(category);
+}
+
+QList<AppInfo> AppManager::appsForDocuments(const QVector<quint32> &docIds) const
+{
+    QList<AppInfo> results;
+    results.reserve(docIds.size());
+    for (const QString &appId : m_searchIndex.appIds(docIds)) {
+        int slot = m_idIndex.value(appId, -1);
+        if (slot >= 0) {
+            results.append(m_store.at(slot));
+        }
+    }
+    return results;
 }
 
 bool AppManager::loadApps()
+{
+    // バイナリスナップショットが最新ならJSONの解析を省略する
+    bool fromSnapshot = loadFromSnapshot();
+    if (!fromSnapshot && !loadFromJson()) {
+        return false;
+    }
+    rebuildIndexes();
+
+    // 異常終了したインスタンスのジャーナルを引き取り、スナップショット以降の変更と合わせて再生
+    m_journal.adoptOrphans(getJournalFilePaths());
+    const QList<CatalogJournal::Record> records = m_journal.readAll();
+    for (const CatalogJournal::Record &record : records) {
+        applyJournalRecord(record);
+        m_unsavedIds.insert(record.appId);     // apps.json にはまだ無い変更
+    }
+    
+    // 読み込み前の版との個別の差分は持たず、読み手には全体の読み直しを求める
+    m_pendingChanges.markReset();
+    publishSnapshot();
+
+    // ジャーナルの畳み込み・スナップショット作成はバックグラウンドで保存
+    if (!fromSnapshot || !records.isEmpty()) {
+        scheduleSave();
+    }
+
+    emit dataLoaded();
+    qDebug() << "Loaded" << m_store.size() << "applications";
+    
+    const AppStore::MemoryReport memory = m_store.memoryReport();
+    qDebug() << "Catalog memory:" << memory.total / 1024 << "KiB"
+             << "(columns" << memory.fixedColumns / 1024 << "KiB, text" << memory.textBuffer / 1024
+             << "KiB, shared strings" << memory.sharedStrings / 1024 << "KiB; as AppInfo list"
+             << memory.appInfoEquivalent / 1024 << "KiB)";
+    
+    // 以降の外部からの書き換えを監視する
+    rememberDataFile();
+    watchDataFile();
+    
+    // アイコンの検証・再生成は表示後にバックグラウンドで行う
+    startIconRepair();
+    return true;
+}
+
+bool AppManager::loadFromJson()
 {
     QFile file(m_dataFilePath);
     if (!file.open(QIODevice::ReadOnly)) {
@@ -258,160 +464,169 @@ bool AppManager::loadApps()
         return false;
     }
     
-    QByteArray data = file.readAll();
+    // ファイル全体やDOMは持たず、レコードを1件ずつカタログに追加する
+    m_store.clear();
+    CatalogJsonReader reader(&file);
+    bool ok = reader.read([this](const QJsonObject &record) {
+        AppInfo app;
+        app.fromJson(record);
+        if (app.isValid()) {
+            m_store.append(app);
+        }
+    });
     file.close();
     
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) {
-        qWarning() << "Invalid JSON format in apps data file";
+    if (!ok) {
+        qWarning() << "Invalid JSON format in apps data file:" << reader.errorString();
+        m_store.clear();
         return false;
     }
     
-    QJsonObject rootObj = doc.object();
-    
     // カテゴリ情報の読み込み
-    if (rootObj.contains("categories")) {
+    const QJsonValue categories = reader.value("categories");
+    if (!categories.isUndefined()) {
         QJsonObject categoryData;
-        categoryData["categories"] = rootObj["categories"];
+        categoryData["categories"] = categories;
         m_categoryManager->fromJson(categoryData);
     }
     
-    QJsonArray appsArray = rootObj["apps"].toArray();
-    
-    m_apps.clear();
-
-    // アイコン保存用ディレクトリ
-    QString iconDir = QApplication::applicationDirPath() + "/icons";
-    QDir(iconDir).mkpath(".");
-    IconExtractor iconExtractor;
-    bool needsSave = false;
-
-    for (const auto &value : appsArray) {
-        if (value.isObject()) {
-            AppInfo app;
-            app.fromJson(value.toObject());
-            if (app.isValid()) {
-                // 既存データのiconPath修正: exeファイルパスが設定されている場合は空にする
-                if (!app.iconPath.isEmpty() && app.iconPath.endsWith(".exe", Qt::CaseInsensitive)) {
-                    qDebug() << "Fixing invalid iconPath for app:" << app.name;
-                    app.iconPath = "";
-                }
-
-                // iconPathが空、存在しない、またはグレーアイコン（200バイト以下）の場合、アイコンを再生成
-                bool needsRegenerate = app.iconPath.isEmpty() || !QFileInfo::exists(app.iconPath);
-                if (!needsRegenerate && QFileInfo::exists(app.iconPath)) {
-                    QFileInfo iconInfo(app.iconPath);
-                    if (iconInfo.size() <= 200) {
-                        // グレーアイコン（小さいファイル）なので再生成
-                        needsRegenerate = true;
-                        QFile::remove(app.iconPath);  // 古いファイルを削除
-                    }
-                }
-
-                if (needsRegenerate) {
-                    QString iconPath = iconExtractor.generateIconPath(app.path, iconDir);
-                    // 既存の小さいファイルも削除
-                    if (QFileInfo::exists(iconPath) && QFileInfo(iconPath).size() <= 200) {
-                        QFile::remove(iconPath);
-                    }
-                    if (!QFileInfo::exists(iconPath)) {
-                        // アイコン抽出・保存
-                        if (iconExtractor.extractAndSaveIcon(app.path, iconPath)) {
-                            app.iconPath = iconPath;
-                            needsSave = true;
-                            qDebug() << "Generated icon for:" << app.name << "->" << iconPath;
-                        }
-                    } else {
-                        app.iconPath = iconPath;
-                        needsSave = true;
-                    }
-                }
-
-                m_apps.append(app);
-            }
-        }
-    }
-
-    // アイコンパスが更新された場合は保存
-    if (needsSave) {
-        saveApps();
-    }
-
-    emit dataLoaded();
-    qDebug() << "Loaded" << m_apps.size() << "applications";
+    qDebug() << "Loaded" << m_store.size() << "applications from JSON";
     return true;
 }
 
-bool AppManager::saveApps()
+bool AppManager::loadFromSnapshot()
 {
-    QJsonObject rootObj;
-    QJsonArray appsArray;
-    
-    for (const auto &app : m_apps) {
-        appsArray.append(app.toJson());
+    CatalogSnapshot snapshot;
+    if (!snapshot.open(getSnapshotFilePath(), m_dataFilePath)) {
+        return false;
     }
     
-    rootObj["apps"] = appsArray;
-    rootObj["version"] = "1.0";
-    rootObj["lastModified"] = QDateTime::currentDateTime().toString(Qt::ISODate);
-    
-    // カテゴリ情報も保存
-    QJsonObject categoryObj = m_categoryManager->toJson();
-    rootObj.insert("categories", categoryObj["categories"]);
-    
-    QJsonDocument doc(rootObj);
-    
-    QFile file(m_dataFilePath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        qWarning() << "Cannot open apps data file for writing:" << m_dataFilePath;
-        return false;
+    QJsonObject categoryData = snapshot.categories();
+    if (categoryData.contains("categories")) {
+        m_categoryManager->fromJson(categoryData);
     }
     
-    file.write(doc.toJson());
-    file.close();
+    // レコードと文字列アリーナから直接列へ詰める（AppInfo/QDateTimeへの変換はしない）
+    m_store.clear();
+    snapshot.loadInto(&m_store);
     
-    emit dataSaved();
-    qDebug() << "Saved" << m_apps.size() << "applications to" << m_dataFilePath;
+    // Windowsではマップ中のファイルを置き換えられないため、読み終えたらすぐに閉じる
+    snapshot.close();
+    qDebug() << "Loaded" << m_store.size() << "applications from binary snapshot";
     return true;
 }
 
-AppInfo* AppManager::getMostLaunchedApp()
+bool AppManager::saveApps()
 {
-    if (m_apps.isEmpty()) {
-        return nullptr;
+    // 待機中の遅延保存も含めて即座にワーカーへ渡す（書き込み完了は待たない）
+    submitSave();
+    return true;
+}
+
+void AppManager::scheduleSave()
+{
+    m_saveTimer->start();
+}
+
+bool AppManager::flush()
+{
+    if (m_saveTimer->isActive() || m_iconPathsDirty) {
+        m_iconPathsDirty = false;
+        submitSave();
     }
     
-    AppInfo* mostLaunched = &m_apps[0];
-    for (int i = 1; i < m_apps.size(); ++i) {
-        if (m_apps[i].launchCount > mostLaunched->launchCount) {
-            mostLaunched = &m_apps[i];
-        }
+    CatalogSaver::Result result = m_saver->flush();
+    // 他で書き換えられていた場合は、取り込んでから書き直す（書き手が続く場合に備えて回数は限る）
+    for (int retry = 0; result == CatalogSaver::Conflicted && retry < MaxConflictRetries; ++retry) {
+        restoreUnsaved();
+        m_resaveAfterReload = false;
+        // 終了処理中なので、ここではロックを待ってその場で読む
+        QSet<QString> unsaved = m_unsavedIds;
+        unsaved.unite(m_savingIds);
+        applyExternalChanges(CatalogSaver::collectExternalChanges(m_dataFilePath, m_store, unsaved,
+                                                                  m_knownModified, m_knownSize,
+                                                                  FileLock::DefaultTimeout));
+        submitSave();
+        result = m_saver->flush();
     }
     
-    return mostLaunched->launchCount > 0 ? mostLaunched : nullptr;
+    // saveFinished は終了処理中に届かないことがあるため、ここでもマージ済みジャーナルを片付ける
+    if (result == CatalogSaver::Written) {
+        m_journal.finishMerge();
+    }
+    return result == CatalogSaver::Written;
+}
+
+void AppManager::setSaveDelay(int msec)
+{
+    m_saveTimer->setInterval(qMax(0, msec));
+}
+
+AppStore::Row AppManager::getMostLaunchedApp() const
+{
+    return findApp(m_frecencyIndex.mostLaunched());
+}
+
+AppStore::Row AppManager::getRecentlyLaunchedApp() const
+{
+    return findApp(m_frecencyIndex.mostRecent());
 }
 
-AppInfo* AppManager::getRecentlyLaunchedApp()
+QVector<int> AppManager::getFrecencyOrderedRows() const
 {
-    if (m_apps.isEmpty()) {
-        return nullptr;
+    // 起動済みのアプリは索引の順序をそのまま使い、未起動のアプリをカタログ順で後ろに並べる
+    QVector<int> rows;
+    rows.reserve(m_store.size());
+    QVector<bool> placed(m_store.size(), false);
+    const QStringList frecentIds = m_frecencyIndex.frecentIds();
+    for (const QString &appId : frecentIds) {
+        const int row = m_idIndex.value(appId, -1);
+        if (row >= 0 && !placed.at(row)) {
+            rows.append(row);
+            placed[row] = true;
+        }
     }
-    
-    AppInfo* recentlyLaunched = nullptr;
-    for (int i = 0; i < m_apps.size(); ++i) {
-        if (m_apps[i].lastLaunch.isValid()) {
-            if (!recentlyLaunched || m_apps[i].lastLaunch > recentlyLaunched->lastLaunch) {
-                recentlyLaunched = &m_apps[i];
-            }
+    for (int row = 0; row < m_store.size(); ++row) {
+        if (!placed.at(row)) {
+            rows.append(row);
         }
     }
+    return rows;
+}
+
+void AppManager::recordLaunch(const QString &appId)
+{
+    int slot = m_idIndex.value(appId, -1);
+    if (slot < 0) {
+        return;
+    }
     
-    return recentlyLaunched;
+    // AppLauncher が起動に成功した時点で起動回数・最終起動時刻を進め、索引の1件を差し替えて保存する
+    m_store.recordLaunch(slot, QDateTime::currentDateTime());
+    const AppInfo app = m_store.at(slot);
+    m_frecencyIndex.updateApp(appId, app);
+    m_pendingChanges.markUpdated(appId);
+    journal({CatalogJournal::OpUpdate, appId, app});
+    finishChange();
+    if (m_batchDepth == 0) {
+        emit launchRecorded(appId);
+    }
 }
 
 void AppManager::setDataFilePath(const QString &filePath)
 {
+    flush();
     m_dataFilePath = filePath;
+    m_journal.setJournalPath(getJournalFilePath());
+    m_unsavedIds.clear();
+    m_savingIds.clear();
+    rememberDataFile();
+    watchDataFile();
+}
+
+void AppManager::setJournalCompactionThreshold(int threshold)
+{
+    m_journal.setCompactionThreshold(threshold);
 }
 
 QString AppManager::getDataFilePath() const
@@ -421,8 +636,8 @@ QString AppManager::getDataFilePath() const
 
 bool AppManager::validateAppData() const
 {
-    for (const auto &app : m_apps) {
-        if (!app.isValid()) {
+    for (int i = 0; i < m_store.size(); ++i) {
+        if (!m_store.row(i).toAppInfo().isValid()) {
             return false;
         }
     }
@@ -431,18 +646,64 @@ bool AppManager::validateAppData() const
 
 void AppManager::cleanupInvalidApps()
 {
-    auto it = m_apps.begin();
-    while (it != m_apps.end()) {
-        if (!it->isValid()) {
-            QString removedId = it->id;
-            it = m_apps.erase(it);
-            emit appRemoved(removedId);
-            qDebug() << "Removed invalid app:" << it->name;
-        } else {
-            ++it;
+    QStringList removedIds;
+    for (int i = 0; i < m_store.size(); ++i) {
+        if (m_store.name(i).isEmpty() || m_store.path(i).isEmpty()) {
+            qDebug() << "Removed invalid app:" << m_store.name(i);
+            removedIds.append(m_store.id(i));
         }
     }
-    saveApps();
+    
+    // 削除は removeApps でまとめて行う（ジャーナルに記録され、通知も catalogChanged 1回になる）
+    if (!removedIds.isEmpty()) {
+        Batch batch(this);
+        removeApps(removedIds);
+    }
+}
+
+QString AppManager::normalizePath(const QString &path)
+{
+    return QDir::fromNativeSeparators(path).toLower();
+}
+
+void AppManager::indexApp(int slot)
+{
+    m_idIndex.insert(m_store.id(slot), slot);
+    m_pathIndex.insert(normalizePath(m_store.path(slot)), slot);
+}
+
+void AppManager::unindexApp(int slot)
+{
+    const QString appId = m_store.id(slot);
+    // 別のアプリを指しているエントリは消さない
+    if (m_idIndex.value(appId, -1) == slot) {
+        m_idIndex.remove(appId);
+    }
+    QString pathKey = normalizePath(m_store.path(slot));
+    if (m_pathIndex.value(pathKey, -1) == slot) {
+        m_pathIndex.remove(pathKey);
+    }
+}
+
+void AppManager::reindexFrom(int slot)
+{
+    // 削除でずれた後続要素の位置を更新
+    for (int i = slot; i < m_store.size(); ++i) {
+        indexApp(i);
+    }
+}
+
+void AppManager::rebuildIndexes()
+{
+    m_idIndex.clear();
+    m_pathIndex.clear();
+    m_idIndex.reserve(m_store.size());
+    m_pathIndex.reserve(m_store.size());
+    for (int i = 0; i < m_store.size(); ++i) {
+        indexApp(i);
+    }
+    m_searchIndex.rebuild(m_store);
+    m_frecencyIndex.rebuild(m_store);
 }
 
 void AppManager::initializeDataFile()
@@ -472,6 +733,356 @@ void AppManager::initializeDataFile()
     }
 }
 
+QString AppManager::getJournalFilePath() const
+{
+    // apps.json と同じ場所に、プロセスごとの apps.<pid>.journal を置く
+    QFileInfo fileInfo(m_dataFilePath);
+    return fileInfo.dir().filePath(QString("%1.%2.journal")
+                                   .arg(fileInfo.completeBaseName())
+                                   .arg(QCoreApplication::applicationPid()));
+}
+
+QStringList AppManager::getJournalFilePaths() const
+{
+    // 各プロセスのジャーナル（マージ用だけが残っているものも含む）と、以前の共有の apps.journal
+    QFileInfo fileInfo(m_dataFilePath);
+    const QDir dir = fileInfo.dir();
+    const QString base = fileInfo.completeBaseName();
+    const QStringList names = dir.entryList(QStringList() << base + ".journal" << base + ".journal.merging"
+                                                          << base + ".*.journal" << base + ".*.journal.merging",
+                                            QDir::Files);
+    QStringList paths;
+    for (QString name : names) {
+        if (name.endsWith(".merging")) {
+            name.chop(int(qstrlen(".merging")));
+        }
+        const QString path = dir.filePath(name);
+        if (!paths.contains(path)) {
+            paths.append(path);
+        }
+    }
+    return paths;
+}
+
+QString AppManager::getSnapshotFilePath() const
+{
+    // apps.json と同じ場所に apps.bin を置く
+    QFileInfo fileInfo(m_dataFilePath);
+    return fileInfo.dir().filePath(fileInfo.completeBaseName() + ".bin");
+}
+
+void AppManager::commitToJournal(bool appended)
+{
+    // ジャーナルに書けなかった場合、またはジャーナルが肥大化した場合は全体を保存
+    if (!appended || m_journal.needsCompaction()) {
+        scheduleSave();
+    }
+}
+
+void AppManager::applyJournalRecord(const CatalogJournal::Record &record)
+{
+    int slot = m_idIndex.value(record.appId, -1);
+    
+    if (record.op == CatalogJournal::OpRemove) {
+        if (slot >= 0) {
+            unindexApp(slot);
+            m_store.removeAt(slot);
+            reindexFrom(slot);
+            m_searchIndex.removeApp(record.appId);
+            m_frecencyIndex.removeApp(record.appId);
+        }
+        return;
+    }
+    
+    // 追加・更新はどちらも上書きとして適用（スナップショットに反映済みでも冪等）
+    if (slot >= 0) {
+        unindexApp(slot);
+        m_store.replace(slot, record.app);
+        indexApp(slot);
+        m_searchIndex.updateApp(record.appId, record.app);
+        m_frecencyIndex.updateApp(record.appId, record.app);
+    } else if (record.app.isValid()) {
+        m_store.append(record.app);
+        indexApp(m_store.size() - 1);
+        m_searchIndex.addApp(record.app);
+        m_frecencyIndex.addApp(record.app);
+    }
+}
+
+void AppManager::submitSave()
+{
+    m_saveTimer->stop();
+    
+    // これまでのジャーナルは保存内容に含まれるのでマージ用に退避し、書き込み完了後に削除する
+    m_journal.rotate();
+    m_savingIds.unite(m_unsavedIds);
+    m_unsavedIds.clear();
+    m_saver->submit(m_store, m_categoryManager->toJson(), m_dataFilePath, getSnapshotFilePath(),
+                    m_knownModified, m_knownSize);
+}
+
+void AppManager::onSaveFinished(quint64 generation, CatalogSaver::Result result)
+{
+    // 後続の保存が控えている場合、マージ用ジャーナルはそちらの完了まで残す
+    if (generation != m_saver->lastSubmittedGeneration()) {
+        return;
+    }
+    if (result == CatalogSaver::Failed) {
+        // 書けなかった変更は未保存に戻す
+        restoreUnsaved();
+        return;
+    }
+    if (result == CatalogSaver::Conflicted) {
+        // 他のプロセスの変更を先に取り込み、こちらの未保存の変更と合わせて書き直す
+        restoreUnsaved();
+        m_resaveAfterReload = true;
+        reloadExternalChanges();
+        return;
+    }
+    
+    m_savingIds.clear();
+    m_knownModified = m_saver->lastWrittenModified();
+    m_knownSize = m_saver->lastWrittenSize();
+    m_journal.finishMerge();
+    emit dataSaved();
+}
+
+void AppManager::restoreUnsaved()
+{
+    m_unsavedIds.unite(m_savingIds);
+    m_savingIds.clear();
+}
+
+void AppManager::watchDataFile()
+{
+    if (!m_fileWatcher->files().isEmpty()) {
+        m_fileWatcher->removePaths(m_fileWatcher->files());
+    }
+    if (QFileInfo::exists(m_dataFilePath)) {
+        m_fileWatcher->addPath(m_dataFilePath);
+    }
+}
+
+void AppManager::rememberDataFile()
+{
+    QFileInfo info(m_dataFilePath);
+    m_knownModified = info.lastModified();
+    m_knownSize = info.exists() ? info.size() : -1;
+}
+
+void AppManager::onDataFileChanged(const QString &path)
+{
+    // 置き換え（リネーム）で書かれると監視が外れるので付け直す
+    if (!m_fileWatcher->files().contains(path) && QFileInfo::exists(path)) {
+        m_fileWatcher->addPath(path);
+    }
+    m_reloadTimer->start();
+}
+
+void AppManager::reloadExternalChanges()
+{
+    // 自分の保存が終わっていなければ、書き終えてから確かめ直す
+    if (m_saver->lastWrittenGeneration() != m_saver->lastSubmittedGeneration()) {
+        m_reloadTimer->start();
+        return;
+    }
+    // 読み込み中の結果を受け取ってから確かめ直す
+    if (m_reloadInFlight) {
+        m_reloadTimer->start();
+        return;
+    }
+    
+    QFileInfo info(m_dataFilePath);
+    if (!info.exists() || (info.lastModified() == m_knownModified && info.size() == m_knownSize)) {
+        return;     // 自分の書き込み、または既に取り込んだ内容
+    }
+    
+    // まだ apps.json に書いていないこちらの変更を優先する（次の保存で両方を含めて書き戻す）
+    QSet<QString> unsaved = m_unsavedIds;
+    unsaved.unite(m_savingIds);
+    
+    // 読み込みと差分の計算は保存スレッドで行い、GUIスレッドでは差分を当てるだけにする
+    m_reloadInFlight = true;
+    m_saver->readExternalChanges(m_dataFilePath, m_store, unsaved, m_knownModified, m_knownSize);
+}
+
+void AppManager::onExternalChangesRead(const CatalogSaver::ExternalChanges &changes)
+{
+    m_reloadInFlight = false;
+    if (changes.dataFilePath != m_dataFilePath) {
+        return;     // 読み込み中にデータファイルが切り替わった
+    }
+    if (changes.status == CatalogSaver::ExternalChanges::Busy) {
+        m_reloadTimer->start();
+        return;
+    }
+    applyExternalChanges(changes);
+}
+
+void AppManager::applyExternalChanges(const CatalogSaver::ExternalChanges &changes)
+{
+    // Unchanged: 既に取り込んだ内容、Unreadable: 書き込み途中の可能性があるので次の変更通知を待つ
+    if (changes.status != CatalogSaver::ExternalChanges::Read) {
+        return;
+    }
+    // 読んでいる間に別の内容を取り込んだ・書いた場合、この差分は古い
+    if (changes.baseModified != m_knownModified || changes.baseSize != m_knownSize) {
+        m_reloadTimer->start();
+        return;
+    }
+    m_knownModified = changes.modified;
+    m_knownSize = changes.size;
+    
+    // 競合で書けなかった保存は、読み直した内容を基にやり直す
+    const bool resave = m_resaveAfterReload;
+    m_resaveAfterReload = false;
+    
+    // 差分を計算した後にこちらで変更・追加・削除したアプリは、こちらの内容を優先する
+    QSet<QString> unsaved = m_unsavedIds;
+    unsaved.unite(m_savingIds);
+    
+    QStringList removedIds;
+    QList<AppInfo> updatedApps;
+    QList<AppInfo> addedApps;
+    for (const QString &appId : changes.removedIds) {
+        if (!unsaved.contains(appId) && m_idIndex.contains(appId)) {
+            removedIds.append(appId);
+        }
+    }
+    for (const AppInfo &app : changes.updatedApps) {
+        if (!unsaved.contains(app.id) && m_idIndex.contains(app.id)) {
+            updatedApps.append(app);
+        }
+    }
+    for (const AppInfo &app : changes.addedApps) {
+        if (!unsaved.contains(app.id) && !m_idIndex.contains(app.id)) {
+            addedApps.append(app);
+        }
+    }
+    
+    if (!changes.categories.isUndefined() && changes.categories != m_categoryManager->toJson().value("categories")) {
+        QJsonObject categoryData;
+        categoryData["categories"] = changes.categories;
+        m_categoryManager->fromJson(categoryData);
+    }
+    
+    const int changeCount = removedIds.size() + updatedApps.size() + addedApps.size();
+    if (changeCount == 0) {
+        if (resave) {
+            scheduleSave();
+        }
+        return;
+    }
+    
+    qDebug() << "Applying external changes to" << m_dataFilePath << "- removed" << removedIds.size()
+             << "updated" << updatedApps.size() << "added" << addedApps.size();
+    m_applyingExternal = true;
+    beginBatch();
+    removeApps(removedIds);
+    updateApps(updatedApps);
+    addApps(addedApps);
+    commit();
+    m_applyingExternal = false;
+    
+    if (!unsaved.isEmpty() || resave) {
+        // こちらの未保存の変更と合わせた内容を書き戻し、他のプロセスにも伝える
+        scheduleSave();
+    }
+    emit externalChangesLoaded(changeCount);
+}
+
+void AppManager::prioritizeIconRepair(const QStringList &appIds)
+{
+    m_iconRepair->prioritize(appIds);
+}
+
+void AppManager::startIconRepair()
+{
+    QList<IconRepairQueue::Entry> entries;
+    entries.reserve(m_store.size());
+    for (int i = 0; i < m_store.size(); ++i) {
+        entries.append(IconRepairQueue::Entry{m_store.id(i), m_store.path(i), m_store.iconPath(i)});
+    }
+    m_iconRepair->start(entries);
+}
+
+CatalogChangeSet AppManager::publishSnapshot()
+{
+    m_publishTimer->stop();
+    if (m_pendingChanges.isEmpty()) {
+        return CatalogChangeSet();
+    }
+    
+    // 新しい版を作って差し替える（読み手が保持している古い版はそのまま使われ、手放された時点で解放される）
+    CatalogVersionPtr current = std::atomic_load(&m_published);
+    CatalogVersionPtr next = std::make_shared<const CatalogVersion>(*current, m_store, m_idIndex, m_pendingChanges);
+    std::atomic_store(&m_published, next);
+    m_pendingChanges = CatalogChangeSet();
+    return next->changesSince(current->version());
+}
+
+void AppManager::finishChange()
+{
+    // バッチ中は commit() まで公開・通知・ジャーナル書き込みを保留する
+    if (m_batchDepth > 0) {
+        return;
+    }
+    
+    if (!m_batchRecords.isEmpty()) {
+        commitToJournal(m_journal.appendRecords(m_batchRecords));
+        m_batchRecords.clear();
+    }
+    
+    CatalogChangeSet changes = publishSnapshot();
+    if (!changes.isEmpty()) {
+        // 外部の変更を取り込んだ分は既に apps.json にある
+        if (!m_applyingExternal) {
+            for (const QString &appId : changes.added() + changes.removed() + changes.updated()) {
+                m_unsavedIds.insert(appId);
+            }
+        }
+        emit catalogChanged(changes);
+    }
+}
+
+void AppManager::journal(const CatalogJournal::Record &record)
+{
+    // 書き込みは finishChange でまとめて行う（バッチ外では直後に1件だけ書かれる）
+    m_batchRecords.append(record);
+}
+
+void AppManager::schedulePublish()
+{
+    // 修復は1件ずつ届くので、版を作るたびに列が複製されないよう少し待ってまとめる
+    if (!m_publishTimer->isActive()) {
+        m_publishTimer->start();
+    }
+}
+
+void AppManager::onIconRepaired(const QString &appId, const QString &iconPath)
+{
+    int slot = m_idIndex.value(appId, -1);
+    if (slot < 0 || m_store.iconPath(slot) == iconPath) {
+        return;
+    }
+    
+    // 保存は修復がすべて終わった時点でまとめて1回行う
+    m_store.setIconPath(slot, iconPath);
+    m_pendingChanges.markUpdated(appId);
+    schedulePublish();
+    m_iconPathsDirty = true;
+    emit iconPathChanged(appId, iconPath);
+}
+
+void AppManager::onIconRepairFinished()
+{
+    finishChange();
+    if (m_iconPathsDirty) {
+        m_iconPathsDirty = false;
+        scheduleSave();
+    }
+}
+
 QString AppManager::getDefaultDataFilePath() const
 {
     // アプリケーション実行ディレクトリ下に直接保存
@@ -486,21 +1097,21 @@ CategoryManager* AppManager::getCategoryManager() const
 
 QStringList AppManager::getUsedCategories() const
 {
-    QStringList usedCategories;
-    for (const auto &app : m_apps) {
-        if (!usedCategories.contains(app.category)) {
-            usedCategories.append(app.category);
-        }
-    }
-    return usedCategories;
+    return m_searchIndex.categories();
 }
 
 void AppManager::updateAppCategory(const QString &appId, const QString &category)
 {
-    AppInfo *app = findApp(appId);
-    if (app) {
-        app->category = category;
-        emit appUpdated(*app);
-        saveApps();
+    int slot = m_idIndex.value(appId, -1);
+    if (slot >= 0) {
+        m_store.setCategory(slot, category);
+        m_searchIndex.updateCategory(appId, category);
+        m_pendingChanges.markUpdated(appId);
+        const AppInfo app = m_store.at(slot);
+        journal({CatalogJournal::OpUpdate, appId, app});
+        finishChange();
+        if (m_batchDepth == 0) {
+            emit appUpdated(app);
+        }
     }
 }
\ No newline at end of file
@@ -3,11 +3,25 @@
 
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QSet>
 #include <QString>
+#include <QDateTime>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include "appinfo.h"
+#include "appstore.h"
 #include "categorymanager.h"
+#include "catalogjournal.h"
+#include "searchindex.h"
+#include "searchsession.h"
+#include "frecencyindex.h"
+#include "catalogversion.h"
+#include "catalogsaver.h"
+
+class QTimer;
+class QFileSystemWatcher;
+class IconRepairQueue;
 
 class AppManager : public QObject
 {
@@ -22,11 +36,34 @@ public:
     int addApps(const QList<AppInfo> &apps); // 一括追加機能
     bool removeApp(const QString &appId);
     bool updateApp(const QString &appId, const AppInfo &updatedApp);
-    AppInfo* findApp(const QString &appId);
+    AppStore::Row findApp(const QString &appId) const;  // 次の変更まで有効な行ハンドル
+    int removeApps(const QStringList &appIds);          // 一括削除（削除した件数を返す）
+    int updateApps(const QList<AppInfo> &apps);         // IDごとに一括更新（更新した件数を返す）
+    
+    // 一括変更: beginBatch〜commit の間の変更は catalogChanged 1回・ジャーナル書き込み1回にまとめ、
+    // appAdded/appRemoved などの個別のシグナルは出さない（入れ子可）
+    void beginBatch();
+    void commit();
+    
+    class Batch
+    {
+    public:
+        explicit Batch(AppManager *manager);
+        ~Batch();
+        
+    private:
+        Q_DISABLE_COPY(Batch)
+        AppManager *m_manager;
+    };
     
     // データ取得
-    QList<AppInfo> getApps() const;
+    AppStore getStore() const;          // カタログのスナップショット（暗黙共有なので安価）
+    // 公開済みの不変な版（どのスレッドからでもロックなしで取得でき、保持している間は変わらない）
+    CatalogVersionPtr snapshot() const;
+    CatalogChangeSet changesSince(quint64 version) const;
+    QList<AppInfo> getApps() const;     // 全件を AppInfo に展開する（件数が多いと重い）
     QList<AppInfo> searchApps(const QString &keyword) const;
+    const SearchIndex &getSearchIndex() const;  // ワーカースレッドでの検索用（複製して渡す）
     QList<AppInfo> getAppsByCategory(const QString &category) const;
     QList<AppInfo> searchAppsInCategory(const QString &keyword, const QString &category) const;
     int getAppCount() const;
@@ -34,11 +71,21 @@ public:
     
     // データ永続化
     bool loadApps();
-    bool saveApps();
+    bool saveApps();        // 即座にバックグラウンド保存を開始
+    void scheduleSave();    // 遅延保存（連続した要求は1回にまとめる）
+    bool flush();           // 保留中の保存をすべて書き終えるまで待つ（終了処理用）
+    void setSaveDelay(int msec);
     
-    // 統計
-    AppInfo* getMostLaunchedApp();
-    AppInfo* getRecentlyLaunchedApp();
+    // アイコン修復（表示中の行を優先）
+    void prioritizeIconRepair(const QStringList &appIds);
+    
+    // 統計（索引の先頭を参照するのでO(1)）
+    AppStore::Row getMostLaunchedApp() const;
+    AppStore::Row getRecentlyLaunchedApp() const;
+    QVector<int> getFrecencyOrderedRows() const;   // getStore() 上の行をよく使う順に並べたもの
+    
+    // 起動の記録（AppLauncher::launched から呼ばれ、起動回数と最終起動時刻を進める）
+    void recordLaunch(const QString &appId);
     
     // カテゴリ管理
     CategoryManager* getCategoryManager() const;
@@ -48,10 +95,14 @@ public:
     // データファイル管理
     void setDataFilePath(const QString &filePath);
     QString getDataFilePath() const;
+    void setJournalCompactionThreshold(int threshold);
     
     // バリデーション
     bool validateAppData() const;
     void cleanupInvalidApps();
+    
+    // 重複判定用のパス正規化（区切り文字統一・小文字化）
+    static QString normalizePath(const QString &path);
 
 signals:
     void appAdded(const AppInfo &app);
@@ -60,12 +111,98 @@ signals:
     void appUpdated(const AppInfo &app);
     void dataLoaded();
     void dataSaved();
+    void iconPathChanged(const QString &appId, const QString &iconPath);
+    void launchRecorded(const QString &appId);
+    // 公開した版ごとに1回（バッチは commit 時にまとめて1回）。読み込み時は dataLoaded のみ
+    void catalogChanged(const CatalogChangeSet &changes);
+    // 他のプロセス・スクリプトによる apps.json の変更を取り込んだ（変更件数）
+    void externalChangesLoaded(int count);
 
 private:
-    QList<AppInfo> m_apps;
+    AppStore m_store;
     QString m_dataFilePath;
     CategoryManager *m_categoryManager;
     
+    // m_storeと同期するインデックス（ID/正規化パス → m_store内の行）
+    // IDの索引は公開する版と共有するので、変更時に一部だけが複製される分割ハッシュにする
+    ShardedHash<QString, int> m_idIndex;
+    QHash<QString, int> m_pathIndex;
+    
+    void indexApp(int slot);
+    void unindexApp(int slot);
+    void reindexFrom(int slot);
+    void rebuildIndexes();
+    
+    // 名前・説明・パスの部分一致検索用トライグラムインデックス（カテゴリ別の所属も持つ）
+    SearchIndex m_searchIndex;
+    mutable SearchSession m_searchSession;
+    
+    QList<AppInfo> appsForDocuments(const QVector<quint32> &docIds) const;
+    
+    // 起動回数・最終起動時刻の索引（よく使う順・最多起動・最近起動）
+    FrecencyIndex m_frecencyIndex;
+    
+    // 読み手に公開する版（std::atomic_load/atomic_store で差し替える）
+    CatalogVersionPtr m_published;
+    CatalogChangeSet m_pendingChanges;  // 次の版に含める変更
+    QTimer *m_publishTimer;             // アイコン修復など細かい変更の公開をまとめる
+    
+    CatalogChangeSet publishSnapshot();
+    void schedulePublish();
+    void finishChange();    // バッチ外なら版の公開・catalogChanged・ジャーナル書き込みを行う
+    
+    // 変更ジャーナル（追記＋fsync）
+    CatalogJournal m_journal;
+    
+    void commitToJournal(bool appended);
+    void journal(const CatalogJournal::Record &record);
+    void applyJournalRecord(const CatalogJournal::Record &record);
+    QString getJournalFilePath() const;
+    QStringList getJournalFilePaths() const;    // このカタログのすべてのプロセスのジャーナル
+    
+    // バイナリスナップショット（apps.jsonが更新されていなければJSON解析を省略）
+    bool loadFromSnapshot();
+    bool loadFromJson();
+    QString getSnapshotFilePath() const;
+    
+    // バックグラウンド保存（ジャーナルのマージも兼ねる）
+    CatalogSaver *m_saver;
+    QTimer *m_saveTimer;
+    
+    void submitSave();
+    void onSaveFinished(quint64 generation, CatalogSaver::Result result);
+    void restoreUnsaved();
+    
+    // 起動後のアイコン検証・再生成
+    IconRepairQueue *m_iconRepair;
+    bool m_iconPathsDirty;
+    
+    // 一括変更の入れ子の深さと、commit まで保留するジャーナルレコード
+    int m_batchDepth;
+    QList<CatalogJournal::Record> m_batchRecords;
+    
+    // 他のプロセス・スクリプトによる apps.json の変更の取り込み
+    QFileSystemWatcher *m_fileWatcher;
+    QTimer *m_reloadTimer;              // 書き込みが数回に分かれても1回の読み直しにまとめる
+    QDateTime m_knownModified;          // 最後に読んだ・書いた apps.json の更新時刻とサイズ
+    qint64 m_knownSize;
+    QSet<QString> m_unsavedIds;         // apps.json にまだ書いていない変更のあるアプリ
+    QSet<QString> m_savingIds;          // 書き込み中の保存に含まれる変更
+    bool m_applyingExternal;
+    bool m_resaveAfterReload;           // 競合した保存を、読み直しの後でやり直す
+    bool m_reloadInFlight;              // 保存スレッドで読み込み中
+    
+    void watchDataFile();
+    void rememberDataFile();
+    void onDataFileChanged(const QString &path);
+    void reloadExternalChanges();
+    void onExternalChangesRead(const CatalogSaver::ExternalChanges &changes);
+    void applyExternalChanges(const CatalogSaver::ExternalChanges &changes);
+    
+    void startIconRepair();
+    void onIconRepaired(const QString &appId, const QString &iconPath);
+    void onIconRepairFinished();
+    
     void initializeDataFile();
     QString getDefaultDataFilePath() const;
 };
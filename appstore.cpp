@@ -0,0 +1,530 @@
+#include "appstore.h"
+#include <QFileInfo>
+#include <QDebug>
+#include <limits>
+
+namespace {
+
+// 参照されなくなった文字がこれを超え、かつ使用中の分より多くなったらバッファを詰め直す
+const int CompactionMinimum = 4096;
+// 文字列バッファの1チャンクの文字数（これより長い文字列は専用のチャンクに置く）
+const int TextChunkShift = 15;
+const int TextChunkSize = 1 << TextChunkShift;
+// UUID形式でないIDを変換する際の名前空間
+const QUuid ForeignIdNamespace(0x6f1c2a4e, 0x3b7d, 0x4e52, 0x9a, 0x1f, 0x5c, 0x0d, 0x8e, 0x27, 0x41, 0xb3);
+
+// QString 1つ分のヒープ使用量の概算（ヘッダー＋UTF-16データ＋終端）
+qint64 stringHeapBytes(const QString &str)
+{
+    return str.isEmpty() ? 0 : 16 + (str.size() + 1) * 2;
+}
+
+int lastSeparator(QStringView path)
+{
+    return qMax(path.lastIndexOf(QLatin1Char('/')), path.lastIndexOf(QLatin1Char('\\')));
+}
+
+// QUuid::toString(QUuid::WithoutBraces) と同じ表記か（小文字の16進・ハイフン位置）
+bool isCanonicalUuid(QStringView id)
+{
+    if (id.size() != 36) {
+        return false;
+    }
+    for (int i = 0; i < id.size(); ++i) {
+        const QChar c = id.at(i);
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (c != QLatin1Char('-')) {
+                return false;
+            }
+        } else if (!((c >= QLatin1Char('0') && c <= QLatin1Char('9')) || (c >= QLatin1Char('a') && c <= QLatin1Char('f')))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+const qint64 AppStore::InvalidMSecs = std::numeric_limits<qint64>::min();
+
+// ---- Row ----
+
+AppStore::Row::Row()
+    : m_store(nullptr)
+    , m_index(-1)
+{
+}
+
+AppStore::Row::Row(const AppStore *store, int index)
+    : m_store(store)
+    , m_index(index)
+{
+}
+
+bool AppStore::Row::isValid() const
+{
+    return m_store && m_index >= 0 && m_index < m_store->size();
+}
+
+QString AppStore::Row::id() const { return m_store->id(m_index); }
+QString AppStore::Row::name() const { return m_store->name(m_index); }
+QString AppStore::Row::path() const { return m_store->path(m_index); }
+QString AppStore::Row::iconPath() const { return m_store->iconPath(m_index); }
+QString AppStore::Row::description() const { return m_store->description(m_index); }
+QString AppStore::Row::category() const { return m_store->category(m_index); }
+int AppStore::Row::launchCount() const { return m_store->launchCount(m_index); }
+QDateTime AppStore::Row::lastLaunch() const { return m_store->lastLaunch(m_index); }
+qint64 AppStore::Row::lastLaunchMSecs() const { return m_store->lastLaunchMSecs(m_index); }
+QDateTime AppStore::Row::createdAt() const { return m_store->createdAt(m_index); }
+
+bool AppStore::Row::fileExists() const
+{
+    const QString appPath = path();
+    return QFileInfo::exists(appPath) && QFileInfo(appPath).isExecutable();
+}
+
+AppInfo AppStore::Row::toAppInfo() const
+{
+    return m_store->at(m_index);
+}
+
+// ---- AppStore ----
+
+AppStore::AppStore()
+    : m_textLength(0)
+    , m_garbageLength(0)
+{
+}
+
+int AppStore::size() const
+{
+    return m_ids.size();
+}
+
+bool AppStore::isEmpty() const
+{
+    return m_ids.isEmpty();
+}
+
+void AppStore::clear()
+{
+    *this = AppStore();
+}
+
+void AppStore::reserve(int count)
+{
+    m_ids.reserve(count);
+    m_names.reserve(count);
+    m_descriptions.reserve(count);
+    m_directories.reserve(count);
+    m_fileNames.reserve(count);
+    m_iconDirectories.reserve(count);
+    m_iconFileNames.reserve(count);
+    m_categories.reserve(count);
+    m_launchCounts.reserve(count);
+    m_lastLaunches.reserve(count);
+    m_createdAts.reserve(count);
+}
+
+AppStore::Row AppStore::row(int index) const
+{
+    return Row(this, index);
+}
+
+AppInfo AppStore::at(int index) const
+{
+    AppInfo app;
+    app.id = id(index);
+    app.name = name(index);
+    app.path = path(index);
+    app.iconPath = iconPath(index);
+    app.description = description(index);
+    app.category = category(index);
+    app.launchCount = launchCount(index);
+    app.lastLaunch = lastLaunch(index);
+    app.createdAt = createdAt(index);
+    return app;
+}
+
+QList<AppInfo> AppStore::toList() const
+{
+    QList<AppInfo> apps;
+    apps.reserve(size());
+    for (int i = 0; i < size(); ++i) {
+        apps.append(at(i));
+    }
+    return apps;
+}
+
+void AppStore::append(const AppInfo &app)
+{
+    quint32 directory;
+    TextRef fileName;
+    splitPath(app.path, &directory, &fileName);
+    quint32 iconDirectory;
+    TextRef iconFileName;
+    splitPath(app.iconPath, &iconDirectory, &iconFileName);
+
+    m_ids.append(encodeId(app.id));
+    m_names.append(appendText(app.name));
+    m_descriptions.append(appendText(app.description));
+    m_directories.append(directory);
+    m_fileNames.append(fileName);
+    m_iconDirectories.append(iconDirectory);
+    m_iconFileNames.append(iconFileName);
+    m_categories.append(internCategory(app.category));
+    m_launchCounts.append(app.launchCount);
+    m_lastLaunches.append(dateToMSecs(app.lastLaunch));
+    m_createdAts.append(dateToMSecs(app.createdAt));
+}
+
+void AppStore::append(const RawRecord &record)
+{
+    quint32 directory;
+    TextRef fileName;
+    splitPath(record.path, &directory, &fileName);
+    quint32 iconDirectory;
+    TextRef iconFileName;
+    splitPath(record.iconPath, &iconDirectory, &iconFileName);
+
+    m_ids.append(encodeId(record.id));
+    m_names.append(appendText(record.name));
+    m_descriptions.append(appendText(record.description));
+    m_directories.append(directory);
+    m_fileNames.append(fileName);
+    m_iconDirectories.append(iconDirectory);
+    m_iconFileNames.append(iconFileName);
+    m_categories.append(internCategory(record.category));
+    m_launchCounts.append(record.launchCount);
+    m_lastLaunches.append(record.lastLaunchMSecs);
+    m_createdAts.append(record.createdAtMSecs);
+}
+
+void AppStore::replace(int index, const AppInfo &app)
+{
+    releaseText(index);
+
+    m_ids[index] = encodeId(app.id);
+    m_names[index] = appendText(app.name);
+    m_descriptions[index] = appendText(app.description);
+    splitPath(app.path, &m_directories[index], &m_fileNames[index]);
+    splitPath(app.iconPath, &m_iconDirectories[index], &m_iconFileNames[index]);
+    m_categories[index] = internCategory(app.category);
+    m_launchCounts[index] = app.launchCount;
+    m_lastLaunches[index] = dateToMSecs(app.lastLaunch);
+    m_createdAts[index] = dateToMSecs(app.createdAt);
+    compactIfNeeded();
+}
+
+void AppStore::removeAt(int index)
+{
+    releaseText(index);
+
+    // 詰めるのは index を含むチャンクから後ろだけ
+    m_ids.removeAt(index);
+    m_names.removeAt(index);
+    m_descriptions.removeAt(index);
+    m_directories.removeAt(index);
+    m_fileNames.removeAt(index);
+    m_iconDirectories.removeAt(index);
+    m_iconFileNames.removeAt(index);
+    m_categories.removeAt(index);
+    m_launchCounts.removeAt(index);
+    m_lastLaunches.removeAt(index);
+    m_createdAts.removeAt(index);
+    compactIfNeeded();
+}
+
+void AppStore::removeRows(const QVector<int> &indexes)
+{
+    if (indexes.isEmpty()) {
+        return;
+    }
+
+    // 1件ずつ removeAt すると列ごとに後続の要素が毎回ずれるので、まとめて1回で詰める
+    QVector<bool> marked(size(), false);
+    for (int index : indexes) {
+        if (index >= 0 && index < size() && !marked.at(index)) {
+            marked[index] = true;
+            releaseText(index);
+        }
+    }
+
+    m_ids.removeMarked(marked);
+    m_names.removeMarked(marked);
+    m_descriptions.removeMarked(marked);
+    m_directories.removeMarked(marked);
+    m_fileNames.removeMarked(marked);
+    m_iconDirectories.removeMarked(marked);
+    m_iconFileNames.removeMarked(marked);
+    m_categories.removeMarked(marked);
+    m_launchCounts.removeMarked(marked);
+    m_lastLaunches.removeMarked(marked);
+    m_createdAts.removeMarked(marked);
+    compactIfNeeded();
+}
+
+void AppStore::setIconPath(int index, const QString &iconPath)
+{
+    m_garbageLength += m_iconFileNames.at(index).length;
+    splitPath(iconPath, &m_iconDirectories[index], &m_iconFileNames[index]);
+    compactIfNeeded();
+}
+
+void AppStore::setCategory(int index, const QString &category)
+{
+    m_categories[index] = internCategory(category);
+}
+
+void AppStore::recordLaunch(int index, const QDateTime &launchedAt)
+{
+    ++m_launchCounts[index];
+    m_lastLaunches[index] = dateToMSecs(launchedAt);
+}
+
+QString AppStore::id(int index) const
+{
+    const QUuid &uuid = m_ids.at(index);
+    if (!m_foreignIds.isEmpty()) {
+        auto it = m_foreignIds.constFind(uuid);
+        if (it != m_foreignIds.constEnd()) {
+            return it.value();
+        }
+    }
+    return uuid.toString(QUuid::WithoutBraces);
+}
+
+QString AppStore::name(int index) const
+{
+    return textOf(m_names.at(index)).toString();
+}
+
+QString AppStore::path(int index) const
+{
+    return joinPath(m_directories.at(index), m_fileNames.at(index));
+}
+
+QString AppStore::iconPath(int index) const
+{
+    return joinPath(m_iconDirectories.at(index), m_iconFileNames.at(index));
+}
+
+QString AppStore::description(int index) const
+{
+    return textOf(m_descriptions.at(index)).toString();
+}
+
+QString AppStore::category(int index) const
+{
+    return m_categoryNames.strings.at(m_categories.at(index));
+}
+
+int AppStore::launchCount(int index) const
+{
+    return m_launchCounts.at(index);
+}
+
+qint64 AppStore::lastLaunchMSecs(int index) const
+{
+    return m_lastLaunches.at(index);
+}
+
+QDateTime AppStore::lastLaunch(int index) const
+{
+    return dateFromMSecs(m_lastLaunches.at(index));
+}
+
+QDateTime AppStore::createdAt(int index) const
+{
+    return dateFromMSecs(m_createdAts.at(index));
+}
+
+AppStore::MemoryReport AppStore::memoryReport() const
+{
+    MemoryReport report;
+    report.count = size();
+    report.fixedColumns =
+        m_ids.capacity() * qint64(sizeof(QUuid)) +
+        (m_names.capacity() + m_descriptions.capacity() + m_fileNames.capacity() +
+         m_iconFileNames.capacity()) * qint64(sizeof(TextRef)) +
+        (m_directories.capacity() + m_iconDirectories.capacity()) * qint64(sizeof(quint32)) +
+        m_categories.capacity() * qint64(sizeof(quint16)) +
+        m_launchCounts.capacity() * qint64(sizeof(qint32)) +
+        (m_lastLaunches.capacity() + m_createdAts.capacity()) * qint64(sizeof(qint64));
+    for (const QString &chunk : m_textChunks) {
+        report.textBuffer += qint64(chunk.capacity()) * 2;
+    }
+    for (int i = 0; i < m_prefixes.strings.size(); ++i) {
+        report.sharedStrings += stringHeapBytes(m_prefixes.strings.at(i)) * 2;   // 表と逆引きハッシュのキー
+    }
+    for (int i = 0; i < m_categoryNames.strings.size(); ++i) {
+        report.sharedStrings += stringHeapBytes(m_categoryNames.strings.at(i)) * 2;
+    }
+    for (auto it = m_foreignIds.constBegin(); it != m_foreignIds.constEnd(); ++it) {
+        report.sharedStrings += sizeof(QUuid) + stringHeapBytes(it.value());
+    }
+    report.total = report.fixedColumns + report.textBuffer + report.sharedStrings;
+
+    // 比較用: 各行を AppInfo に展開した場合（文字列はそれぞれ別のヒープ領域を持つ）
+    for (int i = 0; i < size(); ++i) {
+        const AppInfo app = at(i);
+        report.appInfoEquivalent += sizeof(AppInfo) +
+            stringHeapBytes(app.id) + stringHeapBytes(app.name) + stringHeapBytes(app.path) +
+            stringHeapBytes(app.iconPath) + stringHeapBytes(app.description) +
+            stringHeapBytes(app.category);
+    }
+    return report;
+}
+
+AppStore::StringPool::StringPool(const StringPool &other)
+    : strings(other.strings)
+    , indexed(other.strings.isEmpty())
+{
+}
+
+AppStore::StringPool &AppStore::StringPool::operator=(const StringPool &other)
+{
+    strings = other.strings;
+    ids.clear();
+    indexed = other.strings.isEmpty();
+    return *this;
+}
+
+quint32 AppStore::StringPool::intern(QStringView str)
+{
+    if (!indexed) {
+        ids.reserve(strings.size());
+        for (int i = 0; i < strings.size(); ++i) {
+            ids.insert(strings.at(i), quint32(i));
+        }
+        indexed = true;
+    }
+
+    // 登録済みかどうかは複製せずに引く（見つからなかったときだけ文字列を作る）
+    auto it = ids.constFind(QString::fromRawData(str.data(), str.size()));
+    if (it != ids.constEnd()) {
+        return it.value();
+    }
+    const QString copy = str.toString();
+    const quint32 id = strings.size();
+    strings.append(copy);
+    ids.insert(copy, id);
+    return id;
+}
+
+AppStore::TextRef AppStore::appendText(QStringView text)
+{
+    if (text.isEmpty()) {
+        return TextRef{0, 0};
+    }
+
+    // 末尾のチャンクに収まらなければ新しいチャンクを始める（文字列はチャンクをまたがない）
+    if (m_textChunks.isEmpty() || m_textChunks.last().size() + text.size() > TextChunkSize) {
+        m_textChunks.append(QString());
+        m_textChunks.last().reserve(qMax(TextChunkSize, int(text.size())));
+    }
+    QString &chunk = m_textChunks.last();
+    const quint32 offset = (quint32(m_textChunks.size() - 1) << TextChunkShift) | quint32(chunk.size());
+    chunk.append(text);
+    m_textLength += text.size();
+    return TextRef{offset, quint32(text.size())};
+}
+
+QStringView AppStore::textOf(TextRef ref) const
+{
+    if (ref.length == 0) {
+        return QStringView();
+    }
+    const QString &chunk = m_textChunks.at(ref.offset >> TextChunkShift);
+    return QStringView(chunk).mid(ref.offset & (TextChunkSize - 1), ref.length);
+}
+
+QString AppStore::joinPath(quint32 prefix, TextRef fileName) const
+{
+    const QString &directory = m_prefixes.strings.at(prefix);
+    QString result;
+    result.reserve(directory.size() + fileName.length);
+    result.append(directory);
+    result.append(textOf(fileName));
+    return result;
+}
+
+void AppStore::splitPath(QStringView path, quint32 *prefix, TextRef *fileName)
+{
+    // 区切り文字までをディレクトリとして共有し、残りをファイル名として持つ（連結すれば元に戻る）
+    const int split = lastSeparator(path) + 1;
+    *prefix = m_prefixes.intern(path.left(split));
+    *fileName = appendText(path.mid(split));
+}
+
+QUuid AppStore::encodeId(QStringView id)
+{
+    if (isCanonicalUuid(id)) {
+        const QUuid uuid = QUuid::fromString(id);
+        if (!uuid.isNull()) {
+            return uuid;
+        }
+    }
+
+    // 手で編集されたデータなどUUID形式でないIDは、そこから導いたUUIDで持ち元の文字列を残す
+    const QString original = id.toString();
+    const QUuid derived = QUuid::createUuidV5(ForeignIdNamespace, original);
+    if (!m_foreignIds.contains(derived)) {
+        m_foreignIds.insert(derived, original);
+    }
+    return derived;
+}
+
+quint16 AppStore::internCategory(QStringView category)
+{
+    const quint32 id = m_categoryNames.intern(category);
+    if (id > std::numeric_limits<quint16>::max()) {
+        qWarning() << "AppStore: too many categories, falling back to the first one:" << category;
+        return 0;
+    }
+    return quint16(id);
+}
+
+void AppStore::releaseText(int index)
+{
+    m_garbageLength += m_names.at(index).length + m_descriptions.at(index).length +
+                       m_fileNames.at(index).length + m_iconFileNames.at(index).length;
+}
+
+void AppStore::compactIfNeeded()
+{
+    const int liveLength = m_textLength - m_garbageLength;
+    if (m_garbageLength < CompactionMinimum || m_garbageLength <= liveLength) {
+        return;
+    }
+
+    // 使用中の文字列だけを行順に詰め直す
+    const QVector<QString> chunks = m_textChunks;
+    m_textChunks.clear();
+    m_textLength = 0;
+    auto move = [this, &chunks](ChunkedVector<TextRef> &column) {
+        for (int i = 0; i < column.size(); ++i) {
+            const TextRef ref = column.at(i);
+            if (ref.length == 0) {
+                continue;
+            }
+            const QString &chunk = chunks.at(ref.offset >> TextChunkShift);
+            column[i] = appendText(QStringView(chunk).mid(ref.offset & (TextChunkSize - 1), ref.length));
+        }
+    };
+    move(m_names);
+    move(m_descriptions);
+    move(m_fileNames);
+    move(m_iconFileNames);
+    m_garbageLength = 0;
+}
+
+qint64 AppStore::dateToMSecs(const QDateTime &dateTime)
+{
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : InvalidMSecs;
+}
+
+QDateTime AppStore::dateFromMSecs(qint64 msecs)
+{
+    return msecs == InvalidMSecs ? QDateTime() : QDateTime::fromMSecsSinceEpoch(msecs);
+}
@@ -0,0 +1,171 @@
+#ifndef APPSTORE_H
+#define APPSTORE_H
+
+#include <QString>
+#include <QStringView>
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include <QUuid>
+#include <QDateTime>
+#include "appinfo.h"
+#include "chunkedvector.h"
+
+// アプリ一覧を列ごとに保持するカタログ（AppInfo のリストの代わり）
+//
+// - IDは128ビットのUUIDのまま、日時はエポックからのミリ秒で持つ
+// - 名前・説明・ファイル名は文字列バッファに詰め、位置と長さだけを持つ
+// - パスは「ディレクトリ＋ファイル名」に分け、ディレクトリとカテゴリは共有の文字列表に登録して番号で参照する
+// 列・文字列バッファ・文字列表はどれもチャンク単位の暗黙共有なので、ストアの複製は安価なスナップショットになる。
+// 複製後の変更で複製されるのは書き換えたチャンクだけ（1件の変更で全体が複製されることはない）。
+// ビューは Row ハンドルを通して必要な列だけを読み、AppInfo への展開は編集・保存時に限る。
+class AppStore
+{
+public:
+    // 行ハンドル（ストアを変更すると無効になるので、保持せずにその場で読むこと）
+    class Row
+    {
+    public:
+        Row();
+        Row(const AppStore *store, int index);
+
+        bool isValid() const;
+        explicit operator bool() const { return isValid(); }
+        int index() const { return m_index; }
+
+        QString id() const;
+        QString name() const;
+        QString path() const;
+        QString iconPath() const;
+        QString description() const;
+        QString category() const;
+        int launchCount() const;
+        QDateTime lastLaunch() const;
+        qint64 lastLaunchMSecs() const;
+        QDateTime createdAt() const;
+        bool fileExists() const;
+        AppInfo toAppInfo() const;
+
+    private:
+        const AppStore *m_store;
+        int m_index;
+    };
+
+    // 使用メモリの内訳（バイト数の概算）
+    struct MemoryReport {
+        int count = 0;
+        qint64 fixedColumns = 0;    // 行ごとの固定長の列
+        qint64 textBuffer = 0;      // 名前・説明・ファイル名のバッファ
+        qint64 sharedStrings = 0;   // ディレクトリ・カテゴリの文字列表
+        qint64 total = 0;
+        qint64 appInfoEquivalent = 0;   // 同じ内容を QList<AppInfo> で持った場合
+    };
+
+    // 読み込み用の1行（文字列は append 中だけ有効なビューでよい。日時はミリ秒で、未設定は InvalidMSecs）
+    struct RawRecord {
+        QStringView id;
+        QStringView name;
+        QStringView path;
+        QStringView iconPath;
+        QStringView description;
+        QStringView category;
+        qint32 launchCount;
+        qint64 lastLaunchMSecs;
+        qint64 createdAtMSecs;
+    };
+
+    AppStore();
+
+    int size() const;
+    bool isEmpty() const;
+    void clear();
+    void reserve(int count);
+
+    Row row(int index) const;
+    AppInfo at(int index) const;
+    QList<AppInfo> toList() const;
+
+    // 変更
+    void append(const AppInfo &app);
+    void append(const RawRecord &record);           // AppInfo を経由せずに列へ詰める
+    void replace(int index, const AppInfo &app);
+    void removeAt(int index);
+    void removeRows(const QVector<int> &indexes);   // 複数行を1回で削除（順不同）
+    void setIconPath(int index, const QString &iconPath);
+    void setCategory(int index, const QString &category);
+    void recordLaunch(int index, const QDateTime &launchedAt);
+
+    // 列の参照
+    QString id(int index) const;
+    QString name(int index) const;
+    QString path(int index) const;
+    QString iconPath(int index) const;
+    QString description(int index) const;
+    QString category(int index) const;
+    int launchCount(int index) const;
+    qint64 lastLaunchMSecs(int index) const;    // 未起動は InvalidMSecs
+    QDateTime lastLaunch(int index) const;
+    QDateTime createdAt(int index) const;
+
+    MemoryReport memoryReport() const;
+
+    static const qint64 InvalidMSecs;
+
+private:
+    struct TextRef {
+        quint32 offset;
+        quint32 length;
+    };
+
+    // 重複の多い文字列（ディレクトリ・カテゴリ）の共有表。登録した文字列は消さない
+    // 逆引きのハッシュは複製先に渡さず、複製先で登録するときに作り直す
+    // （版として公開した複製とハッシュを共有すると、書き手の次の登録で全体が複製されるため）
+    struct StringPool {
+        ChunkedVector<QString> strings;
+        QHash<QString, quint32> ids;
+        bool indexed = true;
+
+        StringPool() = default;
+        StringPool(const StringPool &other);
+        StringPool(StringPool &&other) = default;
+        StringPool &operator=(const StringPool &other);
+        StringPool &operator=(StringPool &&other) = default;
+
+        quint32 intern(QStringView str);
+    };
+
+    ChunkedVector<QUuid> m_ids;
+    ChunkedVector<TextRef> m_names;
+    ChunkedVector<TextRef> m_descriptions;
+    ChunkedVector<quint32> m_directories;      // パスのディレクトリ部分（末尾の区切り文字を含む）
+    ChunkedVector<TextRef> m_fileNames;
+    ChunkedVector<quint32> m_iconDirectories;
+    ChunkedVector<TextRef> m_iconFileNames;
+    ChunkedVector<quint16> m_categories;
+    ChunkedVector<qint32> m_launchCounts;
+    ChunkedVector<qint64> m_lastLaunches;
+    ChunkedVector<qint64> m_createdAts;
+
+    // 名前・説明・ファイル名を連結したバッファ（追記先は末尾のチャンクだけ）
+    // TextRef::offset の上位ビットがチャンク番号、下位 TextChunkShift ビットがチャンク内の位置
+    QVector<QString> m_textChunks;
+    int m_textLength;                   // 全チャンクの文字数
+    int m_garbageLength;                // 置き換え・削除で参照されなくなった文字数
+    StringPool m_prefixes;              // パス・アイコンパスのディレクトリ
+    StringPool m_categoryNames;
+    QHash<QUuid, QString> m_foreignIds; // UUID形式でない既存のID（UUID v5 → 元の文字列）
+
+    TextRef appendText(QStringView text);
+    QStringView textOf(TextRef ref) const;
+    QString joinPath(quint32 prefix, TextRef fileName) const;
+    void splitPath(QStringView path, quint32 *prefix, TextRef *fileName);
+    QUuid encodeId(QStringView id);
+    quint16 internCategory(QStringView category);
+    void releaseText(int index);
+    void compactIfNeeded();
+
+    static qint64 dateToMSecs(const QDateTime &dateTime);
+    static QDateTime dateFromMSecs(qint64 msecs);
+};
+
+#endif // APPSTORE_H
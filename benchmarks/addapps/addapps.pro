@@ -0,0 +1,8 @@
+# AppManager::addApps が件数に対して線形に伸びることを確かめるベンチマーク
+
+TARGET = addapps_bench
+
+include(../catalog.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,105 @@
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <cstdio>
+#include <limits>
+#include "appmanager.h"
+
+// AppManager::addApps の計測
+//
+// 1. 空のカタログに N 件を一括追加する（N を倍にしていく）
+// 2. N 件のカタログに、検出結果 5000 件を取り込む
+// どちらも1000件あたりの時間がほぼ一定なら、重複チェックを含めて線形に伸びている。
+
+namespace {
+
+const int Repeats = 3;
+const int ImportCount = 5000;
+
+void quietMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    Q_UNUSED(context)
+    // addApps は1件ごとに qDebug を出すので、計測中は警告以上だけを表示する
+    if (type == QtDebugMsg || type == QtInfoMsg) {
+        return;
+    }
+    std::fprintf(stderr, "%s\n", qPrintable(message));
+}
+
+QList<AppInfo> makeApps(int first, int count)
+{
+    static const char *const categories[] = {"ゲーム", "開発", "ビジネス", "メディア", "ツール", "その他"};
+
+    QList<AppInfo> apps;
+    apps.reserve(count);
+    for (int i = first; i < first + count; ++i) {
+        AppInfo app(QString("Sample Application %1").arg(i),
+                    QString("C:/Program Files/Vendor %1/Product %2/bin/app%2.exe").arg(i % 97).arg(i));
+        app.description = QString("Synthetic entry number %1").arg(i);
+        app.category = QString::fromUtf8(categories[i % 6]);
+        apps.append(app);
+    }
+    return apps;
+}
+
+// existing 件のカタログに added 件を addApps で追加する時間（ナノ秒、最良値）
+qint64 measure(const QString &directory, int existing, int added)
+{
+    qint64 best = std::numeric_limits<qint64>::max();
+    for (int run = 0; run < Repeats; ++run) {
+        AppManager manager;
+        manager.setDataFilePath(QDir(directory).filePath(QString("apps_%1_%2_%3.json").arg(existing).arg(added).arg(run)));
+        if (existing > 0) {
+            manager.addApps(makeApps(0, existing));
+        }
+
+        const QList<AppInfo> incoming = makeApps(existing, added);
+        QElapsedTimer timer;
+        timer.start();
+        const int count = manager.addApps(incoming);
+        best = qMin(best, timer.nsecsElapsed());
+
+        if (count != added) {
+            std::fprintf(stderr, "addApps added %d of %d apps\n", count, added);
+        }
+    }
+    return best;
+}
+
+void report(QTextStream &out, const QString &label, int added, qint64 nsecs)
+{
+    const double msecs = nsecs / 1e6;
+    out << label.leftJustified(24) << QString::number(msecs, 'f', 2).rightJustified(10) << " ms"
+        << QString::number(msecs * 1000.0 / added, 'f', 3).rightJustified(10) << " ms/1000 apps\n";
+    out.flush();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    qInstallMessageHandler(quietMessageHandler);
+
+    QTemporaryDir directory;
+    if (!directory.isValid()) {
+        std::fprintf(stderr, "Cannot create a temporary directory\n");
+        return 1;
+    }
+
+    QTextStream out(stdout);
+
+    out << "addApps into an empty catalog\n";
+    for (int count : {2500, 5000, 10000, 20000, 40000, 80000}) {
+        report(out, QString("%1 apps").arg(count), count, measure(directory.path(), 0, count));
+    }
+
+    out << "\naddApps of " << ImportCount << " discovered apps into an existing catalog\n";
+    for (int existing : {0, 5000, 10000, 20000, 40000, 80000}) {
+        report(out, QString("catalog of %1").arg(existing), ImportCount,
+               measure(directory.path(), existing, ImportCount));
+    }
+    return 0;
+}
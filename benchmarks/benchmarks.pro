@@ -0,0 +1,10 @@
+# カタログ処理のベンチマーク（アプリ本体とは別にビルドする）
+#   qmake benchmarks.pro && make
+# addapps は QApplication を使うので、画面の無い環境では -platform offscreen を付けて実行する。
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    addapps \
+    fuzzysearch \
+    categoryclassifier
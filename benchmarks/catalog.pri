@@ -0,0 +1,51 @@
+# ベンチマークが使うカタログ関連のソース（アプリ本体と同じファイルをそのままビルドする）
+
+QT       += core gui widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS += -Wno-reorder
+
+win32: LIBS += -lgdi32 -lshell32 -luser32
+
+INCLUDEPATH += $$PWD/..
+DEPENDPATH += $$PWD/..
+
+SOURCES += \
+    $$PWD/../appinfo.cpp \
+    $$PWD/../appstore.cpp \
+    $$PWD/../appmanager.cpp \
+    $$PWD/../catalogjournal.cpp \
+    $$PWD/../filelock.cpp \
+    $$PWD/../catalogsaver.cpp \
+    $$PWD/../catalogjson.cpp \
+    $$PWD/../iconrepairqueue.cpp \
+    $$PWD/../searchindex.cpp \
+    $$PWD/../searchsession.cpp \
+    $$PWD/../fuzzymatcher.cpp \
+    $$PWD/../frecencyindex.cpp \
+    $$PWD/../catalogsnapshot.cpp \
+    $$PWD/../catalogversion.cpp \
+    $$PWD/../iconextractor.cpp \
+    $$PWD/../categorymanager.cpp
+
+HEADERS += \
+    $$PWD/../appinfo.h \
+    $$PWD/../appstore.h \
+    $$PWD/../chunkedvector.h \
+    $$PWD/../shardedhash.h \
+    $$PWD/../appmanager.h \
+    $$PWD/../catalogjournal.h \
+    $$PWD/../filelock.h \
+    $$PWD/../catalogsaver.h \
+    $$PWD/../catalogjson.h \
+    $$PWD/../iconrepairqueue.h \
+    $$PWD/../searchindex.h \
+    $$PWD/../searchsession.h \
+    $$PWD/../fuzzymatcher.h \
+    $$PWD/../frecencyindex.h \
+    $$PWD/../catalogsnapshot.h \
+    $$PWD/../catalogversion.h \
+    $$PWD/../iconextractor.h \
+    $$PWD/../categorymanager.h
@@ -0,0 +1,14 @@
+# CategoryClassifier::classify と以前のキーワード一覧による判定を比べるベンチマーク
+
+TARGET = categoryclassifier_bench
+
+include(../catalog.pri)
+
+SOURCES += \
+    $$PWD/../../keywordautomaton.cpp \
+    $$PWD/../../categoryclassifier.cpp \
+    main.cpp
+
+HEADERS += \
+    $$PWD/../../keywordautomaton.h \
+    $$PWD/../../categoryclassifier.h
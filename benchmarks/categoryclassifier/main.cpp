@@ -0,0 +1,181 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <cstdio>
+#include <limits>
+#include "categoryclassifier.h"
+
+// カテゴリ判定の計測
+//
+// Program Files・Steam・AppData 風のパスを生成し、以前の AppDiscovery::guessCategory
+// （呼び出しごとにキーワード一覧を作り、一覧の順に name / path を contains で調べる）と
+// CategoryClassifier::classify（1つのオートマトンで名前とパスを1回ずつ走査）の時間を比べる。
+// 判定結果が食い違った件数も表示する（大文字を含むキーワードの扱いなど、意図した差分のみのはず）。
+
+namespace {
+
+const int Repeats = 5;
+
+void quietMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    Q_UNUSED(context)
+    if (type == QtDebugMsg || type == QtInfoMsg) {
+        return;
+    }
+    std::fprintf(stderr, "%s\n", qPrintable(message));
+}
+
+// 以前の実装（比較用にそのまま移したもの）
+QString legacyGuessCategory(const QString &name, const QString &path)
+{
+    const QStringList game = QStringList() << "game" << "steam" << "epic" << "gog" << "origin"
+                                           << "uplay" << "battle.net" << "minecraft" << "unity"
+                                           << "unreal" << "fps" << "rpg" << "mmo" << "arcade";
+    for (const QString &keyword : game) {
+        if (name.contains(keyword) || path.contains(keyword)) {
+            return "ゲーム";
+        }
+    }
+    const QStringList development = QStringList() << "visual studio" << "code" << "dev" << "git"
+                                                  << "python" << "java" << "node" << "npm" << "compiler"
+                                                  << "debugger" << "ide" << "editor" << "qt" << "android studio";
+    for (const QString &keyword : development) {
+        if (name.contains(keyword) || path.contains(keyword)) {
+            return "開発";
+        }
+    }
+    const QStringList business = QStringList() << "office" << "word" << "excel" << "powerpoint"
+                                               << "outlook" << "teams" << "zoom" << "skype" << "slack"
+                                               << "adobe" << "acrobat" << "reader" << "calculator";
+    for (const QString &keyword : business) {
+        if (name.contains(keyword) || path.contains(keyword)) {
+            return "ビジネス";
+        }
+    }
+    const QStringList media = QStringList() << "vlc" << "media" << "player" << "music" << "video"
+                                            << "photo" << "image" << "audio" << "spotify" << "iTunes"
+                                            << "photoshop" << "premiere" << "audacity" << "gimp";
+    for (const QString &keyword : media) {
+        if (name.contains(keyword) || path.contains(keyword)) {
+            return "メディア";
+        }
+    }
+    const QStringList tools = QStringList() << "tool" << "utility" << "manager" << "browser"
+                                            << "chrome" << "firefox" << "explorer" << "notepad"
+                                            << "archive" << "zip" << "rar" << "antivirus" << "clean";
+    for (const QString &keyword : tools) {
+        if (name.contains(keyword) || path.contains(keyword)) {
+            return "ツール";
+        }
+    }
+    return "その他";
+}
+
+struct Sample {
+    QString name;
+    QString path;
+};
+
+QList<Sample> makeSamples(int count)
+{
+    static const char *const vendors[] = {
+        "Adobe", "JetBrains", "Mozilla", "VideoLAN", "Microsoft Office", "7-Zip", "Audacity",
+        "Blender Foundation", "Notepad++", "Oracle", "Python312", "Zoom", "Valve", "Contoso"
+    };
+    static const char *const products[] = {
+        "Photoshop", "CLion", "Firefox", "VLC", "EXCEL", "7zFM", "audacity", "blender",
+        "notepad++", "VirtualBox", "pythonw", "Zoom", "hl2", "Invoice Builder", "Setup Helper"
+    };
+    static const char *const games[] = {
+        "Portal 2", "Hollow Knight", "Terraria", "Stardew Valley", "Celeste", "Factorio"
+    };
+
+    QList<Sample> samples;
+    samples.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const QString product = QString::fromLatin1(products[i % 15]);
+        Sample sample;
+        switch (i % 3) {
+        case 0:
+            sample.path = QString("C:\\Program Files\\%1\\%2 %3\\%2.exe")
+                    .arg(QString::fromLatin1(vendors[i % 14]), product).arg(i % 40);
+            break;
+        case 1: {
+            const QString game = QString::fromLatin1(games[i % 6]);
+            sample.path = QString("D:\\SteamLibrary\\steamapps\\common\\%1\\bin\\win64\\%2.exe")
+                    .arg(game, QString(game).remove(' '));
+            break;
+        }
+        default:
+            sample.path = QString("C:\\Users\\user%1\\AppData\\Local\\Programs\\%2\\%2.exe")
+                    .arg(i % 50).arg(product);
+            break;
+        }
+        sample.name = sample.path.section('\\', -1);
+        samples.append(sample);
+    }
+    return samples;
+}
+
+template <typename Classify>
+qint64 measure(const QList<Sample> &samples, Classify classify, QStringList *results)
+{
+    qint64 best = std::numeric_limits<qint64>::max();
+    for (int run = 0; run < Repeats; ++run) {
+        QStringList categories;
+        categories.reserve(samples.size());
+        QElapsedTimer timer;
+        timer.start();
+        for (const Sample &sample : samples) {
+            categories.append(classify(sample));
+        }
+        best = qMin(best, timer.nsecsElapsed());
+        *results = categories;
+    }
+    return best;
+}
+
+void report(QTextStream &out, const QString &label, qint64 nsecs, int count)
+{
+    out << "  " << label.leftJustified(24) << QString::number(nsecs / 1e6, 'f', 2).rightJustified(10) << " ms"
+        << QString::number(double(nsecs) / count, 'f', 0).rightJustified(10) << " ns/path\n";
+    out.flush();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    qInstallMessageHandler(quietMessageHandler);
+
+    QTextStream out(stdout);
+    const CategoryClassifier classifier;
+
+    for (int count : {1000, 10000, 100000}) {
+        const QList<Sample> samples = makeSamples(count);
+        out << "\n" << count << " paths\n";
+
+        // 以前の呼び出し元（detectCategory）と同じく小文字化してから判定する
+        QStringList legacy;
+        const qint64 legacyTime = measure(samples, [](const Sample &sample) {
+            return legacyGuessCategory(sample.name.toLower(), sample.path.toLower());
+        }, &legacy);
+        report(out, "keyword lists", legacyTime, count);
+
+        QStringList compiled;
+        const qint64 compiledTime = measure(samples, [&classifier](const Sample &sample) {
+            return classifier.classify(sample.name, sample.path);
+        }, &compiled);
+        report(out, "CategoryClassifier", compiledTime, count);
+
+        int differences = 0;
+        for (int i = 0; i < count; ++i) {
+            if (legacy.at(i) != compiled.at(i)) {
+                ++differences;
+            }
+        }
+        out << "  " << differences << " paths classified differently\n";
+    }
+    return 0;
+}
@@ -0,0 +1,8 @@
+# あいまい検索（FuzzyMatcher）と部分一致検索（SearchIndex）を件数ごとに比べるベンチマーク
+
+TARGET = fuzzysearch_bench
+
+include(../catalog.pri)
+
+SOURCES += \
+    main.cpp
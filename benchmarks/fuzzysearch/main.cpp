@@ -0,0 +1,101 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <cstdio>
+#include <limits>
+#include "appstore.h"
+#include "searchindex.h"
+#include "fuzzymatcher.h"
+
+// あいまい検索と部分一致検索の計測
+//
+// 1万・10万・100万件の名前で SearchIndex を作り、同じ検索語について
+// SearchIndex::searchDocuments（部分一致）と FuzzyMatcher::search（上位 FuzzyLimit 件）の時間を比べる。
+// 部分一致はトライグラムで候補を絞れるが、あいまい検索は全件を採点するので件数に比例する。
+
+namespace {
+
+const int Repeats = 5;
+const int FuzzyLimit = 1000;
+
+void quietMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    Q_UNUSED(context)
+    if (type == QtDebugMsg || type == QtInfoMsg) {
+        return;
+    }
+    std::fprintf(stderr, "%s\n", qPrintable(message));
+}
+
+AppStore makeStore(int count)
+{
+    static const char *const words[] = {
+        "Super", "Dragon", "Quest", "Studio", "Player", "Editor", "Manager", "Racing",
+        "Fantasy", "Office", "Visual", "Sound", "Photo", "Space", "Battle", "Tools"
+    };
+
+    AppStore store;
+    store.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const QString name = QString("%1 %2 %3 %4")
+                .arg(QString::fromLatin1(words[i % 16]))
+                .arg(QString::fromLatin1(words[(i / 16) % 16]))
+                .arg(QString::fromLatin1(words[(i / 256) % 16]))
+                .arg(i);
+        store.append(AppInfo(name, QString("C:/Apps/%1/app%2.exe").arg(i % 97).arg(i)));
+    }
+    return store;
+}
+
+template <typename Search>
+qint64 measure(Search search, int *hits)
+{
+    qint64 best = std::numeric_limits<qint64>::max();
+    for (int run = 0; run < Repeats; ++run) {
+        QElapsedTimer timer;
+        timer.start();
+        *hits = search();
+        best = qMin(best, timer.nsecsElapsed());
+    }
+    return best;
+}
+
+void report(QTextStream &out, const QString &label, qint64 nsecs, int hits)
+{
+    out << "  " << label.leftJustified(28) << QString::number(nsecs / 1e6, 'f', 2).rightJustified(10) << " ms"
+        << QString::number(hits).rightJustified(10) << " hits\n";
+    out.flush();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    qInstallMessageHandler(quietMessageHandler);
+
+    QTextStream out(stdout);
+    out << "FuzzyMatcher uses " << FuzzyMatcher::simdLevel() << "\n";
+
+    const QStringList keywords = {"dragon", "spq", "fantasy office", "zzz"};
+    for (int count : {10000, 100000, 1000000}) {
+        SearchIndex index;
+        index.rebuild(makeStore(count));
+        out << "\n" << count << " apps\n";
+
+        for (const QString &keyword : keywords) {
+            const QString query = SearchIndex::normalize(keyword);
+            int hits = 0;
+            const qint64 substring = measure([&]() {
+                return int(index.searchDocuments(query).size());
+            }, &hits);
+            report(out, QString("substring \"%1\"").arg(keyword), substring, hits);
+
+            const qint64 fuzzy = measure([&]() {
+                return int(FuzzyMatcher::search(index, keyword, FuzzyLimit).size());
+            }, &hits);
+            report(out, QString("fuzzy \"%1\"").arg(keyword), fuzzy, hits);
+        }
+    }
+    return 0;
+}
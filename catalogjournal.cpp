@@ -0,0 +1,299 @@
+#include "catalogjournal.h"
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+CatalogJournal::CatalogJournal()
+    : m_recordCount(0)
+    , m_compactionThreshold(500)
+{
+}
+
+CatalogJournal::~CatalogJournal()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+void CatalogJournal::setJournalPath(const QString &path)
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_ownerLock.reset();
+    m_journalPath = path;
+    m_recordCount = 0;
+
+    if (m_journalPath.isEmpty()) {
+        return;
+    }
+    // 持ち主のプロセスが生きている間は、ほかのインスタンスから引き取られない
+    m_ownerLock = std::make_unique<QLockFile>(ownerLockPath(m_journalPath));
+    m_ownerLock->setStaleLockTime(0);
+    if (!m_ownerLock->tryLock(0)) {
+        qWarning() << "Catalog journal is owned by another process:" << m_journalPath;
+    }
+}
+
+QString CatalogJournal::journalPath() const
+{
+    return m_journalPath;
+}
+
+QString CatalogJournal::mergingPath() const
+{
+    return m_journalPath + ".merging";
+}
+
+bool CatalogJournal::appendRecords(const QList<Record> &records)
+{
+    if (records.isEmpty()) {
+        return true;
+    }
+
+    // ジャーナルはこのプロセス専用なので、開いたままのファイルに追記してよい
+    if (!openForAppend()) {
+        return false;
+    }
+
+    QByteArray data;
+    for (const Record &record : records) {
+        data.append(encodeRecord(record));
+    }
+
+    if (m_file.write(data) != data.size() || !syncToDisk()) {
+        qWarning() << "Failed to append to catalog journal:" << m_journalPath << m_file.errorString();
+        return false;
+    }
+
+    m_recordCount += records.size();
+    return true;
+}
+
+void CatalogJournal::setCompactionThreshold(int threshold)
+{
+    m_compactionThreshold = qMax(1, threshold);
+}
+
+bool CatalogJournal::needsCompaction() const
+{
+    return m_recordCount >= m_compactionThreshold;
+}
+
+bool CatalogJournal::isMerging() const
+{
+    return QFileInfo::exists(mergingPath());
+}
+
+bool CatalogJournal::rotate()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    bool hasJournal = QFileInfo::exists(m_journalPath);
+    if (!isMerging()) {
+        if (!hasJournal) {
+            return false;
+        }
+        if (!QFile::rename(m_journalPath, mergingPath())) {
+            qWarning() << "Failed to rotate catalog journal:" << m_journalPath;
+            return false;
+        }
+        m_recordCount = 0;
+        return true;
+    }
+
+    // 前回のマージが完了しないまま終了していた場合は、現行ジャーナルを後ろに連結して再マージする
+    if (hasJournal) {
+        QFile source(m_journalPath);
+        QFile merging(mergingPath());
+        if (!source.open(QIODevice::ReadOnly) ||
+            !merging.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qWarning() << "Failed to merge catalog journal into:" << mergingPath();
+            return false;
+        }
+        QByteArray data = source.readAll();
+        source.close();
+        if (merging.write(data) != data.size() || !merging.flush()) {
+            qWarning() << "Failed to merge catalog journal into:" << mergingPath();
+            return false;
+        }
+#ifdef Q_OS_WIN
+        _commit(merging.handle());
+#else
+        ::fsync(merging.handle());
+#endif
+        merging.close();
+        QFile::remove(m_journalPath);
+    }
+
+    m_recordCount = 0;
+    return true;
+}
+
+void CatalogJournal::finishMerge()
+{
+    QFile::remove(mergingPath());
+}
+
+QList<CatalogJournal::Record> CatalogJournal::readAll()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    QList<Record> records = readFile(mergingPath());
+    records.append(readFile(m_journalPath));
+    m_recordCount = records.size();
+    return records;
+}
+
+int CatalogJournal::adoptOrphans(const QStringList &journalPaths)
+{
+    int adopted = 0;
+    for (const QString &path : journalPaths) {
+        if (path == m_journalPath) {
+            continue;
+        }
+
+        // ロックが取れなければ持ち主が動いている（または別のインスタンスが引き取り中）
+        QLockFile owner(ownerLockPath(path));
+        owner.setStaleLockTime(0);
+        if (!owner.tryLock(0)) {
+            continue;
+        }
+
+        QList<Record> records = readFile(path + ".merging");
+        records.append(readFile(path));
+        if (!records.isEmpty() && !appendRecords(records)) {
+            // 移せなかったものは残しておき、次回の起動で引き取り直す
+            qWarning() << "Failed to adopt catalog journal:" << path;
+            continue;
+        }
+
+        QFile::remove(path + ".merging");
+        QFile::remove(path);
+        adopted += records.size();
+        qDebug() << "Adopted" << records.size() << "records from orphaned catalog journal" << path;
+    }
+    return adopted;
+}
+
+bool CatalogJournal::openForAppend()
+{
+    if (m_file.isOpen()) {
+        return true;
+    }
+
+    if (m_journalPath.isEmpty()) {
+        return false;
+    }
+
+    m_file.setFileName(m_journalPath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Cannot open catalog journal for appending:" << m_journalPath;
+        return false;
+    }
+    return true;
+}
+
+QString CatalogJournal::ownerLockPath(const QString &journalPath)
+{
+    return journalPath + ".owner";
+}
+
+bool CatalogJournal::syncToDisk()
+{
+    if (!m_file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return _commit(m_file.handle()) == 0;
+#else
+    return ::fsync(m_file.handle()) == 0;
+#endif
+}
+
+QByteArray CatalogJournal::encodeRecord(const Record &record)
+{
+    QJsonObject obj;
+    switch (record.op) {
+    case OpAdd:
+        obj["op"] = "add";
+        obj["app"] = record.app.toJson();
+        break;
+    case OpUpdate:
+        obj["op"] = "update";
+        obj["app"] = record.app.toJson();
+        break;
+    case OpRemove:
+        obj["op"] = "remove";
+        obj["id"] = record.appId;
+        break;
+    }
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact) + '\n';
+}
+
+bool CatalogJournal::decodeRecord(const QByteArray &line, Record &record)
+{
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+
+    QJsonObject obj = doc.object();
+    QString op = obj["op"].toString();
+    if (op == "remove") {
+        record.op = OpRemove;
+        record.appId = obj["id"].toString();
+        return !record.appId.isEmpty();
+    }
+
+    if (op != "add" && op != "update") {
+        return false;
+    }
+
+    record.op = (op == "add") ? OpAdd : OpUpdate;
+    record.app.fromJson(obj["app"].toObject());
+    record.appId = record.app.id;
+    return true;
+}
+
+QList<CatalogJournal::Record> CatalogJournal::readFile(const QString &path)
+{
+    QList<Record> records;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return records;
+    }
+
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        Record record;
+        if (!decodeRecord(line, record)) {
+            // 書き込み途中でクラッシュした末尾レコードはここで打ち切る
+            qWarning() << "Discarding torn catalog journal record in" << path;
+            break;
+        }
+        records.append(record);
+    }
+
+    file.close();
+    qDebug() << "Read" << records.size() << "journal records from" << path;
+    return records;
+}
@@ -0,0 +1,74 @@
+#ifndef CATALOGJOURNAL_H
+#define CATALOGJOURNAL_H
+
+#include <QString>
+#include <QList>
+#include <QStringList>
+#include <QFile>
+#include <QLockFile>
+#include <QJsonObject>
+#include <memory>
+#include "appinfo.h"
+
+// apps.json への差分を追記するライトアヘッドジャーナル
+// 1行1レコードのJSON Lines形式で、追記ごとにfsyncしてクラッシュ耐性を確保する
+//
+// ジャーナルはプロセスごとに別のファイルとし、ほかのインスタンスのローテーション・削除で
+// 記録が失われないようにする。使用中のジャーナルには <ジャーナル>.owner のロックを持ち、
+// ロックの取れる（持ち主が終了した）ジャーナルは adoptOrphans で自分のジャーナルに引き取る。
+class CatalogJournal
+{
+public:
+    enum Operation {
+        OpAdd,
+        OpUpdate,
+        OpRemove
+    };
+
+    struct Record {
+        Operation op;
+        QString appId;
+        AppInfo app;    // OpRemoveでは未使用
+    };
+
+    CatalogJournal();
+    ~CatalogJournal();
+
+    // ジャーナルファイルの場所（所有ロックもここで取る）
+    void setJournalPath(const QString &path);
+    QString journalPath() const;
+    QString mergingPath() const;    // マージ中（ローテーション済み）のジャーナル
+
+    // レコード追記（複数レコードを1回のfsyncで追記）
+    bool appendRecords(const QList<Record> &records);
+
+    // マージ（コンパクション）制御
+    void setCompactionThreshold(int threshold);
+    bool needsCompaction() const;
+    bool isMerging() const;
+    bool rotate();          // 現在のジャーナルをマージ用に退避して新しいジャーナルを開始（残存分には連結）
+    void finishMerge();     // スナップショット書き込み完了後にマージ用ジャーナルを削除
+
+    // 起動時の再生（マージ用 → 現行の順）
+    QList<Record> readAll();
+
+    // 持ち主のいないジャーナル（異常終了したインスタンスのもの）を自分のジャーナルの末尾に移す
+    // （戻り値は引き取ったレコード数。使用中のもの・自分のものは飛ばす）
+    int adoptOrphans(const QStringList &journalPaths);
+
+private:
+    QString m_journalPath;
+    QFile m_file;
+    std::unique_ptr<QLockFile> m_ownerLock;
+    int m_recordCount;
+    int m_compactionThreshold;
+
+    bool openForAppend();
+    static QString ownerLockPath(const QString &journalPath);
+    bool syncToDisk();
+    static QByteArray encodeRecord(const Record &record);
+    static bool decodeRecord(const QByteArray &line, Record &record);
+    static QList<Record> readFile(const QString &path);
+};
+
+#endif // CATALOGJOURNAL_H
@@ -0,0 +1,524 @@
+#include "catalogjson.h"
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+namespace {
+
+// 1回に読み込む量
+const qint64 ChunkSize = 64 * 1024;
+// 入れ子の上限（壊れたファイルでスタックを使い切らないように）
+const int MaxDepth = 64;
+
+void appendUtf8(QByteArray *out, uint code)
+{
+    if (code < 0x80) {
+        out->append(char(code));
+    } else if (code < 0x800) {
+        out->append(char(0xC0 | (code >> 6)));
+        out->append(char(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        out->append(char(0xE0 | (code >> 12)));
+        out->append(char(0x80 | ((code >> 6) & 0x3F)));
+        out->append(char(0x80 | (code & 0x3F)));
+    } else {
+        out->append(char(0xF0 | (code >> 18)));
+        out->append(char(0x80 | ((code >> 12) & 0x3F)));
+        out->append(char(0x80 | ((code >> 6) & 0x3F)));
+        out->append(char(0x80 | (code & 0x3F)));
+    }
+}
+
+}
+
+// ---- CatalogJsonReader ----
+
+CatalogJsonReader::CatalogJsonReader(QIODevice *device)
+    : m_device(device)
+    , m_pos(0)
+    , m_offset(0)
+    , m_failed(false)
+    , m_recordCount(0)
+{
+}
+
+bool CatalogJsonReader::read(const std::function<void(const QJsonObject &record)> &onApp)
+{
+    m_buffer.clear();
+    m_pos = 0;
+    m_offset = 0;
+    m_failed = false;
+    m_error.clear();
+    m_values.clear();
+    m_recordCount = 0;
+
+    // UTF-8のBOMは読み飛ばす
+    if (peek() == 0xEF) {
+        get();
+        if (get() != 0xBB || get() != 0xBF) {
+            return fail("Invalid byte order mark");
+        }
+    }
+
+    skipWhitespace();
+    if (!expect('{')) {
+        return false;
+    }
+    skipWhitespace();
+    if (peek() == '}') {
+        get();
+    } else {
+        while (true) {
+            QString key;
+            skipWhitespace();
+            if (!parseString(&key)) {
+                return false;
+            }
+            skipWhitespace();
+            if (!expect(':')) {
+                return false;
+            }
+            skipWhitespace();
+
+            if (key == QLatin1String("apps") && peek() == '[') {
+                if (!parseApps(onApp)) {
+                    return false;
+                }
+            } else {
+                QJsonValue value;
+                if (!parseValue(&value, 1)) {
+                    return false;
+                }
+                m_values.insert(key, value);
+            }
+
+            skipWhitespace();
+            int c = get();
+            if (c == '}') {
+                break;
+            }
+            if (c != ',') {
+                return fail("',' or '}' expected");
+            }
+        }
+    }
+
+    skipWhitespace();
+    if (peek() != -1) {
+        return fail("Unexpected data after the root object");
+    }
+    return true;
+}
+
+QJsonValue CatalogJsonReader::value(const QString &key) const
+{
+    return m_values.value(key, QJsonValue(QJsonValue::Undefined));
+}
+
+int CatalogJsonReader::recordCount() const
+{
+    return m_recordCount;
+}
+
+QString CatalogJsonReader::errorString() const
+{
+    return m_error;
+}
+
+bool CatalogJsonReader::fill()
+{
+    if (m_failed) {
+        return false;
+    }
+    m_offset += m_buffer.size();
+    m_buffer = m_device->read(ChunkSize);
+    m_pos = 0;
+    return !m_buffer.isEmpty();
+}
+
+int CatalogJsonReader::peek()
+{
+    if (m_pos >= m_buffer.size() && !fill()) {
+        return -1;
+    }
+    return uchar(m_buffer.at(m_pos));
+}
+
+int CatalogJsonReader::get()
+{
+    int c = peek();
+    if (c >= 0) {
+        ++m_pos;
+    }
+    return c;
+}
+
+void CatalogJsonReader::skipWhitespace()
+{
+    while (true) {
+        int c = peek();
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            return;
+        }
+        ++m_pos;
+    }
+}
+
+bool CatalogJsonReader::expect(char c)
+{
+    if (get() != uchar(c)) {
+        return fail(QString("'%1' expected").arg(QLatin1Char(c)));
+    }
+    return true;
+}
+
+bool CatalogJsonReader::fail(const QString &message)
+{
+    if (!m_failed) {
+        m_failed = true;
+        m_error = QString("%1 at offset %2").arg(message).arg(m_offset + m_pos);
+    }
+    return false;
+}
+
+bool CatalogJsonReader::parseValue(QJsonValue *value, int depth)
+{
+    if (depth > MaxDepth) {
+        return fail("Too deeply nested");
+    }
+
+    skipWhitespace();
+    switch (peek()) {
+    case '{': {
+        QJsonObject object;
+        if (!parseObject(&object, depth + 1)) {
+            return false;
+        }
+        *value = object;
+        return true;
+    }
+    case '[':
+        return parseArray(value, depth + 1);
+    case '"': {
+        QString str;
+        if (!parseString(&str)) {
+            return false;
+        }
+        *value = str;
+        return true;
+    }
+    case 't':
+        return parseLiteral("true", QJsonValue(true), value);
+    case 'f':
+        return parseLiteral("false", QJsonValue(false), value);
+    case 'n':
+        return parseLiteral("null", QJsonValue(QJsonValue::Null), value);
+    case -1:
+        return fail("Unexpected end of data");
+    default:
+        return parseNumber(value);
+    }
+}
+
+bool CatalogJsonReader::parseObject(QJsonObject *object, int depth)
+{
+    if (depth > MaxDepth) {
+        return fail("Too deeply nested");
+    }
+    if (!expect('{')) {
+        return false;
+    }
+
+    skipWhitespace();
+    if (peek() == '}') {
+        get();
+        return true;
+    }
+
+    while (true) {
+        QString key;
+        QJsonValue value;
+        skipWhitespace();
+        if (!parseString(&key)) {
+            return false;
+        }
+        skipWhitespace();
+        if (!expect(':') || !parseValue(&value, depth)) {
+            return false;
+        }
+        object->insert(key, value);
+
+        skipWhitespace();
+        int c = get();
+        if (c == '}') {
+            return true;
+        }
+        if (c != ',') {
+            return fail("',' or '}' expected");
+        }
+    }
+}
+
+bool CatalogJsonReader::parseArray(QJsonValue *value, int depth)
+{
+    if (!expect('[')) {
+        return false;
+    }
+
+    QJsonArray array;
+    skipWhitespace();
+    if (peek() == ']') {
+        get();
+        *value = array;
+        return true;
+    }
+
+    while (true) {
+        QJsonValue element;
+        if (!parseValue(&element, depth)) {
+            return false;
+        }
+        array.append(element);
+
+        skipWhitespace();
+        int c = get();
+        if (c == ']') {
+            *value = array;
+            return true;
+        }
+        if (c != ',') {
+            return fail("',' or ']' expected");
+        }
+    }
+}
+
+bool CatalogJsonReader::parseString(QString *str)
+{
+    if (!expect('"')) {
+        return false;
+    }
+
+    QByteArray utf8;
+    while (true) {
+        if (m_pos >= m_buffer.size() && !fill()) {
+            return fail("Unterminated string");
+        }
+
+        // エスケープを含まない部分はまとめてコピーする
+        const char *data = m_buffer.constData();
+        const int end = m_buffer.size();
+        int i = m_pos;
+        while (i < end && data[i] != '"' && data[i] != '\\' && uchar(data[i]) >= 0x20) {
+            ++i;
+        }
+        utf8.append(data + m_pos, i - m_pos);
+        m_pos = i;
+        if (i == end) {
+            continue;
+        }
+
+        const char c = data[i];
+        ++m_pos;
+        if (c == '"') {
+            break;
+        }
+        if (c != '\\') {
+            return fail("Control character in string");
+        }
+
+        const int escape = get();
+        switch (escape) {
+        case '"':  utf8.append('"'); break;
+        case '\\': utf8.append('\\'); break;
+        case '/':  utf8.append('/'); break;
+        case 'b':  utf8.append('\b'); break;
+        case 'f':  utf8.append('\f'); break;
+        case 'n':  utf8.append('\n'); break;
+        case 'r':  utf8.append('\r'); break;
+        case 't':  utf8.append('\t'); break;
+        case 'u': {
+            uint code = 0;
+            if (!parseHex4(&code)) {
+                return false;
+            }
+            // サロゲートペアは続く \uXXXX と組み合わせる
+            if (code >= 0xD800 && code < 0xDC00 && peek() == '\\') {
+                get();
+                uint low = 0;
+                if (get() != 'u' || !parseHex4(&low)) {
+                    return fail("Invalid surrogate pair");
+                }
+                if (low >= 0xDC00 && low < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else {
+                    appendUtf8(&utf8, 0xFFFD);
+                    code = low;
+                }
+            }
+            if (code >= 0xD800 && code < 0xE000) {
+                code = 0xFFFD;  // 対になっていないサロゲート
+            }
+            appendUtf8(&utf8, code);
+            break;
+        }
+        default:
+            return fail("Invalid escape sequence");
+        }
+    }
+
+    *str = QString::fromUtf8(utf8);
+    return true;
+}
+
+bool CatalogJsonReader::parseHex4(uint *code)
+{
+    *code = 0;
+    for (int i = 0; i < 4; ++i) {
+        const int c = get();
+        uint digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return fail("Invalid \\u escape");
+        }
+        *code = (*code << 4) | digit;
+    }
+    return true;
+}
+
+bool CatalogJsonReader::parseNumber(QJsonValue *value)
+{
+    QByteArray text;
+    while (true) {
+        const int c = peek();
+        if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+            text.append(char(c));
+            ++m_pos;
+        } else {
+            break;
+        }
+    }
+
+    bool ok = false;
+    const double number = text.toDouble(&ok);
+    if (text.isEmpty() || !ok) {
+        return fail("Invalid value");
+    }
+    *value = number;
+    return true;
+}
+
+bool CatalogJsonReader::parseLiteral(const char *literal, const QJsonValue &result, QJsonValue *value)
+{
+    for (const char *p = literal; *p; ++p) {
+        if (get() != uchar(*p)) {
+            return fail("Invalid literal");
+        }
+    }
+    *value = result;
+    return true;
+}
+
+bool CatalogJsonReader::parseApps(const std::function<void(const QJsonObject &record)> &onApp)
+{
+    if (!expect('[')) {
+        return false;
+    }
+
+    skipWhitespace();
+    if (peek() == ']') {
+        get();
+        return true;
+    }
+
+    while (true) {
+        skipWhitespace();
+        if (peek() == '{') {
+            // 1件ずつ組み立てて渡し、次の要素に移る前に手放す
+            QJsonObject record;
+            if (!parseObject(&record, 2)) {
+                return false;
+            }
+            ++m_recordCount;
+            onApp(record);
+        } else {
+            // オブジェクト以外の要素は従来どおり無視する
+            QJsonValue ignored;
+            if (!parseValue(&ignored, 2)) {
+                return false;
+            }
+        }
+
+        skipWhitespace();
+        int c = get();
+        if (c == ']') {
+            return true;
+        }
+        if (c != ',') {
+            return fail("',' or ']' expected");
+        }
+    }
+}
+
+// ---- CatalogJsonWriter ----
+
+CatalogJsonWriter::CatalogJsonWriter(QIODevice *device)
+    : m_device(device)
+    , m_count(0)
+    , m_failed(false)
+{
+}
+
+void CatalogJsonWriter::begin()
+{
+    m_count = 0;
+    write("{\n    \"apps\": [\n");
+}
+
+void CatalogJsonWriter::writeApp(const QJsonObject &record)
+{
+    // 1件1行で書き出す（QJsonDocument は1件分だけ作る）
+    if (m_count > 0) {
+        write(",\n");
+    }
+    write("        " + QJsonDocument(record).toJson(QJsonDocument::Compact));
+    ++m_count;
+}
+
+void CatalogJsonWriter::end(const QJsonObject &members)
+{
+    if (m_count > 0) {
+        write("\n");
+    }
+    write("    ]");
+    for (auto it = members.constBegin(); it != members.constEnd(); ++it) {
+        write(",\n    " + encodeValue(it.key()) + ": " + encodeValue(it.value()));
+    }
+    write("\n}\n");
+}
+
+bool CatalogJsonWriter::hasError() const
+{
+    return m_failed;
+}
+
+void CatalogJsonWriter::write(const QByteArray &data)
+{
+    if (m_failed) {
+        return;
+    }
+    if (m_device->write(data) != data.size()) {
+        m_failed = true;
+    }
+}
+
+QByteArray CatalogJsonWriter::encodeValue(const QJsonValue &value)
+{
+    // 配列に包んで書き出し、前後の括弧を外す（文字列のエスケープなどは QJsonDocument に任せる）
+    const QByteArray json = QJsonDocument(QJsonArray{value}).toJson(QJsonDocument::Compact);
+    return json.mid(1, json.size() - 2);
+}
@@ -0,0 +1,78 @@
+#ifndef CATALOGJSON_H
+#define CATALOGJSON_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <functional>
+
+class QIODevice;
+
+// apps.json を全体のDOMを作らずに読むストリーミングリーダー
+//
+// ファイルは一定量ずつ読み込み、"apps" 配列の要素は1件分のオブジェクトだけを組み立てて
+// コールバックに渡す。それ以外のトップレベルの値（categories, version など）は小さいので値として保持する。
+// 読み込み中に保持するのは読み込みバッファと1件分のレコードだけになる。
+class CatalogJsonReader
+{
+public:
+    explicit CatalogJsonReader(QIODevice *device);
+
+    bool read(const std::function<void(const QJsonObject &record)> &onApp);
+
+    QJsonValue value(const QString &key) const;     // "apps" 以外のトップレベルの値
+    int recordCount() const;
+    QString errorString() const;
+
+private:
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    int m_pos;
+    qint64 m_offset;        // m_buffer先頭のファイル内の位置（エラー表示用）
+    bool m_failed;
+    QString m_error;
+    QHash<QString, QJsonValue> m_values;
+    int m_recordCount;
+
+    bool fill();
+    int peek();             // 次の文字（終端は -1）
+    int get();
+    void skipWhitespace();
+    bool expect(char c);
+    bool fail(const QString &message);
+
+    bool parseValue(QJsonValue *value, int depth);
+    bool parseObject(QJsonObject *object, int depth);
+    bool parseArray(QJsonValue *value, int depth);
+    bool parseString(QString *str);
+    bool parseHex4(uint *code);
+    bool parseNumber(QJsonValue *value);
+    bool parseLiteral(const char *literal, const QJsonValue &result, QJsonValue *value);
+    bool parseApps(const std::function<void(const QJsonObject &record)> &onApp);
+};
+
+// apps.json を1件ずつ書き出すストリーミングライター
+// 出力は既存の形式と同じ（"apps" 配列とその他のトップレベルの値を持つオブジェクト）。
+class CatalogJsonWriter
+{
+public:
+    explicit CatalogJsonWriter(QIODevice *device);
+
+    void begin();
+    void writeApp(const QJsonObject &record);
+    void end(const QJsonObject &members);   // "apps" の後に続けるトップレベルの値
+
+    bool hasError() const;
+
+private:
+    QIODevice *m_device;
+    int m_count;
+    bool m_failed;
+
+    void write(const QByteArray &data);
+    static QByteArray encodeValue(const QJsonValue &value);
+};
+
+#endif // CATALOGJSON_H
@@ -0,0 +1,283 @@
+#include "catalogsaver.h"
+#include "catalogsnapshot.h"
+#include "catalogjson.h"
+#include "filelock.h"
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QDebug>
+
+CatalogSaver::CatalogSaver(QObject *parent)
+    : QObject(parent)
+    , m_worker(new QObject)
+    , m_hasPending(false)
+    , m_submittedGeneration(0)
+    , m_writtenGeneration(0)
+    , m_lastResult(Written)
+    , m_writtenSize(-1)
+{
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread.setObjectName("CatalogSaver");
+    m_thread.start(QThread::LowPriority);
+}
+
+CatalogSaver::~CatalogSaver()
+{
+    flush();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+quint64 CatalogSaver::submit(const AppStore &store, const QJsonObject &categories,
+                             const QString &dataFilePath, const QString &snapshotPath,
+                             const QDateTime &expectedModified, qint64 expectedSize)
+{
+    quint64 generation;
+    bool wasPending;
+    {
+        QMutexLocker locker(&m_mutex);
+        generation = ++m_submittedGeneration;
+        wasPending = m_hasPending;
+        // まだ書き始めていない要求は上書きする（AppStoreは暗黙共有なので複製は安価）
+        m_pending = Job{generation, store, categories, dataFilePath, snapshotPath,
+                        expectedModified, expectedSize};
+        m_hasPending = true;
+    }
+
+    if (!wasPending) {
+        QMetaObject::invokeMethod(m_worker, [this]() { processPending(); }, Qt::QueuedConnection);
+    }
+    return generation;
+}
+
+CatalogSaver::Result CatalogSaver::flush()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_hasPending && m_writtenGeneration == m_submittedGeneration) {
+            return m_lastResult;
+        }
+    }
+
+    // 実行中の書き込みが終わるのを待ち、残りの要求もこのスレッドを待たせたまま処理させる
+    QMetaObject::invokeMethod(m_worker, [this]() { processPending(); }, Qt::BlockingQueuedConnection);
+
+    QMutexLocker locker(&m_mutex);
+    return m_writtenGeneration == m_submittedGeneration ? m_lastResult : Failed;
+}
+
+void CatalogSaver::readExternalChanges(const QString &dataFilePath, const AppStore &store,
+                                       const QSet<QString> &skipIds,
+                                       const QDateTime &knownModified, qint64 knownSize)
+{
+    // ストアは暗黙共有の複製なので、読んでいる間にGUI側で変更されても複製されるのはそのチャンクだけ
+    QMetaObject::invokeMethod(m_worker, [this, dataFilePath, store, skipIds, knownModified, knownSize]() {
+        emit externalChangesRead(collectExternalChanges(dataFilePath, store, skipIds, knownModified, knownSize));
+    }, Qt::QueuedConnection);
+}
+
+CatalogSaver::ExternalChanges CatalogSaver::collectExternalChanges(const QString &dataFilePath, const AppStore &store,
+                                                                   const QSet<QString> &skipIds,
+                                                                   const QDateTime &knownModified, qint64 knownSize,
+                                                                   int lockTimeoutMs)
+{
+    ExternalChanges changes;
+    changes.dataFilePath = dataFilePath;
+    changes.baseModified = knownModified;
+    changes.baseSize = knownSize;
+
+    QFileInfo info(dataFilePath);
+    if (!info.exists() || (info.lastModified() == knownModified && info.size() == knownSize)) {
+        return changes;     // 自分の書き込み、または既に取り込んだ内容
+    }
+
+    QHash<QString, AppInfo> diskApps;
+    QStringList diskOrder;
+    {
+        // 書き手がロックを持っている間は読まない（既定では待たずに呼び出し側の再試行に任せる）
+        FileLock lock(dataFilePath, lockTimeoutMs);
+        if (!lock.isLocked()) {
+            changes.status = ExternalChanges::Busy;
+            return changes;
+        }
+
+        QFile file(dataFilePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            changes.status = ExternalChanges::Unreadable;
+            return changes;
+        }
+        CatalogJsonReader reader(&file);
+        bool ok = reader.read([&diskApps, &diskOrder](const QJsonObject &record) {
+            AppInfo app;
+            app.fromJson(record);
+            if (app.isValid() && !diskApps.contains(app.id)) {
+                diskApps.insert(app.id, app);
+                diskOrder.append(app.id);
+            }
+        });
+        if (!ok) {
+            // 書き込み途中の可能性があるので、次の変更通知を待つ
+            qWarning() << "Ignoring unreadable external change to" << dataFilePath << reader.errorString();
+            changes.status = ExternalChanges::Unreadable;
+            return changes;
+        }
+        changes.categories = reader.value("categories");
+        info.refresh();
+        changes.modified = info.lastModified();
+        changes.size = info.size();
+    }
+
+    QSet<QString> present;
+    present.reserve(store.size());
+    for (int row = 0; row < store.size(); ++row) {
+        const QString appId = store.id(row);
+        present.insert(appId);
+        if (skipIds.contains(appId)) {
+            continue;
+        }
+        auto it = diskApps.constFind(appId);
+        if (it == diskApps.constEnd()) {
+            changes.removedIds.append(appId);
+        } else if (it.value().toJson() != store.at(row).toJson()) {
+            changes.updatedApps.append(it.value());
+        }
+    }
+    for (const QString &appId : diskOrder) {
+        if (!skipIds.contains(appId) && !present.contains(appId)) {
+            changes.addedApps.append(diskApps.value(appId));
+        }
+    }
+
+    changes.status = ExternalChanges::Read;
+    return changes;
+}
+
+quint64 CatalogSaver::lastSubmittedGeneration() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_submittedGeneration;
+}
+
+quint64 CatalogSaver::lastWrittenGeneration() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_writtenGeneration;
+}
+
+QDateTime CatalogSaver::lastWrittenModified() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_writtenModified;
+}
+
+qint64 CatalogSaver::lastWrittenSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_writtenSize;
+}
+
+bool CatalogSaver::writeCatalog(QIODevice *device, const AppStore &store, const QJsonObject &categories)
+{
+    CatalogJsonWriter writer(device);
+    writer.begin();
+    for (int row = 0; row < store.size(); ++row) {
+        writer.writeApp(store.at(row).toJson());
+    }
+
+    QJsonObject members;
+    members["version"] = "1.0";
+    members["lastModified"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+
+    // カテゴリ情報も保存
+    members.insert("categories", categories["categories"]);
+
+    writer.end(members);
+    return !writer.hasError();
+}
+
+void CatalogSaver::processPending()
+{
+    Job job;
+    QDateTime ownModified;
+    qint64 ownSize;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_hasPending) {
+            return;
+        }
+        job = m_pending;
+        m_pending = Job();
+        m_hasPending = false;
+        ownModified = m_writtenModified;
+        ownSize = m_writtenSize;
+    }
+
+    QDateTime writtenModified;
+    qint64 writtenSize = -1;
+    const Result result = writeJob(job, ownModified, ownSize, &writtenModified, &writtenSize);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_writtenGeneration = job.generation;
+        m_lastResult = result;
+        if (result == Written) {
+            m_writtenModified = writtenModified;
+            m_writtenSize = writtenSize;
+        }
+    }
+    emit saveFinished(job.generation, result);
+}
+
+CatalogSaver::Result CatalogSaver::writeJob(const Job &job, const QDateTime &ownModified, qint64 ownSize,
+                                            QDateTime *writtenModified, qint64 *writtenSize)
+{
+    // 他のランチャーやスクリプトの書き込みと重ならないようにする
+    FileLock lock(job.dataFilePath);
+    if (!lock.isLocked()) {
+        qWarning() << "Apps data file is locked by another process:" << job.dataFilePath;
+        return Failed;
+    }
+
+    // ロック中に現在の内容を確かめる（呼び出し側が読んだ後に他で書かれていれば上書きしない）
+    // 要求を出した後にこちらの前の保存が書いた内容であれば、取りこぼしは無い
+    const QFileInfo current(job.dataFilePath);
+    if (current.exists()) {
+        const bool expected = current.lastModified() == job.expectedModified && current.size() == job.expectedSize;
+        const bool own = current.lastModified() == ownModified && current.size() == ownSize;
+        if (!expected && !own) {
+            qDebug() << "Apps data file was changed by another process, not overwriting:" << job.dataFilePath;
+            return Conflicted;
+        }
+    }
+
+    // 一時ファイルに書いてからリネームするので、途中で落ちても既存のapps.jsonは壊れない
+    QSaveFile file(job.dataFilePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot open apps data file for writing:" << job.dataFilePath;
+        return Failed;
+    }
+
+    if (!writeCatalog(&file, job.store, job.categories)) {
+        qWarning() << "Failed to write apps data file:" << job.dataFilePath << file.errorString();
+        file.cancelWriting();
+        return Failed;
+    }
+    if (!file.commit()) {
+        qWarning() << "Failed to commit apps data file:" << job.dataFilePath << file.errorString();
+        return Failed;
+    }
+
+    const QFileInfo written(job.dataFilePath);
+    *writtenModified = written.lastModified();
+    *writtenSize = written.size();
+
+    // 次回起動用のバイナリスナップショットも更新
+    CatalogSnapshot::write(job.snapshotPath, job.store, job.categories, job.dataFilePath);
+
+    qDebug() << "Saved" << job.store.size() << "applications to" << job.dataFilePath;
+    return Written;
+}
@@ -0,0 +1,122 @@
+#ifndef CATALOGSAVER_H
+#define CATALOGSAVER_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QJsonObject>
+#include <QThread>
+#include <QMutex>
+#include <QIODevice>
+#include <QDateTime>
+#include <QJsonValue>
+#include <QSet>
+#include <QMetaType>
+#include "appinfo.h"
+#include "appstore.h"
+
+// apps.json とバイナリスナップショットをワーカースレッドで書き出す保存パイプライン
+// submit() は複製済みのカタログを受け取るだけで即座に戻る。
+// 書き込み中に届いた要求は最新のもの1件にまとめられる。
+// ロックを取った時点の apps.json が呼び出し側の把握している内容（またはこちらが最後に
+// 書いた内容）と違えば、他のプロセスの変更を上書きしないよう書かずに Conflicted を返す。
+// 他のプロセスが書き換えた apps.json の読み込みと差分の計算も同じスレッドで行う（GUIを止めない）。
+class CatalogSaver : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Result {
+        Written,
+        Failed,
+        Conflicted      // 他で書き換えられていた（読み直して取り込んでから保存し直す）
+    };
+    Q_ENUM(Result)
+
+    // 外部で書き換えられた apps.json と、渡されたカタログとの差分
+    struct ExternalChanges {
+        enum Status {
+            Unchanged,      // 把握している内容のまま（または無い）
+            Read,
+            Busy,           // 書き手がロック中（少し待って読み直す）
+            Unreadable      // 書き込み途中などで読めない（次の変更通知を待つ）
+        };
+
+        Status status = Unchanged;
+        QString dataFilePath;
+        QDateTime baseModified;     // 差分の基にした（呼び出し側が把握していた）更新時刻とサイズ
+        qint64 baseSize = -1;
+        QDateTime modified;         // 読んだ apps.json の更新時刻とサイズ
+        qint64 size = -1;
+        QStringList removedIds;
+        QList<AppInfo> updatedApps;
+        QList<AppInfo> addedApps;
+        QJsonValue categories;
+    };
+
+    explicit CatalogSaver(QObject *parent = nullptr);
+    ~CatalogSaver();
+
+    // 保存要求（戻り値は世代番号。saveFinished で完了を通知）
+    // expectedModified・expectedSize は呼び出し側が最後に読んだ apps.json（無ければサイズ-1）
+    quint64 submit(const AppStore &store, const QJsonObject &categories,
+                   const QString &dataFilePath, const QString &snapshotPath,
+                   const QDateTime &expectedModified, qint64 expectedSize);
+
+    // 受け付け済みの保存がすべて書き終わるまで待つ（終了処理用。最後の保存の結果を返す）
+    Result flush();
+
+    // 外部の変更の読み込み要求（保存と同じスレッドで順に処理し、externalChangesRead で返す）
+    // skipIds は呼び出し側の未保存の変更があるアプリ（差分に含めない）
+    void readExternalChanges(const QString &dataFilePath, const AppStore &store, const QSet<QString> &skipIds,
+                             const QDateTime &knownModified, qint64 knownSize);
+    // 同じ処理をその場で行う（lockTimeoutMs までロックを待つ。0 なら待たずに Busy を返す）
+    static ExternalChanges collectExternalChanges(const QString &dataFilePath, const AppStore &store,
+                                                  const QSet<QString> &skipIds,
+                                                  const QDateTime &knownModified, qint64 knownSize,
+                                                  int lockTimeoutMs = 0);
+
+    quint64 lastSubmittedGeneration() const;
+    quint64 lastWrittenGeneration() const;
+    // 最後に書き込んだ apps.json の更新時刻とサイズ（自分の書き込みによる変更通知を見分けるため）
+    QDateTime lastWrittenModified() const;
+    qint64 lastWrittenSize() const;
+
+    // JSONシリアライズ（apps.json の形式。1件ずつ書き出すので全体のDOMは作らない）
+    static bool writeCatalog(QIODevice *device, const AppStore &store, const QJsonObject &categories);
+
+signals:
+    void saveFinished(quint64 generation, CatalogSaver::Result result);
+    void externalChangesRead(const CatalogSaver::ExternalChanges &changes);
+
+private:
+    struct Job {
+        quint64 generation = 0;
+        AppStore store;
+        QJsonObject categories;
+        QString dataFilePath;
+        QString snapshotPath;
+        QDateTime expectedModified;
+        qint64 expectedSize = -1;
+    };
+
+    QThread m_thread;
+    QObject *m_worker;      // m_thread 上で動作するコンテキスト
+
+    mutable QMutex m_mutex;
+    Job m_pending;
+    bool m_hasPending;
+    quint64 m_submittedGeneration;
+    quint64 m_writtenGeneration;
+    Result m_lastResult;
+    QDateTime m_writtenModified;
+    qint64 m_writtenSize;
+
+    void processPending();
+    static Result writeJob(const Job &job, const QDateTime &ownModified, qint64 ownSize,
+                           QDateTime *writtenModified, qint64 *writtenSize);
+};
+
+Q_DECLARE_METATYPE(CatalogSaver::ExternalChanges)
+
+#endif // CATALOGSAVER_H
@@ -0,0 +1,435 @@
+#include "catalogsnapshot.h"
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QHash>
+#include <QUuid>
+#include <QJsonDocument>
+#include <QDebug>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const char SnapshotMagic[4] = {'G', 'L', 'C', 'S'};
+const quint32 ByteOrderMark = 0x01020304;
+const qint64 InvalidDate = std::numeric_limits<qint64>::min();
+
+// ヘッダー（64バイト）内のオフセット
+const int HeaderSize = 64;
+const int HeaderVersion = 4;
+const int HeaderByteOrder = 8;
+const int HeaderRecordCount = 12;
+const int HeaderRecordSize = 16;
+const int HeaderStringCount = 20;
+const int HeaderRecordsOffset = 24;
+const int HeaderOffsetTable = 28;
+const int HeaderArenaOffset = 32;
+const int HeaderArenaSize = 36;
+const int HeaderCategories = 40;
+const int HeaderSourceSize = 48;
+const int HeaderSourceMtime = 56;
+
+// レコード（48バイト）内のオフセット
+const int RecordSize = 48;
+const int RecordStrings = 0;        // quint32 × 6
+const int RecordLaunchCount = 24;
+const int RecordLastLaunch = 32;
+const int RecordCreatedAt = 40;
+
+template <typename T>
+void putValue(QByteArray &buffer, int offset, T value)
+{
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+T readValue(const uchar *data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+qint64 dateToMSecs(const QDateTime &dateTime)
+{
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : InvalidDate;
+}
+
+}
+
+CatalogSnapshot::CatalogSnapshot()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_recordCount(0)
+    , m_stringCount(0)
+    , m_recordsOffset(0)
+    , m_offsetTableOffset(0)
+    , m_arenaOffset(0)
+    , m_arenaSize(0)
+    , m_categoriesString(0)
+{
+}
+
+CatalogSnapshot::~CatalogSnapshot()
+{
+    close();
+}
+
+bool CatalogSnapshot::write(const QString &snapshotPath, const AppStore &store,
+                            const QJsonObject &categories, const QString &sourcePath)
+{
+    QFileInfo source(sourcePath);
+    if (!source.exists()) {
+        return false;
+    }
+
+    // 同じ文字列（カテゴリ名や空文字列など）は1つにまとめる
+    QHash<QString, quint32> stringIds;
+    QList<QString> strings;
+    auto intern = [&stringIds, &strings](const QString &str) -> quint32 {
+        auto it = stringIds.constFind(str);
+        if (it != stringIds.constEnd()) {
+            return it.value();
+        }
+        quint32 index = strings.size();
+        stringIds.insert(str, index);
+        strings.append(str);
+        return index;
+    };
+
+    const quint32 recordCount = store.size();
+    QByteArray records(recordCount * RecordSize, '\0');
+    for (quint32 i = 0; i < recordCount; ++i) {
+        const AppInfo app = store.at(i);
+        const int base = i * RecordSize;
+        const QString *fields[] = {&app.id, &app.name, &app.path,
+                                   &app.iconPath, &app.description, &app.category};
+        for (int f = 0; f < FieldCount; ++f) {
+            putValue<quint32>(records, base + RecordStrings + f * 4, intern(*fields[f]));
+        }
+        putValue<qint32>(records, base + RecordLaunchCount, app.launchCount);
+        putValue<qint64>(records, base + RecordLastLaunch, dateToMSecs(app.lastLaunch));
+        putValue<qint64>(records, base + RecordCreatedAt, dateToMSecs(app.createdAt));
+    }
+
+    const quint32 categoriesString =
+        intern(QString::fromUtf8(QJsonDocument(categories).toJson(QJsonDocument::Compact)));
+
+    // 文字列アリーナとオフセット表
+    QByteArray offsets(strings.size() * 4, '\0');
+    QByteArray arena;
+    for (int i = 0; i < strings.size(); ++i) {
+        const QString &str = strings.at(i);
+        putValue<quint32>(offsets, i * 4, arena.size());
+
+        QByteArray length(4, '\0');
+        putValue<quint32>(length, 0, str.size());
+        arena.append(length);
+        arena.append(reinterpret_cast<const char *>(str.utf16()), str.size() * 2);
+        while (arena.size() % 4 != 0) {
+            arena.append('\0');
+        }
+    }
+
+    QByteArray header(HeaderSize, '\0');
+    std::memcpy(header.data(), SnapshotMagic, sizeof(SnapshotMagic));
+    putValue<quint32>(header, HeaderVersion, FormatVersion);
+    putValue<quint32>(header, HeaderByteOrder, ByteOrderMark);
+    putValue<quint32>(header, HeaderRecordCount, recordCount);
+    putValue<quint32>(header, HeaderRecordSize, RecordSize);
+    putValue<quint32>(header, HeaderStringCount, strings.size());
+    putValue<quint32>(header, HeaderRecordsOffset, HeaderSize);
+    putValue<quint32>(header, HeaderOffsetTable, HeaderSize + records.size());
+    putValue<quint32>(header, HeaderArenaOffset, HeaderSize + records.size() + offsets.size());
+    putValue<quint32>(header, HeaderArenaSize, arena.size());
+    putValue<quint32>(header, HeaderCategories, categoriesString);
+    putValue<qint64>(header, HeaderSourceSize, source.size());
+    putValue<qint64>(header, HeaderSourceMtime, source.lastModified().toMSecsSinceEpoch());
+
+    QSaveFile file(snapshotPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot open catalog snapshot for writing:" << snapshotPath;
+        return false;
+    }
+    file.write(header);
+    file.write(records);
+    file.write(offsets);
+    file.write(arena);
+    if (!file.commit()) {
+        qWarning() << "Failed to commit catalog snapshot:" << snapshotPath;
+        return false;
+    }
+
+    qDebug() << "Wrote catalog snapshot with" << recordCount << "records and"
+             << strings.size() << "strings to" << snapshotPath;
+    return true;
+}
+
+bool CatalogSnapshot::open(const QString &snapshotPath, const QString &sourcePath)
+{
+    close();
+
+    QFileInfo source(sourcePath);
+    if (!source.exists()) {
+        return false;
+    }
+
+    m_file.setFileName(snapshotPath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size < HeaderSize) {
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        qWarning() << "Cannot map catalog snapshot:" << snapshotPath;
+        close();
+        return false;
+    }
+
+    if (std::memcmp(m_data, SnapshotMagic, sizeof(SnapshotMagic)) != 0 ||
+        readValue<quint32>(m_data + HeaderVersion) != FormatVersion ||
+        readValue<quint32>(m_data + HeaderByteOrder) != ByteOrderMark ||
+        readValue<quint32>(m_data + HeaderRecordSize) != quint32(RecordSize)) {
+        qDebug() << "Catalog snapshot has an unsupported format:" << snapshotPath;
+        close();
+        return false;
+    }
+
+    // apps.json が別途書き換えられていれば使わない
+    if (readValue<qint64>(m_data + HeaderSourceSize) != source.size() ||
+        readValue<qint64>(m_data + HeaderSourceMtime) != source.lastModified().toMSecsSinceEpoch()) {
+        qDebug() << "Catalog snapshot is stale:" << snapshotPath;
+        close();
+        return false;
+    }
+
+    m_recordCount = readValue<quint32>(m_data + HeaderRecordCount);
+    m_stringCount = readValue<quint32>(m_data + HeaderStringCount);
+    m_recordsOffset = readValue<quint32>(m_data + HeaderRecordsOffset);
+    m_offsetTableOffset = readValue<quint32>(m_data + HeaderOffsetTable);
+    m_arenaOffset = readValue<quint32>(m_data + HeaderArenaOffset);
+    m_arenaSize = readValue<quint32>(m_data + HeaderArenaSize);
+    m_categoriesString = readValue<quint32>(m_data + HeaderCategories);
+
+    // 各セクションがファイル内に収まっているか確認
+    const quint64 fileSize = quint64(m_size);
+    if (quint64(m_recordsOffset) + quint64(m_recordCount) * RecordSize > fileSize ||
+        quint64(m_offsetTableOffset) + quint64(m_stringCount) * 4 > fileSize ||
+        quint64(m_arenaOffset) + m_arenaSize > fileSize ||
+        m_arenaOffset % 4 != 0) {
+        qWarning() << "Catalog snapshot is truncated:" << snapshotPath;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void CatalogSnapshot::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_size = 0;
+    m_recordCount = 0;
+    m_stringCount = 0;
+}
+
+bool CatalogSnapshot::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+int CatalogSnapshot::count() const
+{
+    return int(m_recordCount);
+}
+
+QString CatalogSnapshot::id(int row) const
+{
+    return field(row, FieldId);
+}
+
+QString CatalogSnapshot::name(int row) const
+{
+    return field(row, FieldName);
+}
+
+QString CatalogSnapshot::path(int row) const
+{
+    return field(row, FieldPath);
+}
+
+QString CatalogSnapshot::iconPath(int row) const
+{
+    return field(row, FieldIconPath);
+}
+
+QString CatalogSnapshot::description(int row) const
+{
+    return field(row, FieldDescription);
+}
+
+QString CatalogSnapshot::category(int row) const
+{
+    return field(row, FieldCategory);
+}
+
+int CatalogSnapshot::launchCount(int row) const
+{
+    const uchar *data = record(row);
+    return data ? readValue<qint32>(data + RecordLaunchCount) : 0;
+}
+
+QDateTime CatalogSnapshot::lastLaunch(int row) const
+{
+    const uchar *data = record(row);
+    return data ? dateFromMSecs(readValue<qint64>(data + RecordLastLaunch)) : QDateTime();
+}
+
+QDateTime CatalogSnapshot::createdAt(int row) const
+{
+    const uchar *data = record(row);
+    return data ? dateFromMSecs(readValue<qint64>(data + RecordCreatedAt)) : QDateTime();
+}
+
+AppInfo CatalogSnapshot::app(int row) const
+{
+    AppInfo app;
+    QString appId = id(row);
+    if (!appId.isEmpty()) {
+        app.id = appId;
+    }
+    app.name = name(row);
+    app.path = path(row);
+    app.iconPath = iconPath(row);
+    app.description = description(row);
+    app.category = category(row);
+    if (app.category.isEmpty()) {
+        app.category = "その他";
+    }
+    app.launchCount = launchCount(row);
+    app.lastLaunch = lastLaunch(row);
+    QDateTime created = createdAt(row);
+    if (created.isValid()) {
+        app.createdAt = created;
+    }
+    return app;
+}
+
+int CatalogSnapshot::loadInto(AppStore *store) const
+{
+    if (!m_data) {
+        return 0;
+    }
+
+    static const QString DefaultCategory = QStringLiteral("その他");
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    store->reserve(store->size() + int(m_recordCount));
+
+    int loaded = 0;
+    for (quint32 row = 0; row < m_recordCount; ++row) {
+        const uchar *data = m_data + m_recordsOffset + quint64(row) * RecordSize;
+        auto view = [&](StringField which) {
+            return stringView(readValue<quint32>(data + RecordStrings + which * 4));
+        };
+
+        AppStore::RawRecord raw;
+        raw.name = view(FieldName);
+        raw.path = view(FieldPath);
+        if (raw.name.isEmpty() || raw.path.isEmpty()) {
+            continue;
+        }
+
+        // app() と同じ既定値を補う（IDが無ければ新規発行、カテゴリ無しは「その他」）
+        QString generatedId;
+        raw.id = view(FieldId);
+        if (raw.id.isEmpty()) {
+            generatedId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+            raw.id = generatedId;
+        }
+        raw.iconPath = view(FieldIconPath);
+        raw.description = view(FieldDescription);
+        raw.category = view(FieldCategory);
+        if (raw.category.isEmpty()) {
+            raw.category = DefaultCategory;
+        }
+        raw.launchCount = readValue<qint32>(data + RecordLaunchCount);
+        const qint64 lastLaunch = readValue<qint64>(data + RecordLastLaunch);
+        raw.lastLaunchMSecs = lastLaunch == InvalidDate ? AppStore::InvalidMSecs : lastLaunch;
+        const qint64 createdAt = readValue<qint64>(data + RecordCreatedAt);
+        raw.createdAtMSecs = createdAt == InvalidDate ? now : createdAt;
+
+        store->append(raw);
+        ++loaded;
+    }
+    return loaded;
+}
+
+QJsonObject CatalogSnapshot::categories() const
+{
+    if (!m_data) {
+        return QJsonObject();
+    }
+    return QJsonDocument::fromJson(stringAt(m_categoriesString).toUtf8()).object();
+}
+
+const uchar *CatalogSnapshot::record(int row) const
+{
+    if (!m_data || row < 0 || quint32(row) >= m_recordCount) {
+        return nullptr;
+    }
+    return m_data + m_recordsOffset + quint64(row) * RecordSize;
+}
+
+QStringView CatalogSnapshot::stringView(quint32 index) const
+{
+    if (!m_data || index >= m_stringCount) {
+        return QStringView();
+    }
+
+    const quint32 offset = readValue<quint32>(m_data + m_offsetTableOffset + quint64(index) * 4);
+    if (quint64(offset) + 4 > m_arenaSize) {
+        return QStringView();
+    }
+
+    const uchar *entry = m_data + m_arenaOffset + offset;
+    const quint32 length = readValue<quint32>(entry);
+    if (quint64(offset) + 4 + quint64(length) * 2 > m_arenaSize) {
+        return QStringView();
+    }
+
+    return QStringView(reinterpret_cast<const QChar *>(entry + 4), qsizetype(length));
+}
+
+QString CatalogSnapshot::stringAt(quint32 index) const
+{
+    return stringView(index).toString();
+}
+
+QString CatalogSnapshot::field(int row, StringField which) const
+{
+    const uchar *data = record(row);
+    if (!data) {
+        return QString();
+    }
+    return stringAt(readValue<quint32>(data + RecordStrings + which * 4));
+}
+
+QDateTime CatalogSnapshot::dateFromMSecs(qint64 msecs)
+{
+    if (msecs == InvalidDate) {
+        return QDateTime();
+    }
+    return QDateTime::fromMSecsSinceEpoch(msecs);
+}
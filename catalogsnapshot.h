@@ -0,0 +1,82 @@
+#ifndef CATALOGSNAPSHOT_H
+#define CATALOGSNAPSHOT_H
+
+#include <QString>
+#include <QList>
+#include <QFile>
+#include <QDateTime>
+#include <QJsonObject>
+#include "appinfo.h"
+#include "appstore.h"
+
+// apps.json と並べて保存するバイナリスナップショット（起動高速化用）
+//
+// ファイル構成:
+//   [Header] [Record × recordCount] [文字列オフセット表 × stringCount] [文字列アリーナ]
+// Recordは固定長で、文字列はオフセット表のインデックスで参照する。
+// 文字列アリーナの各要素は「UTF-16長(quint32) + UTF-16データ」で4バイト境界に揃える。
+// ヘッダーに元のapps.jsonのサイズと更新時刻を持ち、一致しない場合は古いとみなす。
+class CatalogSnapshot
+{
+public:
+    static const quint32 FormatVersion = 1;
+
+    CatalogSnapshot();
+    ~CatalogSnapshot();
+
+    // 書き込み（sourcePathは書き込み直後のapps.json）
+    static bool write(const QString &snapshotPath, const AppStore &store,
+                      const QJsonObject &categories, const QString &sourcePath);
+
+    // mmapで開く（欠落・バージョン違い・apps.jsonと食い違う場合はfalse）
+    bool open(const QString &snapshotPath, const QString &sourcePath);
+    void close();
+    bool isOpen() const;
+
+    // 各フィールドはアクセス時にのみデコードする
+    int count() const;
+    QString id(int row) const;
+    QString name(int row) const;
+    QString path(int row) const;
+    QString iconPath(int row) const;
+    QString description(int row) const;
+    QString category(int row) const;
+    int launchCount(int row) const;
+    QDateTime lastLaunch(int row) const;
+    QDateTime createdAt(int row) const;
+    AppInfo app(int row) const;
+    QJsonObject categories() const;
+
+    // 全レコードをAppInfoやQDateTimeを介さずにstoreの末尾へ追加する（名前かパスが空の行は飛ばす）
+    int loadInto(AppStore *store) const;
+
+private:
+    enum StringField {
+        FieldId = 0,
+        FieldName,
+        FieldPath,
+        FieldIconPath,
+        FieldDescription,
+        FieldCategory,
+        FieldCount
+    };
+
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    quint32 m_recordCount;
+    quint32 m_stringCount;
+    quint32 m_recordsOffset;
+    quint32 m_offsetTableOffset;
+    quint32 m_arenaOffset;
+    quint32 m_arenaSize;
+    quint32 m_categoriesString;
+
+    const uchar *record(int row) const;
+    QStringView stringView(quint32 index) const;     // マップ中の領域を指す（close()まで有効）
+    QString stringAt(quint32 index) const;
+    QString field(int row, StringField which) const;
+    static QDateTime dateFromMSecs(qint64 msecs);
+};
+
+#endif // CATALOGSNAPSHOT_H
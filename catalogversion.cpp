@@ -0,0 +1,260 @@
+#include "catalogversion.h"
+#include <QSet>
+
+namespace {
+
+bool sameRow(const AppStore::Row &a, const AppStore::Row &b)
+{
+    return a.name() == b.name()
+        && a.path() == b.path()
+        && a.iconPath() == b.iconPath()
+        && a.description() == b.description()
+        && a.category() == b.category()
+        && a.launchCount() == b.launchCount()
+        && a.lastLaunchMSecs() == b.lastLaunchMSecs()
+        && a.createdAt() == b.createdAt();
+}
+
+}
+
+// ---- CatalogChangeSet ----
+
+CatalogChangeSet::CatalogChangeSet()
+    : m_fromVersion(0)
+    , m_toVersion(0)
+    , m_reset(false)
+{
+}
+
+CatalogChangeSet::CatalogChangeSet(quint64 fromVersion, quint64 toVersion)
+    : m_fromVersion(fromVersion)
+    , m_toVersion(toVersion)
+    , m_reset(false)
+{
+}
+
+quint64 CatalogChangeSet::fromVersion() const
+{
+    return m_fromVersion;
+}
+
+quint64 CatalogChangeSet::toVersion() const
+{
+    return m_toVersion;
+}
+
+void CatalogChangeSet::setVersions(quint64 fromVersion, quint64 toVersion)
+{
+    m_fromVersion = fromVersion;
+    m_toVersion = toVersion;
+}
+
+bool CatalogChangeSet::isReset() const
+{
+    return m_reset;
+}
+
+bool CatalogChangeSet::isEmpty() const
+{
+    return !m_reset && m_changes.isEmpty();
+}
+
+int CatalogChangeSet::size() const
+{
+    return m_changes.size();
+}
+
+void CatalogChangeSet::markAdded(const QString &appId)
+{
+    apply(appId, Added);
+}
+
+void CatalogChangeSet::markRemoved(const QString &appId)
+{
+    apply(appId, Removed);
+}
+
+void CatalogChangeSet::markUpdated(const QString &appId)
+{
+    apply(appId, Updated);
+}
+
+void CatalogChangeSet::markReset()
+{
+    // 全体を読み直すので個々の変更は不要
+    m_reset = true;
+    m_changes.clear();
+    m_order.clear();
+}
+
+void CatalogChangeSet::merge(const CatalogChangeSet &next)
+{
+    if (next.m_reset) {
+        markReset();
+    } else if (!m_reset) {
+        QSet<QString> seen;
+        for (const QString &appId : next.m_order) {
+            auto it = next.m_changes.constFind(appId);
+            if (it != next.m_changes.constEnd() && !seen.contains(appId)) {
+                seen.insert(appId);
+                apply(appId, it.value());
+            }
+        }
+    }
+    m_toVersion = next.m_toVersion;
+}
+
+QStringList CatalogChangeSet::added() const
+{
+    return idsOf(Added);
+}
+
+QStringList CatalogChangeSet::removed() const
+{
+    return idsOf(Removed);
+}
+
+QStringList CatalogChangeSet::updated() const
+{
+    return idsOf(Updated);
+}
+
+void CatalogChangeSet::apply(const QString &appId, Change change)
+{
+    if (m_reset) {
+        return;
+    }
+
+    auto it = m_changes.find(appId);
+    if (it == m_changes.end()) {
+        m_changes.insert(appId, change);
+        m_order.append(appId);
+        return;
+    }
+
+    // 既にある変更との畳み込み
+    if (it.value() == Added) {
+        if (change == Removed) {
+            m_changes.erase(it);    // 追加して削除したものは無かったことにする
+        }
+    } else if (it.value() == Removed) {
+        it.value() = Updated;       // 削除して同じIDで追加し直したものは更新
+    } else if (change == Removed) {
+        it.value() = Removed;
+    }
+}
+
+QStringList CatalogChangeSet::idsOf(Change change) const
+{
+    QStringList result;
+    QSet<QString> seen;
+    for (const QString &appId : m_order) {
+        auto it = m_changes.constFind(appId);
+        if (it != m_changes.constEnd() && it.value() == change && !seen.contains(appId)) {
+            seen.insert(appId);
+            result.append(appId);
+        }
+    }
+    return result;
+}
+
+// ---- CatalogVersion ----
+
+CatalogVersion::CatalogVersion()
+    : m_version(0)
+{
+}
+
+CatalogVersion::CatalogVersion(const CatalogVersion &previous, const AppStore &store,
+                               const ShardedHash<QString, int> &idIndex, const CatalogChangeSet &changes)
+    : m_version(previous.m_version + 1)
+    , m_store(store)
+    , m_idIndex(idIndex)
+    , m_history(previous.m_history)
+{
+    CatalogChangeSet step = changes;
+    step.setVersions(previous.m_version, m_version);
+    m_history.append(step);
+    while (m_history.size() > HistoryLimit) {
+        m_history.removeFirst();
+    }
+}
+
+quint64 CatalogVersion::version() const
+{
+    return m_version;
+}
+
+const AppStore &CatalogVersion::store() const
+{
+    return m_store;
+}
+
+int CatalogVersion::size() const
+{
+    return m_store.size();
+}
+
+int CatalogVersion::rowOf(const QString &appId) const
+{
+    return m_idIndex.value(appId, -1);
+}
+
+AppStore::Row CatalogVersion::findApp(const QString &appId) const
+{
+    int row = rowOf(appId);
+    return row >= 0 ? m_store.row(row) : AppStore::Row();
+}
+
+CatalogChangeSet CatalogVersion::changesSince(quint64 version) const
+{
+    CatalogChangeSet changes(version, m_version);
+    if (version == m_version) {
+        return changes;
+    }
+
+    // 履歴は版の順に連続しているので、指定の版から始まる変更以降を畳み込む
+    int start = -1;
+    for (int i = 0; i < m_history.size(); ++i) {
+        if (m_history.at(i).fromVersion() == version) {
+            start = i;
+            break;
+        }
+    }
+    if (start < 0) {
+        changes.markReset();
+        return changes;
+    }
+
+    for (int i = start; i < m_history.size(); ++i) {
+        changes.merge(m_history.at(i));
+    }
+    return changes;
+}
+
+CatalogChangeSet CatalogVersion::diff(const CatalogVersion &from, const CatalogVersion &to)
+{
+    CatalogChangeSet changes = to.changesSince(from.m_version);
+    if (!changes.isReset()) {
+        return changes;
+    }
+
+    // 履歴で追えない場合は両方の版を突き合わせる（O(n)）
+    changes = CatalogChangeSet(from.m_version, to.m_version);
+    for (int row = 0; row < from.m_store.size(); ++row) {
+        const QString appId = from.m_store.id(row);
+        int other = to.rowOf(appId);
+        if (other < 0) {
+            changes.markRemoved(appId);
+        } else if (!sameRow(from.m_store.row(row), to.m_store.row(other))) {
+            changes.markUpdated(appId);
+        }
+    }
+    for (int row = 0; row < to.m_store.size(); ++row) {
+        const QString appId = to.m_store.id(row);
+        if (from.rowOf(appId) < 0) {
+            changes.markAdded(appId);
+        }
+    }
+    return changes;
+}
@@ -0,0 +1,96 @@
+#ifndef CATALOGVERSION_H
+#define CATALOGVERSION_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QMetaType>
+#include <memory>
+#include "appstore.h"
+#include "shardedhash.h"
+
+// ある版から別の版へのカタログの変更（アプリIDごとに追加・削除・更新のいずれか）
+// 途中の変更は畳み込まれる（追加→削除は消え、削除→追加は更新になる）。
+// 全件読み込みなど個々の変更を追えない場合は isReset() となり、受け手は全体を読み直す。
+class CatalogChangeSet
+{
+public:
+    enum Change {
+        Added,
+        Removed,
+        Updated
+    };
+
+    CatalogChangeSet();
+    CatalogChangeSet(quint64 fromVersion, quint64 toVersion);
+
+    quint64 fromVersion() const;
+    quint64 toVersion() const;
+    void setVersions(quint64 fromVersion, quint64 toVersion);
+
+    bool isReset() const;
+    bool isEmpty() const;
+    int size() const;
+
+    void markAdded(const QString &appId);
+    void markRemoved(const QString &appId);
+    void markUpdated(const QString &appId);
+    void markReset();
+    void merge(const CatalogChangeSet &next);   // next は toVersion() から始まる変更
+
+    // 最初に変更された順のアプリID
+    QStringList added() const;
+    QStringList removed() const;
+    QStringList updated() const;
+
+private:
+    quint64 m_fromVersion;
+    quint64 m_toVersion;
+    bool m_reset;
+    QHash<QString, Change> m_changes;
+    QStringList m_order;    // 打ち消された・重複したIDも含む（取り出し時に除く）
+
+    void apply(const QString &appId, Change change);
+    QStringList idsOf(Change change) const;
+};
+
+// 不変のカタログの版（RCU方式で公開し、読み手は参照を保持している間この版を使い続けられる）
+//
+// ストアとIDの索引はチャンク・分割単位の暗黙共有の複製なので、版を作るコストは参照カウントの増加だけで済む。
+// 書き手が次に変更したチャンクだけが複製され、それ以外は版の間で共有される。
+// 直近の変更履歴を持つので、読み手は手元の版からの差分を取り出して増分で更新できる。
+class CatalogVersion
+{
+public:
+    CatalogVersion();   // 版0（空のカタログ）
+    CatalogVersion(const CatalogVersion &previous, const AppStore &store,
+                   const ShardedHash<QString, int> &idIndex, const CatalogChangeSet &changes);
+
+    quint64 version() const;
+    const AppStore &store() const;
+    int size() const;
+
+    int rowOf(const QString &appId) const;              // 見つからなければ -1
+    AppStore::Row findApp(const QString &appId) const;  // この版を保持している間有効
+
+    // 指定した版からこの版までの変更（履歴にない古い版なら isReset()）
+    CatalogChangeSet changesSince(quint64 version) const;
+
+    // 任意の2つの版の差分（履歴で追えなければ内容を突き合わせる）
+    static CatalogChangeSet diff(const CatalogVersion &from, const CatalogVersion &to);
+
+    static const int HistoryLimit = 64;
+
+private:
+    quint64 m_version;
+    AppStore m_store;
+    ShardedHash<QString, int> m_idIndex;
+    QList<CatalogChangeSet> m_history;  // 古い順。末尾がこの版への変更
+};
+
+typedef std::shared_ptr<const CatalogVersion> CatalogVersionPtr;
+
+Q_DECLARE_METATYPE(CatalogChangeSet)
+
+#endif // CATALOGVERSION_H
@@ -0,0 +1,204 @@
+#include "categoryclassifier.h"
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+CategoryClassifier::CategoryClassifier()
+    : d(compile(defaultRules()))
+{
+}
+
+CategoryClassifier::CategoryClassifier(const QList<Rule> &rules)
+    : d(compile(rules))
+{
+}
+
+QList<CategoryClassifier::Rule> CategoryClassifier::defaultRules()
+{
+    // 以前の判定順（ゲーム → 開発 → ビジネス → メディア → ツール）を優先度で表す
+    QList<Rule> rules;
+
+    Rule game;
+    game.category = "ゲーム";
+    game.priority = 50;
+    game.keywords << "game" << "steam" << "epic" << "gog" << "origin"
+                  << "uplay" << "battle.net" << "minecraft" << "unity"
+                  << "unreal" << "fps" << "rpg" << "mmo" << "arcade";
+    rules.append(game);
+
+    Rule development;
+    development.category = "開発";
+    development.priority = 40;
+    development.keywords << "visual studio" << "code" << "dev" << "git"
+                         << "python" << "java" << "node" << "npm" << "compiler"
+                         << "debugger" << "ide" << "editor" << "qt" << "android studio";
+    rules.append(development);
+
+    Rule business;
+    business.category = "ビジネス";
+    business.priority = 30;
+    business.keywords << "office" << "word" << "excel" << "powerpoint"
+                      << "outlook" << "teams" << "zoom" << "skype" << "slack"
+                      << "adobe" << "acrobat" << "reader" << "calculator";
+    rules.append(business);
+
+    Rule media;
+    media.category = "メディア";
+    media.priority = 20;
+    media.keywords << "vlc" << "media" << "player" << "music" << "video"
+                   << "photo" << "image" << "audio" << "spotify" << "itunes"
+                   << "photoshop" << "premiere" << "audacity" << "gimp";
+    rules.append(media);
+
+    Rule tool;
+    tool.category = "ツール";
+    tool.priority = 10;
+    tool.keywords << "tool" << "utility" << "manager" << "browser"
+                  << "chrome" << "firefox" << "explorer" << "notepad"
+                  << "archive" << "zip" << "rar" << "antivirus" << "clean";
+    rules.append(tool);
+
+    return rules;
+}
+
+QString CategoryClassifier::defaultCategory()
+{
+    return "その他";
+}
+
+QList<CategoryClassifier::Rule> CategoryClassifier::rules() const
+{
+    return d->rules;
+}
+
+QString CategoryClassifier::classify(const QString &name, const QString &path) const
+{
+    int best = -1;
+    scan(name, &best);
+    if (best < 0 || best != d->topRule) {
+        scan(path, &best);
+    }
+    return best >= 0 ? d->rules.at(best).category : defaultCategory();
+}
+
+QString CategoryClassifier::defaultFilePath()
+{
+    // 除外リストと同じくアプリケーション実行ディレクトリ下に置く
+    return QDir(QApplication::applicationDirPath()).filePath("category_rules.json");
+}
+
+bool CategoryClassifier::readRules(const QString &filePath, QList<Rule> *rules)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        qWarning() << "Invalid category rules file:" << filePath << error.errorString();
+        return false;
+    }
+
+    rules->clear();
+    const QJsonArray array = doc.object().value("rules").toArray();
+    for (const QJsonValue &value : array) {
+        const QJsonObject obj = value.toObject();
+        Rule rule;
+        rule.category = obj.value("category").toString().trimmed();
+        rule.priority = obj.value("priority").toInt();
+        for (const QJsonValue &keyword : obj.value("keywords").toArray()) {
+            const QString text = keyword.toString();
+            if (!text.isEmpty()) {
+                rule.keywords.append(text);
+            }
+        }
+        if (!rule.category.isEmpty() && !rule.keywords.isEmpty()) {
+            rules->append(rule);
+        }
+    }
+    return true;
+}
+
+bool CategoryClassifier::writeRules(const QString &filePath, const QList<Rule> &rules)
+{
+    QJsonArray array;
+    for (const Rule &rule : rules) {
+        QJsonObject obj;
+        obj["category"] = rule.category;
+        obj["priority"] = rule.priority;
+        obj["keywords"] = QJsonArray::fromStringList(rule.keywords);
+        array.append(obj);
+    }
+    QJsonObject root;
+    root["rules"] = array;
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return file.commit();
+}
+
+QSharedPointer<const CategoryClassifier::Data> CategoryClassifier::compile(const QList<Rule> &rules)
+{
+    QSharedPointer<Data> data(new Data);
+    data->rules = rules;
+
+    for (int i = 0; i < rules.size(); ++i) {
+        const Rule &rule = rules.at(i);
+        if (data->topRule < 0 || rule.priority > rules.at(data->topRule).priority) {
+            data->topRule = i;
+        }
+        for (const QString &keyword : rule.keywords) {
+            const QString lower = keyword.toLower();
+            if (lower.isEmpty()) {
+                continue;
+            }
+            // 複数の規則に同じキーワードがあれば、優先される方だけを覚えておく
+            const int index = data->keywords.addKeyword(lower);
+            if (index == data->keywordRule.size()) {
+                data->keywordRule.append(i);
+            } else if (rule.priority > rules.at(data->keywordRule.at(index)).priority) {
+                data->keywordRule[index] = i;
+            }
+        }
+    }
+    data->keywords.build();
+    return data;
+}
+
+bool CategoryClassifier::isBetter(int rule, int current) const
+{
+    // 優先度が同じなら表で先にある方
+    if (current < 0) {
+        return true;
+    }
+    const int priority = d->rules.at(rule).priority;
+    const int currentPriority = d->rules.at(current).priority;
+    return priority > currentPriority || (priority == currentPriority && rule < current);
+}
+
+void CategoryClassifier::scan(const QString &text, int *best) const
+{
+    int state = 0;
+    for (const QChar c : text) {
+        state = d->keywords.step(state, c.toLower());
+        for (int keyword : d->keywords.keywordsAt(state)) {
+            const int rule = d->keywordRule.at(keyword);
+            if (isBetter(rule, *best)) {
+                *best = rule;
+            }
+        }
+        if (*best >= 0 && *best == d->topRule) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef CATEGORYCLASSIFIER_H
+#define CATEGORYCLASSIFIER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSharedPointer>
+#include "keywordautomaton.h"
+
+// 実行ファイルの名前とパスからカテゴリを推定する分類器
+//
+// 規則は「カテゴリ・優先度・キーワード」の表で、全規則のキーワードを1つのオートマトンにまとめて
+// 名前とパスをそれぞれ1回だけ走査する。キーワードが現れた規則のうち優先度の最も高いもの
+// （同じなら表で先にあるもの）を採用し、どれも現れなければ defaultCategory() を返す。
+// 大文字小文字は区別しない。コンパイル済みの表は共有され、コピーは安価で、複数スレッドから同時に使える。
+//
+// 規則は category_rules.json で編集できる:
+//   { "rules": [ { "category": "ゲーム", "priority": 50, "keywords": ["game", "steam"] }, ... ] }
+class CategoryClassifier
+{
+public:
+    struct Rule {
+        QString category;
+        int priority = 0;
+        QStringList keywords;
+    };
+
+    CategoryClassifier();       // 組み込みの規則
+    explicit CategoryClassifier(const QList<Rule> &rules);
+
+    static QList<Rule> defaultRules();
+    static QString defaultCategory();
+
+    QList<Rule> rules() const;
+    QString classify(const QString &name, const QString &path) const;
+
+    // 規則ファイルの読み書き
+    static QString defaultFilePath();
+    static bool readRules(const QString &filePath, QList<Rule> *rules);
+    static bool writeRules(const QString &filePath, const QList<Rule> &rules);
+
+private:
+    struct Data {
+        QList<Rule> rules;
+        KeywordAutomaton keywords;
+        QList<int> keywordRule;     // キーワード番号 → そのキーワードを持つ最優先の規則
+        int topRule = -1;           // 最も優先される規則（これに当たればそれ以上探さない）
+    };
+
+    QSharedPointer<const Data> d;
+
+    static QSharedPointer<const Data> compile(const QList<Rule> &rules);
+    bool isBetter(int rule, int current) const;
+    void scan(const QString &text, int *best) const;
+};
+
+#endif // CATEGORYCLASSIFIER_H
@@ -0,0 +1,110 @@
+#ifndef CHUNKEDVECTOR_H
+#define CHUNKEDVECTOR_H
+
+#include <QVector>
+
+// 固定長のチャンクに分けて要素を持つ配列（カタログの列用）
+//
+// 外側の配列はチャンクの暗黙共有のハンドルだけを持つので、複製は要素数/ChunkSize 個の
+// 参照カウントの増加で済む。複製後に1要素を書き換えても、複製されるのはそのチャンクだけになる
+// （版として公開したカタログを書き手が変更しても、全体の複製は起こらない）。
+template <typename T>
+class ChunkedVector
+{
+public:
+    static const int ChunkShift = 10;
+    static const int ChunkSize = 1 << ChunkShift;
+
+    ChunkedVector() : m_size(0) {}
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    void clear()
+    {
+        m_chunks.clear();
+        m_size = 0;
+    }
+
+    void reserve(int count)
+    {
+        m_chunks.reserve((count + ChunkSize - 1) >> ChunkShift);
+    }
+
+    const T &at(int index) const
+    {
+        return m_chunks.at(index >> ChunkShift).at(index & (ChunkSize - 1));
+    }
+
+    // 書き込み用の参照（そのチャンクだけを複製する）
+    T &operator[](int index)
+    {
+        return m_chunks[index >> ChunkShift][index & (ChunkSize - 1)];
+    }
+
+    void append(const T &value)
+    {
+        if ((m_size & (ChunkSize - 1)) == 0) {
+            m_chunks.append(QVector<T>());
+            m_chunks.last().reserve(ChunkSize);
+        }
+        m_chunks.last().append(value);
+        ++m_size;
+    }
+
+    // 位置 index 以降を1つずつ前に詰める（書き換わるのは index を含むチャンクから後ろだけ）
+    void removeAt(int index)
+    {
+        for (int i = index; i + 1 < m_size; ++i) {
+            const T next = at(i + 1);
+            (*this)[i] = next;
+        }
+        truncate(m_size - 1);
+    }
+
+    // 印の付いた要素を除いて前に詰める（最初の印より前のチャンクは共有したまま）
+    void removeMarked(const QVector<bool> &marked)
+    {
+        int out = 0;
+        for (int i = 0; i < m_size; ++i) {
+            if (marked.at(i)) {
+                continue;
+            }
+            if (out != i) {
+                const T value = at(i);
+                (*this)[out] = value;
+            }
+            ++out;
+        }
+        truncate(out);
+    }
+
+    void truncate(int count)
+    {
+        if (count >= m_size) {
+            return;
+        }
+        const int chunkCount = (count + ChunkSize - 1) >> ChunkShift;
+        m_chunks.resize(chunkCount);
+        const int tail = count & (ChunkSize - 1);
+        if (tail != 0 && m_chunks.last().size() != tail) {
+            m_chunks.last().resize(tail);
+        }
+        m_size = count;
+    }
+
+    qint64 capacity() const
+    {
+        qint64 total = 0;
+        for (const QVector<T> &chunk : m_chunks) {
+            total += chunk.capacity();
+        }
+        return total;
+    }
+
+private:
+    QVector<QVector<T>> m_chunks;
+    int m_size;
+};
+
+#endif // CHUNKEDVECTOR_H
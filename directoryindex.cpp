@@ -0,0 +1,187 @@
+#include "directoryindex.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDir>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+const char IndexMagic[4] = {'G', 'L', 'D', 'I'};
+
+// 1件の最小の大きさ（パス・サブフォルダ・ファイルの各長さで少なくとも4バイトずつ）
+const qint64 MinEntryBytes = 12;
+
+QDataStream &operator<<(QDataStream &out, const DirectoryIndex::Entry &entry)
+{
+    return out << entry.modified << entry.subdirs << entry.files;
+}
+
+QDataStream &operator>>(QDataStream &in, DirectoryIndex::Entry &entry)
+{
+    return in >> entry.modified >> entry.subdirs >> entry.files;
+}
+
+// dirPath 自身またはその親が removedDirs に含まれるか
+bool isUnderRemoved(const QString &dirPath, const QSet<QString> &removedDirs)
+{
+    QString path = dirPath;
+    for (;;) {
+        if (removedDirs.contains(path)) {
+            return true;
+        }
+        const int slash = path.lastIndexOf('/');
+        if (slash <= 0) {
+            return false;
+        }
+        path.truncate(slash);
+    }
+}
+
+}
+
+DirectoryIndex::DirectoryIndex()
+    : m_dirty(false)
+{
+}
+
+bool DirectoryIndex::load(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    char magic[4];
+    if (file.read(magic, sizeof(magic)) != sizeof(magic) || std::memcmp(magic, IndexMagic, sizeof(magic)) != 0) {
+        qWarning() << "Ignoring directory index with unknown format:" << filePath;
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 version = 0;
+    in >> version;
+    if (version != FormatVersion) {
+        qDebug() << "Ignoring directory index version" << version << "at" << filePath;
+        return false;
+    }
+
+    QStringList nameFilters;
+    quint32 count = 0;
+    in >> nameFilters >> count;
+
+    QHash<QString, Entry> entries;
+    // 件数はファイルから読んだ値なので、残りの大きさで収まる件数までしか確保しない
+    entries.reserve(int(qMin(qint64(count), file.bytesAvailable() / MinEntryBytes)));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString dirPath;
+        Entry entry;
+        in >> dirPath >> entry;
+        entries.insert(dirPath, entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "Directory index is truncated or corrupt:" << filePath;
+        return false;
+    }
+
+    m_nameFilters = nameFilters;
+    m_entries.swap(entries);
+    m_dirty = false;
+    qDebug() << "Loaded directory index with" << m_entries.size() << "directories from" << filePath;
+    return true;
+}
+
+bool DirectoryIndex::save(const QString &filePath)
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot open directory index for writing:" << filePath;
+        return false;
+    }
+
+    file.write(IndexMagic, sizeof(IndexMagic));
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << FormatVersion << m_nameFilters << quint32(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        out << it.key() << it.value();
+    }
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Failed to write directory index:" << filePath << file.errorString();
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+void DirectoryIndex::setNameFilters(const QStringList &nameFilters)
+{
+    if (nameFilters != m_nameFilters) {
+        m_entries.clear();
+        m_nameFilters = nameFilters;
+        m_dirty = true;
+    }
+}
+
+QStringList DirectoryIndex::nameFilters() const
+{
+    return m_nameFilters;
+}
+
+bool DirectoryIndex::lookup(const QString &dirPath, Entry *entry) const
+{
+    auto it = m_entries.constFind(keyFor(dirPath));
+    if (it == m_entries.constEnd()) {
+        return false;
+    }
+    *entry = it.value();
+    return true;
+}
+
+void DirectoryIndex::merge(const QHash<QString, Entry> &visited, const QSet<QString> &removedDirs)
+{
+    if (!removedDirs.isEmpty()) {
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (isUnderRemoved(it.key(), removedDirs)) {
+                it = m_entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        m_dirty = true;
+    }
+
+    // 前回の結果をそのまま使ったフォルダは変わらないので、保存が必要かどうかは中身で判断する
+    for (auto it = visited.constBegin(); it != visited.constEnd(); ++it) {
+        Entry &entry = m_entries[it.key()];
+        const Entry &scanned = it.value();
+        if (entry.modified != scanned.modified || entry.subdirs != scanned.subdirs || entry.files != scanned.files) {
+            entry = scanned;
+            m_dirty = true;
+        }
+    }
+}
+
+int DirectoryIndex::size() const
+{
+    return m_entries.size();
+}
+
+bool DirectoryIndex::isDirty() const
+{
+    return m_dirty;
+}
+
+void DirectoryIndex::clear()
+{
+    m_entries.clear();
+    m_dirty = true;
+}
+
+QString DirectoryIndex::keyFor(const QString &dirPath)
+{
+    return QDir::cleanPath(dirPath);
+}
@@ -0,0 +1,55 @@
+#ifndef DIRECTORYINDEX_H
+#define DIRECTORYINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+
+// 前回のスキャンで列挙したフォルダの内容を保存しておく索引（再スキャン高速化用）
+//
+// フォルダの更新時刻は直下のファイル・フォルダの追加・削除・名前変更で変わるので、
+// 更新時刻が前回と同じフォルダは列挙し直さずに前回のサブフォルダ名とファイル名を使う。
+// 変わらないフォルダで必要になるのは更新時刻の確認（stat）1回だけになる。
+// ネームフィルタの違う索引は使わない。
+//
+// ファイル構成: [マジック "GLDI"] [FormatVersion] [QDataStream: ネームフィルタ, エントリ数, エントリ...]
+class DirectoryIndex
+{
+public:
+    static const quint32 FormatVersion = 1;
+
+    struct Entry {
+        qint64 modified = 0;        // フォルダの更新時刻（ms）
+        QStringList subdirs;        // サブフォルダ名
+        QStringList files;          // ネームフィルタに一致したファイル名
+    };
+
+    DirectoryIndex();
+
+    bool load(const QString &filePath);
+    bool save(const QString &filePath);
+
+    // フィルタが変わった場合は保持している内容を捨てる
+    void setNameFilters(const QStringList &nameFilters);
+    QStringList nameFilters() const;
+
+    // スキャン中は複数のワーカーから同時に呼ばれる（その間は変更しない）
+    bool lookup(const QString &dirPath, Entry *entry) const;
+
+    // スキャン結果を反映する（removedDirs は消えたフォルダ。その下のエントリも削除する）
+    void merge(const QHash<QString, Entry> &visited, const QSet<QString> &removedDirs);
+
+    int size() const;
+    bool isDirty() const;
+    void clear();
+
+    static QString keyFor(const QString &dirPath);
+
+private:
+    QStringList m_nameFilters;
+    QHash<QString, Entry> m_entries;
+    bool m_dirty;
+};
+
+#endif // DIRECTORYINDEX_H
@@ -0,0 +1,438 @@
+#include "directoryscanner.h"
+#include <QDirIterator>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QDebug>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const int CollectInterval = 50;     // 結果の回収・進捗通知の間隔（ms）
+const int IdleWait = 5;             // 盗めるタスクが無いときの待ち時間（ms）
+
+struct Task {
+    QString path;
+    int depth;
+};
+
+// ワーカー1つ分のタスクデックと結果バッファ
+// デックは持ち主が末尾、盗む側が先頭を使う。結果バッファは持ち主と回収側しか触らない。
+struct WorkerQueue {
+    QMutex taskMutex;
+    std::deque<Task> tasks;
+
+    QMutex resultMutex;
+    QList<AppInfo> found;
+    QString currentPath;
+
+    // 索引へ反映する内容（持ち主だけが書き、全ワーカーの終了後に回収する）
+    QHash<QString, DirectoryIndex::Entry> visited;
+    QSet<QString> removed;
+};
+
+class ScanRun
+{
+public:
+    ScanRun(int threadCount, int maxDepth, const QStringList &nameFilters,
+            const DirectoryScanner::DirectoryFilter &directoryFilter,
+            const DirectoryScanner::FileHandler &fileHandler,
+            const QAtomicInt *canceled, const DirectoryIndex *index)
+        : m_maxDepth(maxDepth)
+        , m_nameFilters(nameFilters)
+        , m_directoryFilter(directoryFilter)
+        , m_fileHandler(fileHandler)
+        , m_canceled(canceled)
+        , m_index(index)
+        , m_pending(0)
+        , m_scanned(0)
+        , m_reused(0)
+        , m_queued(0)
+        , m_idle(0)
+    {
+        for (int i = 0; i < threadCount; ++i) {
+            m_queues.emplace_back(new WorkerQueue);
+        }
+    }
+
+    // ルートはワーカーに順に割り振る（ドライブの違うルートが別々のワーカーから始まる）
+    void seed(const QStringList &roots)
+    {
+        int next = 0;
+        for (const QString &root : roots) {
+            if (m_maxDepth <= 0 || (m_directoryFilter && m_directoryFilter(root))) {
+                continue;
+            }
+            push(next, Task{root, 0});
+            next = (next + 1) % int(m_queues.size());
+        }
+    }
+
+    void runWorker(int index)
+    {
+        Task task;
+        while (!isCanceled()) {
+            if (!popLocal(index, &task) && !steal(index, &task)) {
+                if (m_pending.loadAcquire() == 0) {
+                    break;
+                }
+                QMutexLocker locker(&m_idleMutex);
+                m_idle.ref();
+                m_workAvailable.wait(&m_idleMutex, IdleWait);
+                m_idle.deref();
+                continue;
+            }
+
+            scanDirectory(index, task);
+            if (!m_pending.deref()) {
+                // 最後のタスク。待っている回収側とワーカーを起こす
+                QMutexLocker locker(&m_idleMutex);
+                m_workAvailable.wakeAll();
+            }
+        }
+    }
+
+    bool isFinished() const
+    {
+        return m_pending.loadAcquire() == 0 || isCanceled();
+    }
+
+    void waitForProgress()
+    {
+        QMutexLocker locker(&m_idleMutex);
+        if (!isFinished()) {
+            m_workAvailable.wait(&m_idleMutex, CollectInterval);
+        }
+    }
+
+    // 各ワーカーの結果バッファを引き取る
+    QList<AppInfo> collect(QString *currentPath)
+    {
+        QList<AppInfo> results;
+        for (const std::unique_ptr<WorkerQueue> &queue : m_queues) {
+            QMutexLocker locker(&queue->resultMutex);
+            if (!queue->found.isEmpty()) {
+                results.append(queue->found);
+                queue->found.clear();
+            }
+            if (currentPath && !queue->currentPath.isEmpty()) {
+                *currentPath = queue->currentPath;
+            }
+        }
+        return results;
+    }
+
+    int scanned() const { return m_scanned.loadRelaxed(); }
+    int queued() const { return m_queued.loadRelaxed(); }
+    int reused() const { return m_reused.loadRelaxed(); }
+
+    // ワーカーの終了後に呼ぶ
+    void collectIndex(QHash<QString, DirectoryIndex::Entry> *visited, QSet<QString> *removed)
+    {
+        for (const std::unique_ptr<WorkerQueue> &queue : m_queues) {
+            visited->insert(queue->visited);
+            removed->unite(queue->removed);
+        }
+    }
+
+private:
+    int m_maxDepth;
+    QStringList m_nameFilters;
+    DirectoryScanner::DirectoryFilter m_directoryFilter;
+    DirectoryScanner::FileHandler m_fileHandler;
+    const QAtomicInt *m_canceled;
+    const DirectoryIndex *m_index;
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    QAtomicInt m_pending;       // 積まれてまだ処理の終わっていないタスク数
+    QAtomicInt m_scanned;
+    QAtomicInt m_reused;
+    QAtomicInt m_queued;
+    QAtomicInt m_idle;
+    QMutex m_idleMutex;
+    QWaitCondition m_workAvailable;
+
+    bool isCanceled() const
+    {
+        return m_canceled && m_canceled->loadRelaxed();
+    }
+
+    void push(int index, const Task &task)
+    {
+        // 親タスクの完了より先に数えるので、処理中に m_pending が0になることはない
+        m_pending.ref();
+        m_queued.ref();
+        {
+            QMutexLocker locker(&m_queues[index]->taskMutex);
+            m_queues[index]->tasks.push_back(task);
+        }
+        if (m_idle.loadRelaxed() > 0) {
+            m_workAvailable.wakeOne();
+        }
+    }
+
+    bool popLocal(int index, Task *task)
+    {
+        WorkerQueue &queue = *m_queues[index];
+        QMutexLocker locker(&queue.taskMutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        *task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(int index, Task *task)
+    {
+        const int count = int(m_queues.size());
+        for (int offset = 1; offset < count; ++offset) {
+            WorkerQueue &victim = *m_queues[(index + offset) % count];
+            QMutexLocker locker(&victim.taskMutex);
+            if (!victim.tasks.empty()) {
+                *task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void pushSubdir(int index, const QString &dirPath, int depth)
+    {
+        if (!m_directoryFilter || !m_directoryFilter(dirPath)) {
+            push(index, Task{dirPath, depth});
+        }
+    }
+
+    void handleFile(const QFileInfo &fileInfo, QList<AppInfo> *found)
+    {
+        AppInfo app;
+        if (m_fileHandler && m_fileHandler(fileInfo, &app)) {
+            found->append(app);
+        }
+    }
+
+    void scanDirectory(int index, const Task &task)
+    {
+        WorkerQueue &queue = *m_queues[index];
+        {
+            QMutexLocker locker(&queue.resultMutex);
+            queue.currentPath = task.path;
+        }
+
+        const bool descend = task.depth + 1 < m_maxDepth;
+        const QString key = DirectoryIndex::keyFor(task.path);
+        QList<AppInfo> found;
+
+        // 列挙より先に更新時刻を取る（列挙中に変わっても次回は列挙し直される）
+        const QDateTime modified = QFileInfo(task.path).lastModified();
+        DirectoryIndex::Entry cached;
+        const bool hasCached = m_index && m_index->lookup(task.path, &cached);
+
+        if (hasCached && modified.isValid() && cached.modified == modified.toMSecsSinceEpoch()) {
+            // 前回から変わっていないフォルダ。ファイルは属性だけ確かめ直す（除外設定が変わっている場合もある）
+            if (descend) {
+                for (const QString &name : cached.subdirs) {
+                    pushSubdir(index, task.path + '/' + name, task.depth + 1);
+                }
+            }
+            for (const QString &name : cached.files) {
+                if (isCanceled()) {
+                    return;
+                }
+                handleFile(QFileInfo(task.path + '/' + name), &found);
+            }
+            queue.visited.insert(key, cached);
+            m_reused.ref();
+        } else {
+            // ファイルとサブフォルダを1回の列挙で取得する（AllDirs はネームフィルタの対象外）
+            // 索引のためにサブフォルダ名は辿らない階層でも記録する
+            DirectoryIndex::Entry entry;
+            entry.modified = modified.isValid() ? modified.toMSecsSinceEpoch() : 0;
+
+            QDirIterator it(task.path, m_nameFilters,
+                            QDir::Files | QDir::AllDirs | QDir::NoDotAndDotDot | QDir::Readable);
+            while (it.hasNext()) {
+                if (isCanceled()) {
+                    return;
+                }
+                it.next();
+                const QFileInfo fileInfo = it.fileInfo();
+
+                if (fileInfo.isDir()) {
+                    entry.subdirs.append(fileInfo.fileName());
+                    if (descend) {
+                        pushSubdir(index, fileInfo.absoluteFilePath(), task.depth + 1);
+                    }
+                    continue;
+                }
+
+                entry.files.append(fileInfo.fileName());
+                handleFile(fileInfo, &found);
+            }
+
+            if (m_index && modified.isValid()) {
+                // 無くなったサブフォルダの索引は、その下の階層もまとめて消す
+                if (hasCached) {
+                    for (const QString &name : cached.subdirs) {
+                        if (!entry.subdirs.contains(name)) {
+                            queue.removed.insert(DirectoryIndex::keyFor(task.path + '/' + name));
+                        }
+                    }
+                }
+                queue.visited.insert(key, entry);
+            }
+        }
+        m_scanned.ref();
+
+        if (!found.isEmpty()) {
+            QMutexLocker locker(&queue.resultMutex);
+            queue.found.append(found);
+        }
+    }
+};
+
+}
+
+DirectoryScanner::DirectoryScanner(int threadCount)
+    : m_threadCount(threadCount)
+    , m_canceled(nullptr)
+    , m_index(nullptr)
+    , m_directoriesScanned(0)
+    , m_directoriesReused(0)
+{
+    if (m_threadCount <= 0) {
+        // 待ち時間の大半はディスクI/Oなので、コア数より多めに並べる
+        m_threadCount = qBound(2, QThread::idealThreadCount() * 2, 16);
+    }
+}
+
+void DirectoryScanner::setNameFilters(const QStringList &nameFilters)
+{
+    m_nameFilters = nameFilters;
+}
+
+void DirectoryScanner::setDirectoryFilter(const DirectoryFilter &filter)
+{
+    m_directoryFilter = filter;
+}
+
+void DirectoryScanner::setFileHandler(const FileHandler &handler)
+{
+    m_fileHandler = handler;
+}
+
+void DirectoryScanner::setResultHandler(const ResultHandler &handler)
+{
+    m_resultHandler = handler;
+}
+
+void DirectoryScanner::setProgressHandler(const ProgressHandler &handler)
+{
+    m_progressHandler = handler;
+}
+
+void DirectoryScanner::setCancelFlag(const QAtomicInt *canceled)
+{
+    m_canceled = canceled;
+}
+
+void DirectoryScanner::setIndex(DirectoryIndex *index)
+{
+    m_index = index;
+}
+
+int DirectoryScanner::threadCount() const
+{
+    return m_threadCount;
+}
+
+int DirectoryScanner::directoriesScanned() const
+{
+    return m_directoriesScanned;
+}
+
+int DirectoryScanner::directoriesReused() const
+{
+    return m_directoriesReused;
+}
+
+bool DirectoryScanner::isCanceled() const
+{
+    return m_canceled && m_canceled->loadRelaxed();
+}
+
+void DirectoryScanner::scan(const QStringList &roots, int maxDepth)
+{
+    int foundCount = 0;
+    m_directoriesScanned = 0;
+    m_directoriesReused = 0;
+
+    if (m_index) {
+        m_index->setNameFilters(m_nameFilters);
+    }
+    ScanRun run(m_threadCount, maxDepth, m_nameFilters, m_directoryFilter, m_fileHandler, m_canceled, m_index);
+    run.seed(roots);
+
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < m_threadCount; ++i) {
+        threads.emplace_back(QThread::create([&run, i]() { run.runWorker(i); }));
+        threads.back()->setObjectName(QString("DirectoryScanner-%1").arg(i));
+        threads.back()->start();
+    }
+
+    // 呼び出し元のスレッドは回収と進捗通知だけを行う
+    QString currentPath;
+    for (;;) {
+        const bool finished = run.isFinished();
+        const QList<AppInfo> found = run.collect(&currentPath);
+        if (!found.isEmpty()) {
+            foundCount += found.size();
+            if (m_resultHandler) {
+                m_resultHandler(found);
+            }
+        }
+        if (m_progressHandler) {
+            m_progressHandler(run.scanned(), run.queued(), currentPath);
+        }
+        if (finished) {
+            break;
+        }
+        run.waitForProgress();
+    }
+
+    for (const std::unique_ptr<QThread> &thread : threads) {
+        thread->wait();
+    }
+
+    // 中断時は書き込み途中だった分も回収する
+    const QList<AppInfo> remaining = run.collect(nullptr);
+    if (!remaining.isEmpty()) {
+        foundCount += remaining.size();
+        if (m_resultHandler) {
+            m_resultHandler(remaining);
+        }
+    }
+    m_directoriesScanned = run.scanned();
+    m_directoriesReused = run.reused();
+
+    // 中断した場合も、最後まで処理したフォルダの内容は正しいので反映する
+    if (m_index) {
+        QHash<QString, DirectoryIndex::Entry> visited;
+        QSet<QString> removed;
+        run.collectIndex(&visited, &removed);
+        m_index->merge(visited, removed);
+    }
+
+    qDebug() << "Scanned" << m_directoriesScanned << "directories (" << m_directoriesReused
+             << "unchanged ) with" << m_threadCount
+             << "threads, found" << foundCount << "executables" << (isCanceled() ? "(canceled)" : "");
+}
@@ -0,0 +1,64 @@
+#ifndef DIRECTORYSCANNER_H
+#define DIRECTORYSCANNER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QFileInfo>
+#include <QAtomicInt>
+#include <functional>
+#include "appinfo.h"
+#include "directoryindex.h"
+
+// フォルダ1つを1タスクとして複数スレッドで辿るワークスティーリング方式のスキャナー
+//
+// 各ワーカーは自分のデックの末尾からタスクを取り（深さ優先で局所性を保つ）、空になったら
+// 他のワーカーのデックの先頭（根に近い大きな部分木）を盗む。ドライブごとのI/O待ちが重なるので
+// 複数のドライブを並行して辿れる。見つかったアプリはワーカーごとのバッファに溜め、
+// scan() を呼んだスレッドが一定間隔で回収して ResultHandler に渡す。
+// DirectoryFilter と FileHandler はワーカースレッドから同時に呼ばれる。
+// DirectoryIndex を渡すと、更新時刻が前回と同じフォルダは列挙せずに索引の内容を使い、
+// 列挙し直したフォルダの結果はスキャンの最後に索引へ反映する。
+class DirectoryScanner
+{
+public:
+    typedef std::function<bool(const QString &dirPath)> DirectoryFilter;            // true ならそのフォルダ以下を辿らない
+    typedef std::function<bool(const QFileInfo &fileInfo, AppInfo *app)> FileHandler; // true なら app を結果に加える
+    typedef std::function<void(const QList<AppInfo> &apps)> ResultHandler;
+    typedef std::function<void(int scanned, int queued, const QString &currentPath)> ProgressHandler;
+
+    explicit DirectoryScanner(int threadCount = 0);     // 0 は自動
+
+    void setNameFilters(const QStringList &nameFilters);     // 対象ファイル（フォルダには適用しない）
+    void setDirectoryFilter(const DirectoryFilter &filter);
+    void setFileHandler(const FileHandler &handler);
+    // 以下2つは scan() を呼んだスレッドで呼ばれる
+    void setResultHandler(const ResultHandler &handler);
+    void setProgressHandler(const ProgressHandler &handler);
+    void setCancelFlag(const QAtomicInt *canceled);
+    void setIndex(DirectoryIndex *index);
+
+    // roots 以下を maxDepth 階層まで辿る（roots 自身が1階層目）。終わるか中断されるまで戻らない
+    // 見つかったアプリは ResultHandler にだけ渡す（結果の一覧は作らない）
+    void scan(const QStringList &roots, int maxDepth);
+
+    int threadCount() const;
+    int directoriesScanned() const;
+    int directoriesReused() const;      // 索引の内容を使ったフォルダ数
+
+private:
+    int m_threadCount;
+    QStringList m_nameFilters;
+    DirectoryFilter m_directoryFilter;
+    FileHandler m_fileHandler;
+    ResultHandler m_resultHandler;
+    ProgressHandler m_progressHandler;
+    const QAtomicInt *m_canceled;
+    DirectoryIndex *m_index;
+    int m_directoriesScanned;
+    int m_directoriesReused;
+
+    bool isCanceled() const;
+};
+
+#endif // DIRECTORYSCANNER_H
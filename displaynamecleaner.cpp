@@ -0,0 +1,125 @@
+#include "displaynamecleaner.h"
+#include <QHash>
+#include <QLatin1String>
+
+namespace {
+
+// 大文字小文字を区別しないハッシュ（単語ごとに文字列を作らずに引けるようにする）
+quint32 foldedHash(QStringView text)
+{
+    quint32 hash = 2166136261u;
+    for (const QChar c : text) {
+        hash = (hash ^ c.toLower().unicode()) * 16777619u;
+    }
+    return hash;
+}
+
+// 表示名から落とす単語（ハッシュ → 単語）
+const QMultiHash<quint32, QLatin1String> &stopWords()
+{
+    static const QMultiHash<quint32, QLatin1String> words = [] {
+        const QLatin1String list[] = {
+            QLatin1String("launcher"), QLatin1String("game"), QLatin1String("client"),
+            QLatin1String("setup"), QLatin1String("install"),
+            QLatin1String("x64"), QLatin1String("x86"), QLatin1String("win32"), QLatin1String("win64"),
+            QLatin1String("32bit"), QLatin1String("64bit")
+        };
+        QMultiHash<quint32, QLatin1String> hash;
+        for (const QLatin1String &word : list) {
+            hash.insert(foldedHash(QString(word)), word);
+        }
+        return hash;
+    }();
+    return words;
+}
+
+bool isWordChar(QChar c)
+{
+    return c.isLetterOrNumber();
+}
+
+// CamelCase の境目: "myApp" の a|A、"Win64Setup" の 4|S、"XMLParser" の L|P
+bool startsWord(QStringView text, int i)
+{
+    const QChar c = text.at(i);
+    if (!c.isUpper()) {
+        return false;
+    }
+    const QChar prev = text.at(i - 1);
+    if (prev.isLower() || prev.isDigit()) {
+        return true;
+    }
+    return prev.isUpper() && i + 1 < text.size() && text.at(i + 1).isLower();
+}
+
+// start から始まる単語の終わり
+int wordEnd(QStringView text, int start)
+{
+    int end = start + 1;
+    while (end < text.size() && isWordChar(text.at(end)) && !startsWord(text, end)) {
+        ++end;
+    }
+    return end;
+}
+
+}
+
+QString DisplayNameCleaner::clean(const QString &baseName)
+{
+    const QStringView text(baseName);
+    QString cleanName;
+    cleanName.reserve(baseName.size());
+
+    int lastKeptEnd = -1;       // 最後に残した単語の終わり
+    bool droppedSince = false;  // その後に落とした単語があるか
+    int i = 0;
+    while (i < text.size()) {
+        if (!isWordChar(text.at(i))) {
+            ++i;
+            continue;
+        }
+        int end = wordEnd(text, i);
+        // 数字の後の大文字で切れた "64Bit" などは、つなげると除外語になるなら1語として扱う
+        if (end < text.size() && isWordChar(text.at(end)) && text.at(end - 1).isDigit()) {
+            const int joinedEnd = wordEnd(text, end);
+            if (isStopWord(text.mid(i, joinedEnd - i))) {
+                end = joinedEnd;
+            }
+        }
+
+        const QStringView token = text.mid(i, end - i);
+        if (isStopWord(token)) {
+            droppedSince = true;
+        } else {
+            if (lastKeptEnd >= 0) {
+                if (droppedSince) {
+                    cleanName.append(QLatin1Char(' '));
+                } else {
+                    cleanName.append(text.mid(lastKeptEnd, i - lastKeptEnd));
+                }
+            }
+            cleanName.append(token);
+            lastKeptEnd = end;
+            droppedSince = false;
+        }
+        i = end;
+    }
+
+    if (cleanName.isEmpty()) {
+        return baseName;
+    }
+    cleanName[0] = cleanName.at(0).toUpper();
+    return cleanName;
+}
+
+bool DisplayNameCleaner::isStopWord(QStringView token)
+{
+    const QMultiHash<quint32, QLatin1String> &words = stopWords();
+    const quint32 hash = foldedHash(token);
+    for (auto it = words.constFind(hash); it != words.constEnd() && it.key() == hash; ++it) {
+        if (token.compare(it.value(), Qt::CaseInsensitive) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
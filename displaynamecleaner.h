@@ -0,0 +1,22 @@
+#ifndef DISPLAYNAMECLEANER_H
+#define DISPLAYNAMECLEANER_H
+
+#include <QString>
+#include <QStringView>
+
+// 実行ファイル名から表示名を作る
+//
+// 名前を1回走査して単語に分け（英数字以外の文字と CamelCase の境目で区切る。数字は前の単語に続ける）、
+// "launcher" "x64" などの不要な単語を落として残りをつなぎ直す。単語どうしの間は元の区切りを残し、
+// 落とした単語があった所は空白1つにする。先頭の文字は大文字にし、すべて落ちた場合は元の名前を返す。
+// 新しい文字列の確保は結果の1回だけで、複数スレッドから同時に使える。
+class DisplayNameCleaner
+{
+public:
+    static QString clean(const QString &baseName);
+
+private:
+    static bool isStopWord(QStringView token);
+};
+
+#endif // DISPLAYNAMECLEANER_H
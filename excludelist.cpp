@@ -0,0 +1,155 @@
+#include "excludelist.h"
+#include "filelock.h"
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDebug>
+
+namespace {
+
+// 重複行がこれだけ溜まったら書き直す
+const int CompactionSlack = 256;
+
+}
+
+QString ExcludeList::defaultFilePath()
+{
+    return QDir(QApplication::applicationDirPath()).filePath("exclude_list.txt");
+}
+
+ExcludeList::ExcludeList(const QString &filePath)
+    : m_filePath(filePath)
+    , m_readOffset(0)
+    , m_lineCount(0)
+{
+}
+
+bool ExcludeList::load()
+{
+    m_trie.clear();
+    m_readOffset = 0;
+    m_lineCount = 0;
+    return readNewLines();
+}
+
+int ExcludeList::add(const QStringList &paths)
+{
+    FileLock lock(m_filePath);
+    if (!lock.isLocked()) {
+        return -1;
+    }
+
+    // 他のプロセスが追記した分を先に取り込む
+    readNewLines();
+
+    QStringList added;
+    for (const QString &path : paths) {
+        const QString normalized = PathTrie::normalize(path);
+        if (!normalized.isEmpty() && !m_trie.contains(normalized)) {
+            m_trie.insert(normalized);
+            added.append(normalized);
+        }
+    }
+    if (added.isEmpty()) {
+        return 0;
+    }
+
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qWarning() << "Cannot open exclude list file for appending:" << m_filePath;
+        return -1;
+    }
+    // 前の書き手が改行で終えていない場合に備える
+    if (file.size() > 0) {
+        QFile tail(m_filePath);
+        if (tail.open(QIODevice::ReadOnly) && tail.seek(tail.size() - 1) && tail.read(1) != "\n") {
+            file.write("\n");
+        }
+    }
+    file.write((added.join('\n') + '\n').toUtf8());
+    file.close();
+    if (file.error() != QFileDevice::NoError) {
+        qWarning() << "Failed to append to exclude list:" << m_filePath << file.errorString();
+        return -1;
+    }
+
+    m_lineCount += added.size();
+    m_readOffset = QFileInfo(m_filePath).size();
+    if (m_lineCount > m_trie.size() + CompactionSlack) {
+        compact();
+    }
+
+    qDebug() << "Appended" << added.size() << "paths to exclude list";
+    return added.size();
+}
+
+bool ExcludeList::isExcluded(const QString &path) const
+{
+    return m_trie.coversPath(path);
+}
+
+bool ExcludeList::contains(const QString &path) const
+{
+    return m_trie.contains(path);
+}
+
+QStringList ExcludeList::paths() const
+{
+    return m_trie.paths();
+}
+
+int ExcludeList::size() const
+{
+    return m_trie.size();
+}
+
+bool ExcludeList::readNewLines()
+{
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // 前回より短い場合は書き直されているので最初から読み直す
+    if (file.size() < m_readOffset) {
+        m_trie.clear();
+        m_readOffset = 0;
+        m_lineCount = 0;
+    }
+    if (!file.seek(m_readOffset)) {
+        return false;
+    }
+
+    // 追記はロックを持ったまま1回の書き込みで行われるので、最後の行も完全なものとして読む
+    // （手で編集して改行で終わっていない場合は、次の追記の前に改行を補う）
+    while (!file.atEnd()) {
+        const QString path = QString::fromUtf8(file.readLine()).trimmed();
+        if (!path.isEmpty()) {
+            m_trie.insert(path);
+            ++m_lineCount;
+        }
+    }
+    m_readOffset = file.pos();
+    return true;
+}
+
+bool ExcludeList::compact()
+{
+    // 呼び出し元がロックを持っている
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    const QStringList paths = m_trie.paths();
+    file.write(paths.isEmpty() ? QByteArray() : (paths.join('\n') + '\n').toUtf8());
+    if (!file.commit()) {
+        qWarning() << "Failed to compact exclude list:" << m_filePath << file.errorString();
+        return false;
+    }
+
+    m_lineCount = paths.size();
+    m_readOffset = QFileInfo(m_filePath).size();
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef EXCLUDELIST_H
+#define EXCLUDELIST_H
+
+#include <QString>
+#include <QStringList>
+#include "pathtrie.h"
+
+// exclude_list.txt（除外するアプリ・フォルダのパス）
+//
+// 1行1パスの追記専用ファイルとして扱う。追加は末尾への追記だけで、ファイル全体は書き直さない。
+// 追記の前には前回読んだ位置以降（他のランチャーが追記した分）を読み込むので、
+// 複数のプロセスが追加しても互いの内容は失われない。重複行は読み込み時に無視し、
+// 重複が増えすぎたときだけ書き直して詰める。
+// 登録したフォルダの下にあるものはすべて除外される。
+class ExcludeList
+{
+public:
+    static QString defaultFilePath();
+
+    explicit ExcludeList(const QString &filePath = defaultFilePath());
+
+    bool load();
+    int add(const QStringList &paths);      // 新たに加えた数（失敗時は -1）
+
+    bool isExcluded(const QString &path) const;     // パス自身か上位フォルダが登録されている
+    bool contains(const QString &path) const;
+    QStringList paths() const;
+    int size() const;
+
+private:
+    QString m_filePath;
+    PathTrie m_trie;
+    qint64 m_readOffset;        // ここまで読み込み済み
+    int m_lineCount;            // 読み込んだ行数（重複を含む）
+
+    bool readNewLines();
+    bool compact();
+};
+
+#endif // EXCLUDELIST_H
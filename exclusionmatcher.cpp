@@ -0,0 +1,302 @@
+#include "exclusionmatcher.h"
+#include <QVarLengthArray>
+#include <algorithm>
+
+namespace {
+
+// wildcardToRegularExpression と同じく、Windowsでは \ もパス区切りとして扱う
+bool isSeparator(QChar c)
+{
+#ifdef Q_OS_WIN
+    return c == QLatin1Char('/') || c == QLatin1Char('\\');
+#else
+    return c == QLatin1Char('/');
+#endif
+}
+
+}
+
+ExclusionMatcher::ExclusionMatcher()
+{
+}
+
+ExclusionMatcher::ExclusionMatcher(const QStringList &patterns)
+{
+    setPatterns(patterns);
+}
+
+void ExclusionMatcher::setPatterns(const QStringList &patterns)
+{
+    m_patterns.clear();
+    m_compiled.clear();
+    m_keywords.clear();
+
+    for (const QString &pattern : patterns) {
+        const QString trimmed = pattern.trimmed().toLower();
+        if (!trimmed.isEmpty()) {
+            m_patterns.append(trimmed);
+            compile(trimmed);
+        }
+    }
+    m_keywords.build();
+}
+
+QStringList ExclusionMatcher::patterns() const
+{
+    return m_patterns;
+}
+
+bool ExclusionMatcher::isEmpty() const
+{
+    return m_patterns.isEmpty();
+}
+
+bool ExclusionMatcher::matches(const QString &text) const
+{
+    return indexIn(text) >= 0;
+}
+
+int ExclusionMatcher::indexIn(const QString &text) const
+{
+    if (m_compiled.isEmpty()) {
+        return -1;
+    }
+
+    const QString lower = text.toLower();
+
+    // 1回の走査でキーワードの出現とパス区切りの有無を調べる
+    QVarLengthArray<bool, 64> found(m_keywords.keywordCount());
+    std::fill(found.begin(), found.end(), false);
+    bool hasSeparator = false;
+    int state = 0;
+    for (const QChar c : lower) {
+        if (isSeparator(c)) {
+            hasSeparator = true;
+        }
+        state = m_keywords.step(state, c);
+        for (int keyword : m_keywords.keywordsAt(state)) {
+            found[keyword] = true;
+        }
+    }
+
+    for (int i = 0; i < m_compiled.size(); ++i) {
+        const Pattern &pattern = m_compiled.at(i);
+        switch (pattern.kind) {
+        case KindExact:
+            if (lower == pattern.literal) {
+                return i;
+            }
+            break;
+        case KindContains:
+            // 前後の * はパス区切りを越えられない
+            if (found[pattern.keyword] && !hasSeparator) {
+                return i;
+            }
+            break;
+        case KindGlob:
+            if ((pattern.keyword < 0 || found[pattern.keyword]) && matchGlob(pattern, lower)) {
+                return i;
+            }
+            break;
+        }
+    }
+    return -1;
+}
+
+QStringList ExclusionMatcher::parsePatterns(const QString &text)
+{
+    QStringList patterns;
+    const QStringList lines = text.split('\n', Qt::SkipEmptyParts);
+    for (const QString &line : lines) {
+        const QString pattern = line.trimmed();
+        if (!pattern.isEmpty()) {
+            patterns.append(pattern);
+        }
+    }
+    return patterns;
+}
+
+void ExclusionMatcher::compile(const QString &pattern)
+{
+    const QList<Token> tokens = tokenize(pattern);
+
+    Pattern compiled;
+    compiled.kind = KindGlob;
+    compiled.keyword = -1;
+
+    // 最も長いリテラルの並びをキーワードにする
+    QString longest;
+    QString current;
+    bool allLiteral = true;
+    for (const Token &token : tokens) {
+        if (token.type == Token::Literal) {
+            current.append(token.ch);
+            continue;
+        }
+        allLiteral = false;
+        if (current.size() > longest.size()) {
+            longest = current;
+        }
+        current.clear();
+    }
+    if (current.size() > longest.size()) {
+        longest = current;
+    }
+
+    if (allLiteral) {
+        compiled.kind = KindExact;
+        compiled.literal = longest;
+        m_compiled.append(compiled);
+        return;
+    }
+
+    if (!longest.isEmpty()) {
+        compiled.keyword = m_keywords.addKeyword(longest);
+    }
+
+    // *リテラル* はキーワードの出現だけで判定できる
+    if (tokens.size() >= 3 && tokens.first().type == Token::AnyString && tokens.last().type == Token::AnyString
+        && longest.size() == tokens.size() - 2) {
+        bool crossesSeparator = false;
+        for (const QChar c : longest) {
+            crossesSeparator = crossesSeparator || isSeparator(c);
+        }
+        if (!crossesSeparator) {
+            compiled.kind = KindContains;
+            m_compiled.append(compiled);
+            return;
+        }
+    }
+
+    // パス区切りで分けて、区切りごとに照合する（* と ? は区切りを越えないため）
+    QList<Token> segment;
+    for (const Token &token : tokens) {
+        if (token.type == Token::Literal && isSeparator(token.ch)) {
+            compiled.segments.append(segment);
+            segment.clear();
+        } else {
+            segment.append(token);
+        }
+    }
+    compiled.segments.append(segment);
+    m_compiled.append(compiled);
+}
+
+QList<ExclusionMatcher::Token> ExclusionMatcher::tokenize(const QString &pattern)
+{
+    QList<Token> tokens;
+    for (int i = 0; i < pattern.size(); ++i) {
+        const QChar c = pattern.at(i);
+        Token token;
+        token.negated = false;
+
+        if (c == QLatin1Char('*')) {
+            // 連続した * は1つと同じ
+            if (!tokens.isEmpty() && tokens.last().type == Token::AnyString) {
+                continue;
+            }
+            token.type = Token::AnyString;
+        } else if (c == QLatin1Char('?')) {
+            token.type = Token::AnyChar;
+        } else if (c == QLatin1Char('[')) {
+            // 先頭の ] は文字クラスの要素として扱う
+            int start = i + 1;
+            bool negated = false;
+            if (start < pattern.size() && (pattern.at(start) == QLatin1Char('!') || pattern.at(start) == QLatin1Char('^'))) {
+                negated = true;
+                ++start;
+            }
+            const int close = pattern.indexOf(QLatin1Char(']'), start < pattern.size() ? start + 1 : start);
+            if (close < 0) {
+                token.type = Token::Literal;
+                token.ch = c;
+            } else {
+                token.type = Token::CharClass;
+                token.chars = pattern.mid(start, close - start);
+                token.negated = negated;
+                i = close;
+            }
+        } else {
+            token.type = Token::Literal;
+            token.ch = c;
+        }
+        tokens.append(token);
+    }
+    return tokens;
+}
+
+bool ExclusionMatcher::matchToken(const Token &token, QChar c)
+{
+    switch (token.type) {
+    case Token::Literal:
+        return token.ch == c;
+    case Token::AnyChar:
+        return !isSeparator(c);
+    case Token::AnyString:
+        return true;
+    case Token::CharClass: {
+        if (isSeparator(c)) {
+            return false;
+        }
+        bool inClass = false;
+        const QString &chars = token.chars;
+        for (int i = 0; i < chars.size() && !inClass; ++i) {
+            if (i + 2 < chars.size() && chars.at(i + 1) == QLatin1Char('-')) {
+                inClass = chars.at(i) <= c && c <= chars.at(i + 2);
+                i += 2;
+            } else {
+                inClass = chars.at(i) == c;
+            }
+        }
+        return inClass != token.negated;
+    }
+    }
+    return false;
+}
+
+bool ExclusionMatcher::matchSegment(const QList<Token> &tokens, QStringView text)
+{
+    // 最後の * の位置に戻ってやり直す貪欲法（区切りを含まない範囲なので * は何にでも一致する）
+    int p = 0;
+    int t = 0;
+    int star = -1;
+    int mark = 0;
+    const int count = tokens.size();
+    while (t < text.size()) {
+        if (p < count && tokens.at(p).type == Token::AnyString) {
+            star = p++;
+            mark = t;
+        } else if (p < count && matchToken(tokens.at(p), text.at(t))) {
+            ++p;
+            ++t;
+        } else if (star >= 0) {
+            p = star + 1;
+            t = ++mark;
+        } else {
+            return false;
+        }
+    }
+    while (p < count && tokens.at(p).type == Token::AnyString) {
+        ++p;
+    }
+    return p == count;
+}
+
+bool ExclusionMatcher::matchGlob(const Pattern &pattern, const QString &text)
+{
+    const QStringView view(text);
+    int segment = 0;
+    int start = 0;
+    for (int i = 0; i <= view.size(); ++i) {
+        if (i < view.size() && !isSeparator(view.at(i))) {
+            continue;
+        }
+        if (segment >= pattern.segments.size()
+            || !matchSegment(pattern.segments.at(segment), view.mid(start, i - start))) {
+            return false;
+        }
+        ++segment;
+        start = i + 1;
+    }
+    return segment == pattern.segments.size();
+}
@@ -0,0 +1,68 @@
+#ifndef EXCLUSIONMATCHER_H
+#define EXCLUSIONMATCHER_H
+
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QList>
+#include <QHash>
+#include "keywordautomaton.h"
+
+// 除外パターン（ワイルドカード）をまとめてコンパイルした照合器
+//
+// QRegularExpression::wildcardToRegularExpression と同じ規則で照合する:
+// 全体一致、* と ? はパス区切りを越えない、[abc] [!abc] [a-z] の文字クラス。大文字小文字は区別しない。
+// 各パターンから最も長いリテラル部分をキーワードとして取り出し、全キーワードを1つの
+// Aho-Corasick オートマトンにまとめる。照合は文字列を1回走査してキーワードの出現を調べ、
+// "*リテラル*" 形式はそれだけで判定し、残りはキーワードが現れたパターンだけをワイルドカード照合する。
+// コンパイル後は読み取り専用なので、複数スレッドから同時に使える。
+class ExclusionMatcher
+{
+public:
+    ExclusionMatcher();
+    explicit ExclusionMatcher(const QStringList &patterns);
+
+    void setPatterns(const QStringList &patterns);
+    QStringList patterns() const;
+    bool isEmpty() const;
+
+    bool matches(const QString &text) const;
+    int indexIn(const QString &text) const;     // 一致した最初のパターンの番号（無ければ -1）
+
+    // 1行1パターンのテキスト（テキストエリア・exclude_patterns.txt）を分割する
+    static QStringList parsePatterns(const QString &text);
+
+private:
+    struct Token {
+        enum Type { Literal, AnyChar, AnyString, CharClass };
+        Type type;
+        QChar ch;               // Literal
+        QString chars;          // CharClass の中身（a-z は3文字のまま持つ）
+        bool negated;
+    };
+
+    enum Kind {
+        KindExact,              // ワイルドカードを含まない
+        KindContains,           // *リテラル*（リテラルにパス区切りを含まない）
+        KindGlob                // その他
+    };
+
+    struct Pattern {
+        Kind kind;
+        QString literal;        // KindExact の比較対象
+        int keyword;            // m_keywords 内の番号（無ければ -1）
+        QList<QList<Token>> segments;   // パス区切りで分けたトークン列（KindGlob）
+    };
+
+    QStringList m_patterns;
+    QList<Pattern> m_compiled;
+    KeywordAutomaton m_keywords;
+
+    void compile(const QString &pattern);
+    static QList<Token> tokenize(const QString &pattern);
+    static bool matchToken(const Token &token, QChar c);
+    static bool matchSegment(const QList<Token> &tokens, QStringView text);
+    static bool matchGlob(const Pattern &pattern, const QString &text);
+};
+
+#endif // EXCLUSIONMATCHER_H
@@ -0,0 +1,43 @@
+#include "fileidentity.h"
+#include <QFile>
+#include <QDir>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+bool FileIdentity::of(const QString &path, FileIdentity *identity)
+{
+#ifdef Q_OS_WIN
+    // 属性を読むだけなのでアクセス権は要求しない（フォルダも開けるように BACKUP_SEMANTICS を付ける）
+    const QString nativePath = QDir::toNativeSeparators(path);
+    HANDLE handle = CreateFileW(reinterpret_cast<const wchar_t *>(nativePath.utf16()), 0,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    BY_HANDLE_FILE_INFORMATION info;
+    const bool ok = GetFileInformationByHandle(handle, &info) != 0;
+    CloseHandle(handle);
+    if (!ok) {
+        return false;
+    }
+
+    identity->device = info.dwVolumeSerialNumber;
+    identity->inode = (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    return true;
+#else
+    struct stat status;
+    if (::stat(QFile::encodeName(path).constData(), &status) != 0) {
+        return false;
+    }
+
+    identity->device = quint64(status.st_dev);
+    identity->inode = quint64(status.st_ino);
+    return true;
+#endif
+}
@@ -0,0 +1,33 @@
+#ifndef FILEIDENTITY_H
+#define FILEIDENTITY_H
+
+#include <QString>
+#include <QHashFunctions>
+
+// ファイルの実体を表す (デバイス, inode) の組
+// シンボリックリンクは辿った先、ハードリンクは同じ実体になるので、別のパスでも同じ値になる。
+// Windowsではボリュームのシリアル番号とファイルインデックスを使う。
+struct FileIdentity
+{
+    quint64 device = 0;
+    quint64 inode = 0;
+
+    static bool of(const QString &path, FileIdentity *identity);
+};
+
+inline bool operator==(const FileIdentity &a, const FileIdentity &b)
+{
+    return a.device == b.device && a.inode == b.inode;
+}
+
+inline bool operator!=(const FileIdentity &a, const FileIdentity &b)
+{
+    return !(a == b);
+}
+
+inline size_t qHash(const FileIdentity &identity, size_t seed = 0)
+{
+    return qHashMulti(seed, identity.device, identity.inode);
+}
+
+#endif // FILEIDENTITY_H
@@ -0,0 +1,37 @@
+#include "filelock.h"
+#include <QDebug>
+
+namespace {
+
+// 保持しているプロセスが無いままこれより古いロックファイルは残骸とみなす
+const int StaleLockTime = 30000;
+
+}
+
+FileLock::FileLock(const QString &filePath, int timeoutMs)
+    : m_lockFile(lockPathFor(filePath))
+    , m_locked(false)
+{
+    m_lockFile.setStaleLockTime(StaleLockTime);
+    m_locked = m_lockFile.tryLock(timeoutMs);
+    if (!m_locked) {
+        qWarning() << "Could not lock" << filePath << "- error" << m_lockFile.error();
+    }
+}
+
+FileLock::~FileLock()
+{
+    if (m_locked) {
+        m_lockFile.unlock();
+    }
+}
+
+bool FileLock::isLocked() const
+{
+    return m_locked;
+}
+
+QString FileLock::lockPathFor(const QString &filePath)
+{
+    return filePath + ".lock";
+}
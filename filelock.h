@@ -0,0 +1,30 @@
+#ifndef FILELOCK_H
+#define FILELOCK_H
+
+#include <QString>
+#include <QLockFile>
+
+// 複数のランチャーや外部スクリプトとの間でファイルの書き換えを直列化する助言的ロック
+// 対象ファイルと同じ場所に <ファイル名>.lock を作る。ロックを守らない書き手は防げないが、
+// 読み直し→変更→書き込みの間に他の書き手が割り込んで書き込みが失われることは防げる。
+// 異常終了したプロセスのロックは一定時間で古いものとして取り除かれる。
+class FileLock
+{
+public:
+    explicit FileLock(const QString &filePath, int timeoutMs = DefaultTimeout);
+    ~FileLock();
+
+    bool isLocked() const;
+
+    static QString lockPathFor(const QString &filePath);
+
+    static const int DefaultTimeout = 5000;
+
+private:
+    Q_DISABLE_COPY(FileLock)
+
+    QLockFile m_lockFile;
+    bool m_locked;
+};
+
+#endif // FILELOCK_H
@@ -0,0 +1,288 @@
+#include "frecencyindex.h"
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// 得点が半分になるまでの日数
+const double HalfLifeDays = 14.0;
+const double DecayPerDay = std::log(2.0) / HalfLifeDays;
+const double MSecsPerDay = 24.0 * 60.0 * 60.0 * 1000.0;
+const double NeverLaunched = -std::numeric_limits<double>::infinity();
+
+double launchDays(const QDateTime &dateTime)
+{
+    return double(dateTime.toMSecsSinceEpoch()) / MSecsPerDay;
+}
+
+qint64 dateToMSecs(const QDateTime &dateTime)
+{
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : AppStore::InvalidMSecs;
+}
+
+}
+
+FrecencyIndex::FrecencyIndex()
+{
+}
+
+void FrecencyIndex::clear()
+{
+    m_frecency.clear();
+    m_frecencyKeys.clear();
+    m_launchCount.clear();
+    m_lastLaunch.clear();
+}
+
+void FrecencyIndex::rebuild(const AppStore &store)
+{
+    clear();
+    m_launchCount.reserve(store.size());
+    m_lastLaunch.reserve(store.size());
+    for (int row = 0; row < store.size(); ++row) {
+        insert(store.id(row), store.launchCount(row), store.lastLaunchMSecs(row));
+    }
+}
+
+void FrecencyIndex::addApp(const AppInfo &app)
+{
+    insert(app.id, app.launchCount, dateToMSecs(app.lastLaunch));
+}
+
+void FrecencyIndex::updateApp(const QString &appId, const AppInfo &app)
+{
+    // IDが変わった場合は古いIDのエントリを外す
+    if (appId != app.id) {
+        removeApp(appId);
+    }
+    insert(app.id, app.launchCount, dateToMSecs(app.lastLaunch));
+}
+
+void FrecencyIndex::removeApp(const QString &appId)
+{
+    removeFrecencyKey(appId);
+    m_launchCount.remove(appId);
+    m_lastLaunch.remove(appId);
+}
+
+QStringList FrecencyIndex::frecentIds() const
+{
+    QStringList ids;
+    ids.reserve(int(m_frecency.size()));
+    for (const FrecencyEntry &entry : m_frecency) {
+        ids.append(entry.appId);
+    }
+    return ids;
+}
+
+QString FrecencyIndex::mostLaunched() const
+{
+    if (m_launchCount.isEmpty() || m_launchCount.topKey() <= 0) {
+        return QString();
+    }
+    return m_launchCount.topId();
+}
+
+QString FrecencyIndex::mostRecent() const
+{
+    if (m_lastLaunch.isEmpty() || m_lastLaunch.topKey() == NeverLaunched) {
+        return QString();
+    }
+    return m_lastLaunch.topId();
+}
+
+int FrecencyIndex::size() const
+{
+    return m_launchCount.size();
+}
+
+double FrecencyIndex::frecencyKey(const AppInfo &app)
+{
+    return frecencyKey(app.launchCount, dateToMSecs(app.lastLaunch));
+}
+
+double FrecencyIndex::frecencyKey(int launchCount, qint64 lastLaunchMSecs)
+{
+    if (launchCount <= 0 || lastLaunchMSecs == AppStore::InvalidMSecs) {
+        return NeverLaunched;
+    }
+    // ln(launchCount * exp(-λ(t - last))) + λt = ln(launchCount) + λ last
+    return std::log(double(launchCount)) + DecayPerDay * (double(lastLaunchMSecs) / MSecsPerDay);
+}
+
+double FrecencyIndex::frecencyScore(const AppInfo &app, const QDateTime &now)
+{
+    const double key = frecencyKey(app);
+    if (key == NeverLaunched) {
+        return 0.0;
+    }
+    return std::exp(key - DecayPerDay * launchDays(now));
+}
+
+void FrecencyIndex::insert(const QString &appId, int launchCount, qint64 lastLaunchMSecs)
+{
+    setFrecencyKey(appId, frecencyKey(launchCount, lastLaunchMSecs));
+    m_launchCount.set(appId, launchCount);
+    m_lastLaunch.set(appId, lastLaunchMSecs == AppStore::InvalidMSecs ? NeverLaunched : double(lastLaunchMSecs));
+}
+
+void FrecencyIndex::setFrecencyKey(const QString &appId, double key)
+{
+    auto it = m_frecencyKeys.find(appId);
+    if (it != m_frecencyKeys.end()) {
+        if (it.value() == key) {
+            return;
+        }
+        m_frecency.erase(FrecencyEntry{it.value(), appId});
+    }
+
+    // 未起動のアプリは集合に入れない（列挙時にカタログ順で後ろへ並べる）
+    if (key == NeverLaunched) {
+        if (it != m_frecencyKeys.end()) {
+            m_frecencyKeys.erase(it);
+        }
+        return;
+    }
+    m_frecency.insert(FrecencyEntry{key, appId});
+    m_frecencyKeys.insert(appId, key);
+}
+
+void FrecencyIndex::removeFrecencyKey(const QString &appId)
+{
+    auto it = m_frecencyKeys.find(appId);
+    if (it == m_frecencyKeys.end()) {
+        return;
+    }
+    m_frecency.erase(FrecencyEntry{it.value(), appId});
+    m_frecencyKeys.erase(it);
+}
+
+bool FrecencyIndex::FrecencyEntry::operator<(const FrecencyEntry &other) const
+{
+    if (key != other.key) {
+        return key > other.key;
+    }
+    return appId < other.appId;
+}
+
+// ---- IndexedMaxHeap ----
+
+void FrecencyIndex::IndexedMaxHeap::clear()
+{
+    m_entries.clear();
+    m_positions.clear();
+}
+
+void FrecencyIndex::IndexedMaxHeap::reserve(int size)
+{
+    m_entries.reserve(size);
+    m_positions.reserve(size);
+}
+
+void FrecencyIndex::IndexedMaxHeap::set(const QString &appId, double key)
+{
+    const int pos = m_positions.value(appId, -1);
+    if (pos < 0) {
+        m_entries.append(Entry{appId, key});
+        m_positions.insert(appId, m_entries.size() - 1);
+        siftUp(m_entries.size() - 1);
+        return;
+    }
+
+    const double oldKey = m_entries[pos].key;
+    m_entries[pos].key = key;
+    if (key > oldKey) {
+        siftUp(pos);
+    } else if (key < oldKey) {
+        siftDown(pos);
+    }
+}
+
+void FrecencyIndex::IndexedMaxHeap::remove(const QString &appId)
+{
+    const int pos = m_positions.value(appId, -1);
+    if (pos < 0) {
+        return;
+    }
+
+    m_positions.remove(appId);
+    const Entry last = m_entries.takeLast();
+    if (pos == m_entries.size()) {
+        return;
+    }
+
+    // 末尾の要素を空いた位置に移し、上下どちらかに沈め直す
+    place(pos, last);
+    siftUp(pos);
+    siftDown(m_positions.value(last.appId));
+}
+
+bool FrecencyIndex::IndexedMaxHeap::isEmpty() const
+{
+    return m_entries.isEmpty();
+}
+
+QString FrecencyIndex::IndexedMaxHeap::topId() const
+{
+    return m_entries.first().appId;
+}
+
+double FrecencyIndex::IndexedMaxHeap::topKey() const
+{
+    return m_entries.first().key;
+}
+
+int FrecencyIndex::IndexedMaxHeap::size() const
+{
+    return m_entries.size();
+}
+
+bool FrecencyIndex::IndexedMaxHeap::higher(const Entry &a, const Entry &b)
+{
+    // 同じキーはアプリIDで順序を決め、先頭が呼び出しごとに揺れないようにする
+    if (a.key != b.key) {
+        return a.key > b.key;
+    }
+    return a.appId < b.appId;
+}
+
+void FrecencyIndex::IndexedMaxHeap::place(int pos, const Entry &entry)
+{
+    m_entries[pos] = entry;
+    m_positions[entry.appId] = pos;
+}
+
+void FrecencyIndex::IndexedMaxHeap::siftUp(int pos)
+{
+    const Entry entry = m_entries.at(pos);
+    while (pos > 0) {
+        const int parent = (pos - 1) / 2;
+        if (!higher(entry, m_entries.at(parent))) {
+            break;
+        }
+        place(pos, m_entries.at(parent));
+        pos = parent;
+    }
+    place(pos, entry);
+}
+
+void FrecencyIndex::IndexedMaxHeap::siftDown(int pos)
+{
+    const int count = m_entries.size();
+    const Entry entry = m_entries.at(pos);
+    while (true) {
+        int child = pos * 2 + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && higher(m_entries.at(child + 1), m_entries.at(child))) {
+            ++child;
+        }
+        if (!higher(m_entries.at(child), entry)) {
+            break;
+        }
+        place(pos, m_entries.at(child));
+        pos = child;
+    }
+    place(pos, entry);
+}
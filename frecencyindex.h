@@ -0,0 +1,95 @@
+#ifndef FRECENCYINDEX_H
+#define FRECENCYINDEX_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include <QDateTime>
+#include <QStringList>
+#include <set>
+#include "appinfo.h"
+#include "appstore.h"
+
+// 起動回数と最終起動時刻から求める「よく使う順」（frecency）の索引
+//
+// 時刻 t での得点は launchCount * exp(-λ (t - lastLaunch)) とし、半減期ごとに半分になる。
+// 大小関係は t によらないので、ln(launchCount) + λ lastLaunch をキーとして保持すれば
+// 時間の経過で並べ直す必要はなく、起動時にその1件のキーを差し替えるだけで済む。
+// 起動済みのアプリはキーの順序付き集合で持ち、よく使う順の列挙は並べ替えなしで行える。
+// 回数・最終起動時刻の最大値は添字付き二分ヒープで持ち、先頭の参照はO(1)。
+class FrecencyIndex
+{
+public:
+    FrecencyIndex();
+
+    void clear();
+    void rebuild(const AppStore &store);
+
+    // 差分更新（起動記録も updateApp で反映する）
+    void addApp(const AppInfo &app);
+    void updateApp(const QString &appId, const AppInfo &app);
+    void removeApp(const QString &appId);
+
+    // 起動済みのアプリIDをよく使う順に列挙する（未起動のアプリは含まない）
+    QStringList frecentIds() const;
+
+    // 先頭の参照（該当なしは空文字列）
+    QString mostLaunched() const;   // 起動回数が最大（1回以上）
+    QString mostRecent() const;     // 最終起動が最も新しい
+
+    int size() const;
+
+    // 並べ替え用のキー（大きいほど上位。一度も起動していなければ最小値）
+    static double frecencyKey(const AppInfo &app);
+    static double frecencyKey(int launchCount, qint64 lastLaunchMSecs);
+    // 時刻 now における得点
+    static double frecencyScore(const AppInfo &app, const QDateTime &now);
+
+private:
+    // 添字付き最大ヒープ（アプリID → ヒープ内の位置を保持して任意要素のキー変更をO(log n)で行う）
+    class IndexedMaxHeap
+    {
+    public:
+        void clear();
+        void reserve(int size);
+        void set(const QString &appId, double key);
+        void remove(const QString &appId);
+        bool isEmpty() const;
+        QString topId() const;
+        double topKey() const;
+        int size() const;
+
+    private:
+        struct Entry {
+            QString appId;
+            double key;
+        };
+
+        QVector<Entry> m_entries;
+        QHash<QString, int> m_positions;
+
+        static bool higher(const Entry &a, const Entry &b);
+        void place(int pos, const Entry &entry);
+        void siftUp(int pos);
+        void siftDown(int pos);
+    };
+
+    // よく使う順の集合（キーの大きい順、同じキーはアプリID順）
+    struct FrecencyEntry {
+        double key;
+        QString appId;
+        bool operator<(const FrecencyEntry &other) const;
+    };
+
+    std::set<FrecencyEntry> m_frecency;
+    QHash<QString, double> m_frecencyKeys;     // 起動済みのアプリID → m_frecency 上のキー
+    IndexedMaxHeap m_launchCount;
+    IndexedMaxHeap m_lastLaunch;
+
+    void insert(const QString &appId, int launchCount, qint64 lastLaunchMSecs);
+    void setFrecencyKey(const QString &appId, double key);
+    void removeFrecencyKey(const QString &appId);
+};
+
+#endif // FRECENCYINDEX_H
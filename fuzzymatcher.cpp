@@ -0,0 +1,328 @@
+#include "fuzzymatcher.h"
+#include "searchindex.h"
+#include <QtAlgorithms>
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define FUZZY_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(FUZZY_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define FUZZY_HAVE_SSE2 1
+#endif
+
+#if defined(FUZZY_X86) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define FUZZY_HAVE_AVX2 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FUZZY_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define FUZZY_TARGET_AVX2
+#endif
+
+namespace {
+
+// スコアの重み（fzfの値に準拠）
+const int ScoreMatch = 16;
+const int ScoreGapStart = -3;
+const int ScoreGapExtension = -1;
+const int BonusBoundary = ScoreMatch / 2;
+const int BonusNonWord = ScoreMatch / 2;
+const int BonusNumber = BonusBoundary - 1;
+const int BonusConsecutive = -(ScoreGapStart + ScoreGapExtension);
+const int BonusFirstCharMultiplier = 2;
+const int BonusPrefix = ScoreMatch / 2;
+
+enum CharClass {
+    ClassDelimiter,
+    ClassNumber,
+    ClassLetter
+};
+
+CharClass charClass(char16_t ch)
+{
+    switch (ch) {
+    case u' ':
+    case u'-':
+    case u'_':
+    case u'.':
+    case u'/':
+    case u'\\':
+    case u':':
+    case u'(':
+    case u')':
+    case u'[':
+    case u']':
+        return ClassDelimiter;
+    default:
+        break;
+    }
+    if (ch >= u'0' && ch <= u'9') {
+        return ClassNumber;
+    }
+    return ClassLetter;
+}
+
+int bonusFor(CharClass previous, CharClass current)
+{
+    if (current == ClassDelimiter) {
+        return BonusNonWord;
+    }
+    if (previous == ClassDelimiter) {
+        return BonusBoundary;
+    }
+    if (previous == ClassLetter && current == ClassNumber) {
+        return BonusNumber;
+    }
+    return 0;
+}
+
+// ---- 文字探索（data[0..length) から ch の最初の位置、なければ-1） ----
+
+int findCharScalar(const char16_t *data, int length, char16_t ch)
+{
+    for (int i = 0; i < length; ++i) {
+        if (data[i] == ch) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifdef FUZZY_HAVE_SSE2
+int findCharSse2(const char16_t *data, int length, char16_t ch)
+{
+    const __m128i needle = _mm_set1_epi16(short(ch));
+    int i = 0;
+    for (; i + 8 <= length; i += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const quint32 mask = quint32(_mm_movemask_epi8(_mm_cmpeq_epi16(chunk, needle)));
+        if (mask) {
+            return i + int(qCountTrailingZeroBits(mask) / 2);
+        }
+    }
+    const int rest = findCharScalar(data + i, length - i, ch);
+    return rest < 0 ? -1 : i + rest;
+}
+#endif
+
+#ifdef FUZZY_HAVE_AVX2
+FUZZY_TARGET_AVX2
+int findCharAvx2(const char16_t *data, int length, char16_t ch)
+{
+    const __m256i needle = _mm256_set1_epi16(short(ch));
+    int i = 0;
+    for (; i + 16 <= length; i += 16) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const quint32 mask = quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi16(chunk, needle)));
+        if (mask) {
+            return i + int(qCountTrailingZeroBits(mask) / 2);
+        }
+    }
+    const int rest = findCharScalar(data + i, length - i, ch);
+    return rest < 0 ? -1 : i + rest;
+}
+
+bool cpuSupportsAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // OSがYMMレジスタを退避するか（OSXSAVE + XCR0）も確認する
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+typedef int (*FindCharFunction)(const char16_t *, int, char16_t);
+
+struct FindCharImpl {
+    FindCharFunction function;
+    const char *name;
+};
+
+FindCharImpl selectFindChar()
+{
+#ifdef FUZZY_HAVE_AVX2
+    if (cpuSupportsAvx2()) {
+        return FindCharImpl{findCharAvx2, "avx2"};
+    }
+#endif
+#ifdef FUZZY_HAVE_SSE2
+    return FindCharImpl{findCharSse2, "sse2"};
+#else
+    return FindCharImpl{findCharScalar, "scalar"};
+#endif
+}
+
+const FindCharImpl &findCharImpl()
+{
+    static const FindCharImpl impl = selectFindChar();
+    return impl;
+}
+
+// 一致した範囲 [start, end) のスコアを計算する
+int scoreRange(const char16_t *text, int start, int end, const char16_t *pattern, int patternLength)
+{
+    int score = 0;
+    int patternIndex = 0;
+    int consecutive = 0;
+    int firstBonus = 0;
+    bool inGap = false;
+    CharClass previous = start > 0 ? charClass(text[start - 1]) : ClassDelimiter;
+
+    for (int i = start; i < end && patternIndex < patternLength; ++i) {
+        const CharClass current = charClass(text[i]);
+        if (text[i] == pattern[patternIndex]) {
+            score += ScoreMatch;
+            int bonus = bonusFor(previous, current);
+            if (consecutive == 0) {
+                firstBonus = bonus;
+            } else {
+                // 連続一致は、その連続の先頭が得たボーナスを引き継ぐ
+                if (bonus >= BonusBoundary && bonus > firstBonus) {
+                    firstBonus = bonus;
+                }
+                bonus = std::max({bonus, firstBonus, BonusConsecutive});
+            }
+            score += (patternIndex == 0) ? bonus * BonusFirstCharMultiplier : bonus;
+            inGap = false;
+            ++consecutive;
+            ++patternIndex;
+        } else {
+            score += inGap ? ScoreGapExtension : ScoreGapStart;
+            inGap = true;
+            consecutive = 0;
+            firstBonus = 0;
+        }
+        previous = current;
+    }
+
+    if (start == 0) {
+        score += BonusPrefix;
+    }
+    return score;
+}
+
+struct RankedMatch {
+    FuzzyMatcher::Match match;
+    int length;
+};
+
+// 「より良い」一致が先に来る順序
+bool betterMatch(const RankedMatch &a, const RankedMatch &b)
+{
+    if (a.match.score != b.match.score) {
+        return a.match.score > b.match.score;
+    }
+    if (a.length != b.length) {
+        return a.length < b.length;
+    }
+    return a.match.docId < b.match.docId;
+}
+
+}
+
+int FuzzyMatcher::score(QStringView text, QStringView pattern)
+{
+    const char16_t *data = text.utf16();
+    const char16_t *needle = pattern.utf16();
+    const int length = text.size();
+    const int patternLength = pattern.size();
+    if (patternLength == 0) {
+        return 0;
+    }
+    if (patternLength > length) {
+        return -1;
+    }
+
+    // 前方から貪欲に部分列を探す（ここがSIMDで高速化される部分）
+    const FindCharFunction findChar = findCharImpl().function;
+    int pos = -1;
+    for (int p = 0; p < patternLength; ++p) {
+        const int from = pos + 1;
+        const int found = findChar(data + from, length - from, needle[p]);
+        if (found < 0) {
+            return -1;
+        }
+        pos = from + found;
+    }
+    const int end = pos + 1;
+
+    // 後方から戻って最短の一致範囲に縮める
+    int start = pos;
+    int p = patternLength - 1;
+    for (int i = pos; i >= 0; --i) {
+        if (data[i] == needle[p]) {
+            if (--p < 0) {
+                start = i;
+                break;
+            }
+        }
+    }
+
+    return scoreRange(data, start, end, needle, patternLength);
+}
+
+QVector<FuzzyMatcher::Match> FuzzyMatcher::search(const SearchIndex &index, const QString &keyword, int limit)
+{
+    QVector<Match> results;
+    if (limit <= 0) {
+        return results;
+    }
+
+    const QString pattern = SearchIndex::normalize(keyword);
+
+    // 上位limit件だけを保持するヒープ（先頭が保持中で最も悪い一致）
+    std::priority_queue<RankedMatch, std::vector<RankedMatch>, decltype(&betterMatch)> heap(betterMatch);
+    const int count = index.documentCount();
+    for (int docId = 0; docId < count; ++docId) {
+        if (!index.isAlive(docId)) {
+            continue;
+        }
+        const QStringView name = index.nameKey(docId);
+        const int matchScore = score(name, pattern);
+        if (matchScore < 0) {
+            continue;
+        }
+
+        const RankedMatch candidate{Match{quint32(docId), matchScore}, int(name.size())};
+        if (int(heap.size()) < limit) {
+            heap.push(candidate);
+        } else if (betterMatch(candidate, heap.top())) {
+            heap.pop();
+            heap.push(candidate);
+        }
+    }
+
+    results.resize(heap.size());
+    for (int i = results.size() - 1; i >= 0; --i) {
+        results[i] = heap.top().match;
+        heap.pop();
+    }
+    return results;
+}
+
+const char *FuzzyMatcher::simdLevel()
+{
+    return findCharImpl().name;
+}
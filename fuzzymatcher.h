@@ -0,0 +1,33 @@
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+class SearchIndex;
+
+// fzf風のあいまい検索（検索語の文字を順番どおりに含む名前を探してスコア順に並べる）
+//
+// スコアは連続一致・単語境界・先頭一致にボーナスを与え、途中の隙間を減点する。
+// 文字の探索は正規化済みの名前（SearchIndexの連続バッファ上のUTF-16）に対して
+// AVX2 / SSE2 で8〜16文字ずつ比較し、使えない環境ではスカラー版で処理する。
+class FuzzyMatcher
+{
+public:
+    struct Match {
+        quint32 docId;
+        int score;
+    };
+
+    // 1件のスコア（一致しない場合は-1。text・patternは正規化済みであること）
+    static int score(QStringView text, QStringView pattern);
+
+    // 上位limit件をスコアの高い順に返す（同点は名前の短い順、次にカタログ順）
+    static QVector<Match> search(const SearchIndex &index, const QString &keyword, int limit);
+
+    // 実行時に選ばれた文字探索の実装（"avx2" / "sse2" / "scalar"）
+    static const char *simdLevel();
+};
+
+#endif // FUZZYMATCHER_H
@@ -0,0 +1,291 @@
+#include "iconrepairqueue.h"
+#include "iconextractor.h"
+#include <QTimer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QDebug>
+#include <utility>
+
+namespace {
+
+// ワーカーが1回にまとめてGUIスレッドへ返す件数
+const int CheckChunkSize = 64;
+// タイマー1回あたりの抽出件数（抽出は重いので少なめ）
+const int ExtractBatchSize = 4;
+// これ以下のサイズのアイコンはグレーアイコンとみなして作り直す
+const qint64 PlaceholderIconSize = 200;
+
+}
+
+IconRepairQueue::IconRepairQueue(QObject *parent)
+    : QObject(parent)
+    , m_worker(new QObject)
+    , m_generation(0)
+    , m_extractor(new IconExtractor(this))
+    , m_extractTimer(new QTimer(this))
+    , m_outstandingChecks(0)
+    , m_active(false)
+{
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread.setObjectName("IconRepairQueue");
+    m_thread.start(QThread::LowPriority);
+
+    m_extractTimer->setInterval(0);
+    connect(m_extractTimer, &QTimer::timeout, this, &IconRepairQueue::extractStep);
+}
+
+IconRepairQueue::~IconRepairQueue()
+{
+    cancel();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void IconRepairQueue::setIconDir(const QString &iconDir)
+{
+    m_iconDir = iconDir;
+}
+
+QString IconRepairQueue::iconDir() const
+{
+    return m_iconDir;
+}
+
+void IconRepairQueue::start(const QList<Entry> &entries)
+{
+    cancel();
+    if (entries.isEmpty()) {
+        return;
+    }
+
+    int generation = m_generation.loadAcquire();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pendingChecks = entries;
+    }
+    m_outstandingChecks = entries.size();
+    m_active = true;
+
+    QString iconDir = m_iconDir;
+    QMetaObject::invokeMethod(m_worker, [this, generation, iconDir]() {
+        QDir(iconDir).mkpath(".");
+        processChecks(generation, iconDir);
+    }, Qt::QueuedConnection);
+    qDebug() << "Started icon repair for" << entries.size() << "applications";
+}
+
+void IconRepairQueue::cancel()
+{
+    // 世代を進めて、ワーカーの処理中の結果を無効にする
+    {
+        QMutexLocker locker(&m_mutex);
+        m_generation.fetchAndAddOrdered(1);
+        m_pendingChecks.clear();
+    }
+
+    m_extractTimer->stop();
+    m_extractTasks.clear();
+    m_extractOrder.clear();
+    m_urgentOrder.clear();
+    m_urgentIds.clear();
+    m_outstandingChecks = 0;
+    m_active = false;
+}
+
+void IconRepairQueue::prioritize(const QStringList &appIds)
+{
+    if (!m_active) {
+        return;
+    }
+
+    m_urgentIds = QSet<QString>(appIds.begin(), appIds.end());
+
+    // 抽出待ちのものは優先キューへ
+    m_urgentOrder.clear();
+    for (const QString &appId : appIds) {
+        if (m_extractTasks.contains(appId)) {
+            m_urgentOrder.append(appId);
+        }
+    }
+
+    // 未検証のものはワーカーの待ち行列の先頭へ移す
+    QMutexLocker locker(&m_mutex);
+    QList<Entry> urgent;
+    QList<Entry> rest;
+    for (const Entry &entry : std::as_const(m_pendingChecks)) {
+        if (m_urgentIds.contains(entry.appId)) {
+            urgent.append(entry);
+        } else {
+            rest.append(entry);
+        }
+    }
+    if (!urgent.isEmpty()) {
+        m_pendingChecks = urgent + rest;
+    }
+}
+
+bool IconRepairQueue::isIdle() const
+{
+    return !m_active;
+}
+
+void IconRepairQueue::processChecks(int generation, const QString &iconDir)
+{
+    IconExtractor extractor;
+
+    for (;;) {
+        QList<Entry> chunk;
+        {
+            // 世代の確認も同じロック内で行い、差し替え後の要求を古い世代で処理しないようにする
+            QMutexLocker locker(&m_mutex);
+            if (m_generation.loadAcquire() != generation || m_pendingChecks.isEmpty()) {
+                return;
+            }
+            const int count = qMin(CheckChunkSize, int(m_pendingChecks.size()));
+            chunk = m_pendingChecks.mid(0, count);
+            m_pendingChecks.remove(0, count);
+        }
+
+        QList<CheckResult> results;
+        results.reserve(chunk.size());
+        for (const Entry &entry : std::as_const(chunk)) {
+            results.append(checkEntry(entry, iconDir, extractor));
+        }
+
+        QMetaObject::invokeMethod(this, [this, generation, results]() {
+            onChecked(generation, results);
+        }, Qt::QueuedConnection);
+    }
+}
+
+IconRepairQueue::CheckResult IconRepairQueue::checkEntry(const Entry &entry, const QString &iconDir,
+                                                         IconExtractor &extractor)
+{
+    CheckResult result{entry.appId, entry.appPath, QString(), ActionNone, false};
+
+    QString iconPath = entry.iconPath;
+    // 既存データのiconPath修正: exeファイルパスが設定されている場合は空にする
+    if (!iconPath.isEmpty() && iconPath.endsWith(".exe", Qt::CaseInsensitive)) {
+        iconPath.clear();
+        result.invalidPath = true;
+    }
+
+    // iconPathが空、存在しない、またはグレーアイコン（200バイト以下）の場合、アイコンを再生成
+    bool needsRegenerate = iconPath.isEmpty();
+    if (!needsRegenerate) {
+        QFileInfo iconInfo(iconPath);
+        if (!iconInfo.exists()) {
+            needsRegenerate = true;
+        } else if (iconInfo.size() <= PlaceholderIconSize) {
+            needsRegenerate = true;
+            QFile::remove(iconPath);  // 古いファイルを削除
+        }
+    }
+
+    if (!needsRegenerate || entry.appPath.isEmpty()) {
+        return result;
+    }
+
+    result.targetPath = extractor.generateIconPath(entry.appPath, iconDir);
+    QFileInfo targetInfo(result.targetPath);
+    if (targetInfo.exists() && targetInfo.size() > PlaceholderIconSize) {
+        result.action = ActionUseExisting;
+    } else {
+        // 既存の小さいファイルも削除
+        if (targetInfo.exists()) {
+            QFile::remove(result.targetPath);
+        }
+        result.action = ActionExtract;
+    }
+    return result;
+}
+
+void IconRepairQueue::onChecked(int generation, const QList<CheckResult> &results)
+{
+    if (generation != m_generation.loadAcquire()) {
+        return;
+    }
+
+    for (const CheckResult &result : results) {
+        --m_outstandingChecks;
+        switch (result.action) {
+        case ActionNone:
+            if (result.invalidPath) {
+                emit iconRepaired(result.appId, QString());
+            }
+            break;
+        case ActionUseExisting:
+            emit iconRepaired(result.appId, result.targetPath);
+            break;
+        case ActionExtract:
+            m_extractTasks.insert(result.appId, result);
+            if (m_urgentIds.contains(result.appId)) {
+                m_urgentOrder.append(result.appId);
+            } else {
+                m_extractOrder.append(result.appId);
+            }
+            break;
+        }
+    }
+
+    if (!m_extractTasks.isEmpty() && !m_extractTimer->isActive()) {
+        m_extractTimer->start();
+    }
+    finishIfDone();
+}
+
+void IconRepairQueue::extractStep()
+{
+    for (int processed = 0; processed < ExtractBatchSize; ++processed) {
+        QString appId = takeNextTask();
+        if (appId.isEmpty()) {
+            break;
+        }
+
+        CheckResult task = m_extractTasks.take(appId);
+        if (m_extractor->extractAndSaveIcon(task.appPath, task.targetPath)) {
+            qDebug() << "Generated icon for:" << task.appPath << "->" << task.targetPath;
+            emit iconRepaired(task.appId, task.targetPath);
+        } else if (task.invalidPath) {
+            emit iconRepaired(task.appId, QString());
+        }
+    }
+
+    if (m_extractTasks.isEmpty()) {
+        m_extractTimer->stop();
+        finishIfDone();
+    }
+}
+
+QString IconRepairQueue::takeNextTask()
+{
+    // 表示中の行を先に処理する（処理済みのIDは読み飛ばす）
+    while (!m_urgentOrder.isEmpty()) {
+        QString appId = m_urgentOrder.takeFirst();
+        if (m_extractTasks.contains(appId)) {
+            return appId;
+        }
+    }
+    while (!m_extractOrder.isEmpty()) {
+        QString appId = m_extractOrder.takeFirst();
+        if (m_extractTasks.contains(appId)) {
+            return appId;
+        }
+    }
+    return QString();
+}
+
+void IconRepairQueue::finishIfDone()
+{
+    if (!m_active || m_outstandingChecks > 0 || !m_extractTasks.isEmpty()) {
+        return;
+    }
+
+    m_active = false;
+    m_urgentIds.clear();
+    qDebug() << "Icon repair finished";
+    emit finished();
+}
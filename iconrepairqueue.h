@@ -0,0 +1,90 @@
+#ifndef ICONREPAIRQUEUE_H
+#define ICONREPAIRQUEUE_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
+
+class QTimer;
+class IconExtractor;
+
+// 起動後にアイコンファイルを検証・再生成するバックグラウンドキュー
+// ファイルの存在・サイズ確認はワーカースレッドで行い、
+// アイコン抽出（QPixmapを使うためGUIスレッド限定）はタイマーで少しずつ実行する。
+// 表示中の行は prioritize() で優先的に処理される。
+class IconRepairQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Entry {
+        QString appId;
+        QString appPath;
+        QString iconPath;
+    };
+
+    explicit IconRepairQueue(QObject *parent = nullptr);
+    ~IconRepairQueue();
+
+    void setIconDir(const QString &iconDir);
+    QString iconDir() const;
+
+    // 検証対象を差し替えて開始（処理中のものは破棄）
+    void start(const QList<Entry> &entries);
+    void cancel();
+    void prioritize(const QStringList &appIds);
+    bool isIdle() const;
+
+signals:
+    void iconRepaired(const QString &appId, const QString &iconPath);
+    void finished();
+
+private:
+    enum Action {
+        ActionNone,         // 現在のアイコンで問題なし
+        ActionUseExisting,  // 生成済みのアイコンファイルを使う
+        ActionExtract       // 実行ファイルから抽出し直す
+    };
+
+    struct CheckResult {
+        QString appId;
+        QString appPath;
+        QString targetPath;
+        Action action;
+        bool invalidPath;   // 元のiconPathが不正（抽出に失敗したら空にする）
+    };
+
+    QThread m_thread;
+    QObject *m_worker;      // m_thread 上で動作するコンテキスト
+    QString m_iconDir;
+
+    // ワーカー側（m_mutexで保護）
+    QMutex m_mutex;
+    QList<Entry> m_pendingChecks;
+    QAtomicInt m_generation;
+
+    // GUIスレッド側
+    IconExtractor *m_extractor;
+    QTimer *m_extractTimer;
+    QHash<QString, CheckResult> m_extractTasks;
+    QList<QString> m_extractOrder;
+    QList<QString> m_urgentOrder;
+    QSet<QString> m_urgentIds;
+    int m_outstandingChecks;
+    bool m_active;
+
+    void processChecks(int generation, const QString &iconDir);
+    static CheckResult checkEntry(const Entry &entry, const QString &iconDir, IconExtractor &extractor);
+    void onChecked(int generation, const QList<CheckResult> &results);
+    void extractStep();
+    QString takeNextTask();
+    void finishIfDone();
+};
+
+#endif // ICONREPAIRQUEUE_H
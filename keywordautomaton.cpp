@@ -0,0 +1,103 @@
+#include "keywordautomaton.h"
+#include <QQueue>
+
+KeywordAutomaton::KeywordAutomaton()
+{
+    m_nodes.append(Node());
+}
+
+void KeywordAutomaton::clear()
+{
+    m_nodes.clear();
+    m_nodes.append(Node());
+    m_keywords.clear();
+    m_keywordIndex.clear();
+}
+
+int KeywordAutomaton::addKeyword(const QString &keyword)
+{
+    auto it = m_keywordIndex.constFind(keyword);
+    if (it != m_keywordIndex.constEnd()) {
+        return it.value();
+    }
+
+    const int index = m_keywords.size();
+    m_keywords.append(keyword);
+    m_keywordIndex.insert(keyword, index);
+
+    int state = 0;
+    for (const QChar c : keyword) {
+        auto next = m_nodes.at(state).next.constFind(c.unicode());
+        if (next != m_nodes.at(state).next.constEnd()) {
+            state = next.value();
+        } else {
+            m_nodes.append(Node());
+            const int created = m_nodes.size() - 1;
+            m_nodes[state].next.insert(c.unicode(), created);
+            state = created;
+        }
+    }
+    m_nodes[state].keywords.append(index);
+    return index;
+}
+
+void KeywordAutomaton::build()
+{
+    // 幅優先で失敗遷移を張り、遷移先で終わるキーワードも引き継ぐ
+    QQueue<int> queue;
+    for (auto it = m_nodes.at(0).next.constBegin(); it != m_nodes.at(0).next.constEnd(); ++it) {
+        m_nodes[it.value()].fail = 0;
+        queue.enqueue(it.value());
+    }
+
+    while (!queue.isEmpty()) {
+        const int state = queue.dequeue();
+        const QHash<ushort, int> children = m_nodes.at(state).next;
+        for (auto it = children.constBegin(); it != children.constEnd(); ++it) {
+            const ushort c = it.key();
+            const int child = it.value();
+
+            int fail = m_nodes.at(state).fail;
+            while (fail != 0 && !m_nodes.at(fail).next.contains(c)) {
+                fail = m_nodes.at(fail).fail;
+            }
+            auto target = m_nodes.at(fail).next.constFind(c);
+            const int failState = (target != m_nodes.at(fail).next.constEnd() && target.value() != child)
+                                  ? target.value() : 0;
+
+            m_nodes[child].fail = failState;
+            m_nodes[child].keywords.append(m_nodes.at(failState).keywords);
+            queue.enqueue(child);
+        }
+    }
+}
+
+int KeywordAutomaton::keywordCount() const
+{
+    return m_keywords.size();
+}
+
+QString KeywordAutomaton::keyword(int index) const
+{
+    return m_keywords.value(index);
+}
+
+int KeywordAutomaton::step(int state, QChar c) const
+{
+    for (;;) {
+        const Node &node = m_nodes.at(state);
+        auto it = node.next.constFind(c.unicode());
+        if (it != node.next.constEnd()) {
+            return it.value();
+        }
+        if (state == 0) {
+            return 0;
+        }
+        state = node.fail;
+    }
+}
+
+const QList<int> &KeywordAutomaton::keywordsAt(int state) const
+{
+    return m_nodes.at(state).keywords;
+}
@@ -0,0 +1,41 @@
+#ifndef KEYWORDAUTOMATON_H
+#define KEYWORDAUTOMATON_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+
+// 複数のキーワードを1回の走査で探す Aho-Corasick オートマトン
+//
+// addKeyword() で登録してから build() で失敗遷移を張る。照合側は状態 0（根）から始めて
+// 1文字ずつ step() で進め、keywordsAt() でその位置で終わるキーワードの番号を得る。
+// 構築後は読み取り専用なので、複数スレッドから同時に使える。
+class KeywordAutomaton
+{
+public:
+    KeywordAutomaton();
+
+    void clear();
+    int addKeyword(const QString &keyword);     // キーワードの番号（登録済みなら同じ番号）
+    void build();
+
+    int keywordCount() const;
+    QString keyword(int index) const;
+
+    int step(int state, QChar c) const;
+    const QList<int> &keywordsAt(int state) const;
+
+private:
+    struct Node {
+        QHash<ushort, int> next;
+        int fail = 0;
+        QList<int> keywords;    // このノードで終わるキーワード（失敗遷移先の分も含む）
+    };
+
+    QList<Node> m_nodes;        // トライ（0 が根）
+    QStringList m_keywords;
+    QHash<QString, int> m_keywordIndex;
+};
+
+#endif // KEYWORDAUTOMATON_H
@@ -1,5 +1,7 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "excludelist.h"
+#include "pathtrie.h"
 #include <QMessageBox>
 #include <QMenu>
 #include <QHeaderView>
@@ -31,9 +33,9 @@ MainWindow::MainWindow(QWidget *parent)
     , m_appLauncher(new AppLauncher(this))
     , m_iconExtractor(new IconExtractor(this))
     , m_appListModel(new AppListModel(this))
+    , m_searchWorker(new SearchWorker(this))
     , m_isGridView(false)
     , m_selectedAppId("")
-    , m_mainTimer(new QTimer(this))
     , m_resizeTimer(new QTimer(this))
     , m_progressBar(nullptr)
     , m_loadingLabel(nullptr)
@@ -129,11 +131,6 @@ MainWindow::MainWindow(QWidget *parent)
     loadApplicationsAsync();
     updateStatusBar();
     
-    // 統合メインタイマーの設定（複数機能を統合してパフォーマンス向上）
-    m_mainTimer->setInterval(2000); // 2秒間隔に変更（CPUリソース節約）
-    connect(m_mainTimer, &QTimer::timeout, this, &MainWindow::updateStatusBar);
-    m_mainTimer->start();
-    
     // リサイズタイマーの設定（スクロールパフォーマンス最適化）
     m_resizeTimer->setSingleShot(true);
     m_resizeTimer->setInterval(500); // 500msに延長して頻繁な更新を防ぐ
@@ -150,12 +147,6 @@ MainWindow::~MainWindow()
     saveColumnWidths();
 
     // タイマーを停止・削除（統合最適化後）
-    if (m_mainTimer) {
-        m_mainTimer->stop();
-        delete m_mainTimer;
-        m_mainTimer = nullptr;
-    }
-    
     if (m_resizeTimer) {
         m_resizeTimer->stop();
         delete m_resizeTimer;
@@ -204,6 +195,11 @@ void MainWindow::setupConnections()
     // 検索機能の接続
     connect(ui->searchLineEdit, &QLineEdit::textChanged, this, &MainWindow::onSearchTextChanged);
     connect(ui->filterButton, &QPushButton::clicked, this, &MainWindow::onFilterButtonClicked);
+    ui->fuzzySearchCheckBox->setChecked(QSettings("GameLauncher", "GameLauncher").value("Search/fuzzy", false).toBool());
+    connect(ui->fuzzySearchCheckBox, &QCheckBox::toggled, this, [this](bool checked) {
+        QSettings("GameLauncher", "GameLauncher").setValue("Search/fuzzy", checked);
+        filterApplications();
+    });
     
     // リストビューイベント（QTableView）
     connect(ui->listTableView, &QTableView::doubleClicked, this, &MainWindow::onListItemDoubleClicked);
@@ -238,12 +234,17 @@ void MainWindow::setupConnections()
     ui->listTableView->verticalHeader()->setMaximumSectionSize(56);
 
     // アプリケーション管理イベント
-    connect(m_appManager, &AppManager::appAdded, this, &MainWindow::onAppAdded);
+    // 追加・削除・更新（起動記録を含む）はまとめて catalogChanged で受け取る
+    connect(m_appManager, &AppManager::catalogChanged, this, &MainWindow::onCatalogChanged);
     connect(m_appManager, &AppManager::appsAdded, this, &MainWindow::onAppsAdded);
-    connect(m_appManager, &AppManager::appRemoved, this, &MainWindow::onAppRemoved);
-    connect(m_appManager, &AppManager::appUpdated, this, &MainWindow::onAppUpdated);
+    connect(m_appManager, &AppManager::iconPathChanged, this, &MainWindow::onAppIconPathChanged);
+    connect(m_appManager, &AppManager::externalChangesLoaded, this, [this](int count) {
+        statusBar()->showMessage(QString("他で変更された%1件のアプリ情報を読み込みました").arg(count), 3000);
+    });
+    connect(m_searchWorker, &SearchWorker::resultsReady, this, &MainWindow::onSearchResultsReady);
     
-    // アプリケーション起動イベント
+    // アプリケーション起動イベント（起動記録の反映を先に行う）
+    connect(m_appLauncher, &AppLauncher::launched, m_appManager, &AppManager::recordLaunch);
     connect(m_appLauncher, &AppLauncher::launched, this, &MainWindow::onAppLaunched);
     connect(m_appLauncher, &AppLauncher::finished, this, &MainWindow::onAppLaunchFinished);
     connect(m_appLauncher, &AppLauncher::errorOccurred, this, &MainWindow::onAppLaunchError);
@@ -330,10 +331,9 @@ void MainWindow::updateListView()
 {
     if (m_isLoading) return;
 
-    // シンプルにアプリ一覧を取得して表示
-    QList<AppInfo> apps = m_appManager->getApps();
-    m_appList = apps;
-    m_appListModel->setApps(apps);
+    // よく使う順に並べて表示
+    m_searchWorker->cancel();
+    m_appListModel->setRows(m_appManager->getStore(), m_appManager->getFrecencyOrderedRows());
     updatePageControls();
 }
 
@@ -344,7 +344,7 @@ void MainWindow::clearListView()
 
 void MainWindow::updateAppCount()
 {
-    int displayedCount = m_appList.size();
+    int displayedCount = m_appListModel->appCount();
     int totalCount = m_appManager->getAppCount();
     
     if (m_currentFilter.isEmpty()) {
@@ -357,41 +357,64 @@ void MainWindow::updateAppCount()
 void MainWindow::filterApplications()
 {
     if (m_currentFilter.isEmpty()) {
-        // フィルターが空の場合は全てのアプリを表示
-        QList<AppInfo> apps = m_appManager->getApps();
-        m_appList = apps;
-        m_appListModel->setApps(apps);
+        // フィルターが空の場合は全てのアプリを表示（実行中の検索は破棄）
+        m_searchWorker->cancel();
+        m_searchSnapshot.reset();
+        m_appListModel->setRows(m_appManager->getStore(), m_appManager->getFrecencyOrderedRows());
+        updatePageControls();
+        updateAppCount();
     } else {
-        // 検索キーワードでフィルタリング
-        QList<AppInfo> filteredApps = m_appManager->searchApps(m_currentFilter);
-        m_appList = filteredApps;
-        m_appListModel->setApps(filteredApps);
+        // 検索はワーカースレッドで行い、結果は onSearchResultsReady で受け取る
+        // （結果が届くまでは前回の表示を残す）
+        // 行番号は検索を始めた時点の版のものなので、その版を結果が揃うまで保持する
+        m_searchSnapshot = m_appManager->snapshot();
+        const SearchWorker::Mode mode = ui->fuzzySearchCheckBox->isChecked()
+                ? SearchWorker::Fuzzy : SearchWorker::Substring;
+        m_searchWorker->search(m_appManager->getSearchIndex(), m_currentFilter, mode);
+    }
+}
+
+void MainWindow::onSearchResultsReady(quint64 generation, const QVector<int> &rows, bool first, bool last)
+{
+    Q_UNUSED(generation);
+    
+    if (!m_searchSnapshot) {
+        return;
+    }
+    
+    if (first) {
+        m_appListModel->setRows(m_searchSnapshot->store(), rows);
+    } else {
+        m_appListModel->appendRows(rows);
+    }
+    
+    if (first || last) {
+        updatePageControls();
+        updateAppCount();
+    }
+    if (last) {
+        // モデルが同じカタログを共有しているので、こちらの参照は手放す
+        m_searchSnapshot.reset();
     }
-    updatePageControls();
-    updateAppCount();
 }
 
 bool MainWindow::launchApplication(const QString &appId)
 {
-    AppInfo *app = m_appManager->findApp(appId);
+    AppStore::Row app = m_appManager->findApp(appId);
     if (!app) {
         QMessageBox::warning(this, "エラー", "アプリケーションが見つかりません。");
         return false;
     }
     
-    if (!app->fileExists()) {
+    if (!app.fileExists()) {
         QMessageBox::warning(this, "エラー", 
-                           QString("アプリケーションファイルが見つかりません: %1").arg(app->path));
+                           QString("アプリケーションファイルが見つかりません: %1").arg(app.path()));
         return false;
     }
     
-    bool success = m_appLauncher->launch(*app);
-    if (success) {
-        // 軽量UI更新（AppManager更新は不要）
-        updateStatusBar();
-    }
-    
-    return success;
+    // 起動情報の反映とステータスバーの更新は launched → AppManager::recordLaunch → catalogChanged 経由で行う
+    AppInfo launchInfo = app.toAppInfo();
+    return m_appLauncher->launch(launchInfo);
 }
 
 // UI イベントハンドラ
@@ -428,11 +451,11 @@ void MainWindow::onRemoveAppButtonClicked()
     QStringList appNames;
 
     for (const QString &appId : m_selectedAppIds) {
-        AppInfo *app = m_appManager->findApp(appId);
+        AppStore::Row app = m_appManager->findApp(appId);
         if (app) {
             appIds.append(appId);
-            appPaths.append(app->path);
-            appNames.append(app->name);
+            appPaths.append(app.path());
+            appNames.append(app.name());
         }
     }
 
@@ -525,22 +548,16 @@ void MainWindow::onRemoveAppButtonClicked()
         for (const QString &additionalId : additionalAppIds) {
             if (!appIds.contains(additionalId)) {
                 appIds.append(additionalId);
-                AppInfo *additionalApp = m_appManager->findApp(additionalId);
+                AppStore::Row additionalApp = m_appManager->findApp(additionalId);
                 if (additionalApp) {
-                    appNames.append(additionalApp->name);
+                    appNames.append(additionalApp.name());
                 }
             }
         }
     }
 
-    // アプリを削除
-    int removedCount = 0;
-    for (const QString &appId : appIds) {
-        if (m_appManager->removeApp(appId)) {
-            m_selectedAppIds.remove(appId);  // 選択リストからも削除
-            removedCount++;
-        }
-    }
+    // アプリを一括削除（選択リストからの削除は onCatalogChanged で行う）
+    int removedCount = m_appManager->removeApps(appIds);
 
     if (removedCount > 0) {
         QString statusMsg = QString("%1個のアプリケーションを削除しました").arg(removedCount);
@@ -604,73 +621,93 @@ void MainWindow::onListItemDoubleClicked(const QModelIndex &index)
 }
 
 // アプリ管理イベント
-void MainWindow::onAppAdded(const AppInfo &app)
+void MainWindow::onCatalogChanged(const CatalogChangeSet &changes)
 {
-    // 新しいアイコンのキャッシュをクリア
-    if (!app.iconPath.isEmpty()) {
-        m_iconDelegate->clearCacheFor(app.iconPath);
+    qDebug() << "MainWindow::onCatalogChanged - added" << changes.added().size()
+             << "removed" << changes.removed().size() << "updated" << changes.updated().size();
+    
+    // 削除されたアプリを選択状態から外す
+    for (const QString &appId : changes.removed()) {
+        m_selectedAppIds.remove(appId);
+        if (m_selectedAppId == appId) {
+            m_selectedAppId.clear();
+            ui->removeAppButton->setEnabled(false);
+            qDebug() << "Cleared selected app ID and disabled remove button";
+        }
     }
-    refreshViews();
-    updateAppCount();
+    
+    // 追加・更新されたアイコンのキャッシュをクリア
+    CatalogVersionPtr version = m_appManager->snapshot();
+    const QStringList changedIds = changes.added() + changes.updated();
+    for (const QString &appId : changedIds) {
+        AppStore::Row app = version->findApp(appId);
+        if (app && !app.iconPath().isEmpty()) {
+            m_iconDelegate->clearCacheFor(app.iconPath());
+        }
+    }
+    
+    if (m_isLoading) {
+        return;
+    }
+    
+    if (!m_currentFilter.isEmpty() && (m_searchSnapshot || !changes.added().isEmpty())) {
+        // 追加分が検索語に合うかは分からず、実行中の検索は古い版の行番号を返すので検索し直す
+        filterApplications();
+    } else if (m_appListModel->applyChanges(*version, changes)) {
+        updatePageControls();
+        updateAppCount();
+    } else {
+        refreshViews();
+        updateAppCount();
+    }
+    updateStatusBar();
 }
 
 void MainWindow::onAppsAdded(int count)
 {
+    // 一覧への反映は catalogChanged で済んでいるので、ここでは件数を知らせるだけ
     qDebug() << "MainWindow::onAppsAdded - Added" << count << "apps in batch";
-    refreshViews();
-    updateAppCount();
     statusBar()->showMessage(QString("%1個のアプリケーションを追加しました").arg(count), 3000);
 }
 
-void MainWindow::onAppRemoved(const QString &appId)
+void MainWindow::onAppIconPathChanged(const QString &appId, const QString &iconPath)
 {
-    qDebug() << "MainWindow::onAppRemoved - Removing app:" << appId;
-    refreshViews();
-    updateAppCount();
-    if (m_selectedAppId == appId) {
-        m_selectedAppId.clear();
-        ui->removeAppButton->setEnabled(false);
-        qDebug() << "Cleared selected app ID and disabled remove button";
+    AppStore::Row app = m_appManager->findApp(appId);
+    if (!app) {
+        return;
     }
-}
-
-void MainWindow::onAppUpdated(const AppInfo &app)
-{
-    // 更新されたアイコンのキャッシュをクリア
-    if (!app.iconPath.isEmpty()) {
-        m_iconDelegate->clearCacheFor(app.iconPath);
+    
+    // バックグラウンドで修復されたアイコンを反映
+    if (!iconPath.isEmpty()) {
+        m_iconDelegate->clearCacheFor(iconPath);
     }
-    // モデルを通じて更新
-    m_appListModel->updateApp(app);
-    updateStatusBar();
+    m_iconCache32px.remove(app.path());
+    m_appListModel->updateApp(m_appManager->getStore(), appId);
 }
 
 // 起動イベント
 void MainWindow::onAppLaunched(const QString &appId)
 {
-    AppInfo *app = m_appManager->findApp(appId);
+    AppStore::Row app = m_appManager->findApp(appId);
     if (app) {
-        statusBar()->showMessage(QString("起動しました: %1").arg(app->name), 3000);
+        statusBar()->showMessage(QString("起動しました: %1").arg(app.name()), 3000);
     }
 }
 
 void MainWindow::onAppLaunchFinished(const QString &appId, int exitCode)
 {
-    AppInfo *app = m_appManager->findApp(appId);
+    AppStore::Row app = m_appManager->findApp(appId);
     if (app) {
-        QString message = QString("%1 が終了しました (Exit Code: %2)").arg(app->name).arg(exitCode);
+        QString message = QString("%1 が終了しました (Exit Code: %2)").arg(app.name()).arg(exitCode);
         statusBar()->showMessage(message, 3000);
-        
-        // 軽量なステータス更新のみ（全体再構築は不要）
-        updateStatusBar();
     }
 }
 
 void MainWindow::onAppLaunchError(const QString &appId, const QString &error)
 {
-    AppInfo *app = m_appManager->findApp(appId);
+    AppStore::Row app = m_appManager->findApp(appId);
     if (app) {
-        QString message = QString("起動エラー: %1 - %2").arg(app->name, error);
+        QString message = QString("起動エラー: %1 - %2").arg(app.name(), error);
         QMessageBox::warning(this, "起動エラー", message);
     }
 }
@@ -685,8 +722,6 @@ void MainWindow::onActionDiscoverApps()
 {
     AppDiscoveryDialog dialog(m_appManager, this);
     if (dialog.exec() == QDialog::Accepted) {
-        refreshViews();
-        updateAppCount();
         statusBar()->showMessage("アプリケーションの自動検出が完了しました", 3000);
     }
 }
@@ -745,8 +780,8 @@ void MainWindow::onActionClearIconCache()
         m_appListModel->notifyAllIconsUpdated();
 
         // アイコンキャッシュを再構築
-        if (!m_appList.isEmpty()) {
-            preloadAllIconsAsync(m_appList);
+        if (m_appListModel->appCount() > 0) {
+            preloadAllIconsAsync(m_appListModel->appPaths());
         }
 
         statusBar()->showMessage("アイコンキャッシュをクリアしました。再構築中...", 3000);
@@ -756,10 +791,10 @@ void MainWindow::onActionClearIconCache()
 void MainWindow::updateStatusBar()
 {
     // 最近起動したアプリの情報を表示
-    AppInfo *recentApp = m_appManager->getRecentlyLaunchedApp();
+    AppStore::Row recentApp = m_appManager->getRecentlyLaunchedApp();
     if (recentApp) {
         QString lastLaunchText = QString("最終起動: %1 (%2)")
-                                .arg(recentApp->name, AppListModel::formatLastLaunch(recentApp->lastLaunch));
+                                .arg(recentApp.name(), AppListModel::formatLastLaunch(recentApp.lastLaunch()));
         ui->lastLaunchLabel->setText(lastLaunchText);
     } else {
         ui->lastLaunchLabel->setText("最終起動: なし");
@@ -780,14 +815,14 @@ void MainWindow::onTableViewContextMenuRequested(const QPoint &pos)
 // ヘルパー関数
 void MainWindow::showAppContextMenu(const QString &appId, const QPoint &globalPos)
 {
-    AppInfo *app = m_appManager->findApp(appId);
+    AppStore::Row app = m_appManager->findApp(appId);
     if (!app) return;
     
     QMenu contextMenu;
     
     // フォルダを開く
     QAction *openFolderAction = contextMenu.addAction("フォルダを開く");
-    QFileInfo fileInfo(app->path);
+    QFileInfo fileInfo(app.path());
     QString folderPath = fileInfo.dir().absolutePath();
     connect(openFolderAction, &QAction::triggered, [folderPath]() {
         QDesktopServices::openUrl(QUrl::fromLocalFile(folderPath));
@@ -820,18 +855,19 @@ void MainWindow::showAppContextMenu(const QString &appId, const QPoint &globalPo
 
 void MainWindow::editApplication(const QString &appId)
 {
-    AppInfo *app = m_appManager->findApp(appId);
+    AppStore::Row app = m_appManager->findApp(appId);
     if (!app) {
         QMessageBox::warning(this, "エラー", "アプリケーションが見つかりません。");
         return;
     }
     
-    AddAppDialog dialog(*app, m_appManager->getCategoryManager(), this);
+    // ダイアログ表示中にカタログが変わることがあるので、行ハンドルではなく展開した値を渡す
+    AddAppDialog dialog(app.toAppInfo(), m_appManager->getCategoryManager(), this);
     dialog.setEditMode(true);
     
     if (dialog.exec() == QDialog::Accepted) {
         AppInfo updatedApp = dialog.getAppInfo();
-        updatedApp.id = app->id; // IDは変更しない
+        updatedApp.id = appId; // IDは変更しない
         
         if (m_appManager->updateApp(appId, updatedApp)) {
             statusBar()->showMessage("アプリケーション情報を更新しました: " + updatedApp.name, 3000);
@@ -845,14 +881,14 @@ void MainWindow::removeApplication(const QString &appId)
 {
     qDebug() << "MainWindow::removeApplication - Starting removal for app ID:" << appId;
     
-    AppInfo *app = m_appManager->findApp(appId);
+    AppStore::Row app = m_appManager->findApp(appId);
     if (!app) {
         qWarning() << "MainWindow::removeApplication - App not found:" << appId;
         QMessageBox::warning(this, "エラー", "アプリケーションが見つかりません。");
         return;
     }
     
-    QString appName = app->name; // 削除前に名前を保存
+    QString appName = app.name(); // 削除前に名前を保存
     qDebug() << "MainWindow::removeApplication - Found app:" << appName;
     
     int ret = QMessageBox::question(this, "確認",
@@ -876,55 +912,25 @@ void MainWindow::removeApplication(const QString &appId)
 
 void MainWindow::addPathsToExcludeList(const QStringList &paths)
 {
-    QString appDir = QApplication::applicationDirPath();
-    QString excludeFilePath = QDir(appDir).filePath("exclude_list.txt");
-
-    // 既存の除外リストを読み込み
-    QStringList excludeList;
-    QFile readFile(excludeFilePath);
-    if (readFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QTextStream in(&readFile);
-        while (!in.atEnd()) {
-            QString line = in.readLine().trimmed();
-            if (!line.isEmpty()) {
-                excludeList.append(line);
-            }
-        }
-        readFile.close();
-    }
-
-    // 新しいパスを追加
-    int addedCount = 0;
-    for (const QString &path : paths) {
-        QString normalizedPath = QDir::fromNativeSeparators(path.toLower());
-        if (!excludeList.contains(normalizedPath)) {
-            excludeList.append(normalizedPath);
-            addedCount++;
-        }
-    }
-
-    // 除外リストを保存
-    if (addedCount > 0) {
-        QFile writeFile(excludeFilePath);
-        if (writeFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QTextStream out(&writeFile);
-            for (const QString &excludePath : excludeList) {
-                out << excludePath << "\n";
-            }
-            writeFile.close();
-            qDebug() << "Added" << addedCount << "paths to exclude list";
-        }
+    // ファイル全体は書き直さず、まだ無いパスだけを追記する（他のプロセスの追加分も取り込まれる）
+    ExcludeList excludeList;
+    int addedCount = excludeList.add(paths);
+    if (addedCount < 0) {
+        statusBar()->showMessage("除外リストが他で使用中のため更新できませんでした", 3000);
+        return;
     }
+    qDebug() << "Added" << addedCount << "paths to exclude list";
 }
 
 void MainWindow::showAppProperties(const QString &appId)
 {
-    AppInfo *app = m_appManager->findApp(appId);
+    AppStore::Row app = m_appManager->findApp(appId);
     if (!app) {
         QMessageBox::warning(this, "エラー", "アプリケーションが見つかりません。");
         return;
     }
     
+    QString description = app.description();
     QString properties = QString(
         "<h3>%1</h3>"
         "<p><b>パス:</b> %2</p>"
@@ -932,12 +938,12 @@ void MainWindow::showAppProperties(const QString &appId)
         "<p><b>起動回数:</b> %4回</p>"
         "<p><b>最終起動:</b> %5</p>"
         "<p><b>説明:</b> %6</p>"
-    ).arg(app->name,
-          app->path,
-          app->createdAt.toString("yyyy/MM/dd hh:mm"),
-          QString::number(app->launchCount),
-          AppListModel::formatLastLaunch(app->lastLaunch),
-          app->description.isEmpty() ? "なし" : app->description);
+    ).arg(app.name(),
+          app.path(),
+          app.createdAt().toString("yyyy/MM/dd hh:mm"),
+          QString::number(app.launchCount()),
+          AppListModel::formatLastLaunch(app.lastLaunch()),
+          description.isEmpty() ? "なし" : description);
     
     QMessageBox::information(this, "アプリケーションのプロパティ", properties);
 }
@@ -997,6 +1003,7 @@ void MainWindow::onLoadingFinished()
     loadTimer.start();
     m_appManager->loadApps();
     qDebug() << "AppManager::loadApps() took:" << loadTimer.elapsed() << "ms";
+    updateStatusBar();
     
     // m_uiUpdateTimer は統合されて削除済み
     hideLoadingProgress();
@@ -1152,24 +1159,24 @@ void MainWindow::updateVisibleRowCount()
 
 
 // アイコンキャッシュの事前構築の実装
-void MainWindow::preloadAllIconsAsync(const QList<AppInfo> &apps)
+void MainWindow::preloadAllIconsAsync(const QStringList &appPaths)
 {
-    qDebug() << "Starting preload of" << apps.size() << "icons in background";
+    qDebug() << "Starting preload of" << appPaths.size() << "icons in background";
     
     // キャッシュ構築キューを準備
-    m_iconCacheQueue = apps;
+    m_iconCacheQueue = appPaths;
     m_iconCacheProgress = 0;
     
     // プログレスバーを表示
     m_loadingLabel->setText("アイコンをキャッシュ中...");
     m_loadingLabel->setVisible(true);
     m_progressBar->setVisible(true);
-    m_progressBar->setRange(0, apps.size());
+    m_progressBar->setRange(0, appPaths.size());
     m_progressBar->setValue(0);
     
     // アイコンキャッシュをメモリに読み込み（ファイルは登録時に生成済み）
     qDebug() << "Loading pre-generated icons into memory cache";
-    m_iconCacheQueue = apps;
+    m_iconCacheQueue = appPaths;
     m_iconCacheProgress = 0;
 
     // アイコンキャッシュ構築を開始
@@ -1182,11 +1189,11 @@ void MainWindow::buildIconCacheStep()
     int processed = 0;
     
     while (processed < batchSize && m_iconCacheProgress < m_iconCacheQueue.size()) {
-        const AppInfo &app = m_iconCacheQueue[m_iconCacheProgress];
+        const QString &appPath = m_iconCacheQueue[m_iconCacheProgress];
         
         // キャッシュに存在しない場合のみ構築
-        if (!m_iconCache32px.contains(app.path)) {
-            QIcon icon = getOrCreateIcon32px(app.path);
+        if (!m_iconCache32px.contains(appPath)) {
+            QIcon icon = getOrCreateIcon32px(appPath);
             // getOrCreateIcon32px内でキャッシュに保存される
         }
         
@@ -1333,6 +1340,13 @@ void MainWindow::updatePageControls()
     } else {
         m_pageInfoLabel->setText("0 / 0 ページ");
     }
+
+    // 表示中の行のアイコン修復を優先させる
+    QStringList visibleIds;
+    for (int row = 0; row < m_appListModel->rowCount(); ++row) {
+        visibleIds.append(m_appListModel->getAppId(row));
+    }
+    m_appManager->prioritizeIconRepair(visibleIds);
 }
 
 void MainWindow::displayCurrentPage()
@@ -1505,20 +1519,18 @@ QStringList MainWindow::getParentDirectories(const QStringList &paths)
 
 QStringList MainWindow::findAppsInDirectories(const QStringList &directories)
 {
-    QStringList appIds;
-    QList<AppInfo> allApps = m_appManager->getApps();
-    
-    for (const AppInfo &app : allApps) {
-        QFileInfo appFileInfo(app.path);
-        QString appDirPath = QDir::fromNativeSeparators(appFileInfo.dir().absolutePath().toLower());
-        
-        for (const QString &directory : directories) {
-            if (appDirPath == directory) {
-                appIds.append(app.id);
-                break;
-            }
-        }
+    // アプリをフォルダごとにまとめてから、各フォルダを引く（アプリ数 + フォルダ数に比例）
+    PathTrie appsByDirectory;
+    const AppStore store = m_appManager->getStore();
+    for (int row = 0; row < store.size(); ++row) {
+        QFileInfo appFileInfo(store.path(row));
+        appsByDirectory.insert(appFileInfo.dir().absolutePath(), store.id(row));
     }
     
+    QStringList appIds;
+    for (const QString &directory : directories) {
+        appIds.append(appsByDirectory.valuesAt(directory));
+    }
+    appIds.removeDuplicates();
     return appIds;
 }
@@ -16,6 +16,7 @@
 #include "appdiscoverydialog.h"
 #include "applistmodel.h"
 #include "appicondelegate.h"
+#include "searchworker.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -54,10 +55,12 @@ private slots:
     void onListItemDoubleClicked(const QModelIndex &index);
     
     // アプリ管理イベント
-    void onAppAdded(const AppInfo &app);
+    void onCatalogChanged(const CatalogChangeSet &changes);
     void onAppsAdded(int count);
-    void onAppRemoved(const QString &appId);
-    void onAppUpdated(const AppInfo &app);
+    void onAppIconPathChanged(const QString &appId, const QString &iconPath);
+    
+    // 検索結果（ワーカースレッドから分割して届く）
+    void onSearchResultsReady(quint64 generation, const QVector<int> &rows, bool first, bool last);
     
     // 起動イベント
     void onAppLaunched(const QString &appId);
@@ -123,6 +126,7 @@ private:
     IconExtractor *m_iconExtractor;
     AppListModel *m_appListModel;
     AppIconDelegate *m_iconDelegate;
+    SearchWorker *m_searchWorker;
     
     // UI 状態
     bool m_isGridView;
@@ -134,7 +138,6 @@ private:
     
     
     // 統合タイマー（パフォーマンス最適化）
-    QTimer *m_mainTimer; // メインタイマー - 複数機能を統合
     QTimer *m_resizeTimer; // リサイズ専用（必要時のみ）
     
     // プログレスバーとロード状態管理
@@ -151,13 +154,13 @@ private:
     void clearIconCache();
     
     // アイコンキャッシュの事前構築
-    void preloadAllIconsAsync(const QList<AppInfo> &apps);
+    void preloadAllIconsAsync(const QStringList &appPaths);
     void buildIconCacheStep();
     void onIconCacheCompleted();
 
-    // アプリ情報のキャッシュ
-    QList<AppInfo> m_appList;
-    QList<AppInfo> m_iconCacheQueue; // アイコンキャッシュ構築待ちキュー
+    // 検索時点のカタログ（検索結果の行番号はこれを指す）
+    CatalogVersionPtr m_searchSnapshot;  // 実行中の検索が対象とする版
+    QStringList m_iconCacheQueue; // アイコンキャッシュ構築待ちキュー（アプリのパス）
     QTimer *m_iconTimer; // アイコンキャッシュ構築用タイマー
     int m_iconCacheProgress;
 
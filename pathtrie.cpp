@@ -0,0 +1,145 @@
+#include "pathtrie.h"
+#include <QDir>
+#include <QStringView>
+
+PathTrie::PathTrie()
+{
+    m_nodes.append(Node());
+}
+
+QString PathTrie::normalize(const QString &path)
+{
+    QString normalized = QDir::cleanPath(QDir::fromNativeSeparators(path.trimmed())).toLower();
+    while (normalized.size() > 1 && normalized.endsWith('/')) {
+        normalized.chop(1);
+    }
+    return normalized;
+}
+
+void PathTrie::insert(const QString &path)
+{
+    const QString normalized = normalize(path);
+    if (normalized.isEmpty()) {
+        return;
+    }
+    Node &node = m_nodes[findOrCreate(normalized)];
+    if (!node.marked) {
+        node.marked = true;
+        m_paths.append(normalized);
+    }
+}
+
+void PathTrie::insert(const QString &path, const QString &value)
+{
+    const QString normalized = normalize(path);
+    if (normalized.isEmpty()) {
+        return;
+    }
+    m_nodes[findOrCreate(normalized)].values.append(value);
+}
+
+void PathTrie::clear()
+{
+    m_nodes.clear();
+    m_nodes.append(Node());
+    m_paths.clear();
+}
+
+bool PathTrie::contains(const QString &path) const
+{
+    const int node = find(normalize(path));
+    return node > 0 && m_nodes.at(node).marked;
+}
+
+bool PathTrie::coversPath(const QString &path) const
+{
+    if (m_paths.isEmpty()) {
+        return false;
+    }
+
+    const QString normalized = normalize(path);
+    int node = 0;
+    for (QStringView part : QStringView(normalized).tokenize(u'/', Qt::SkipEmptyParts)) {
+        auto it = m_nodes.at(node).children.constFind(part.toString());
+        if (it == m_nodes.at(node).children.constEnd()) {
+            return false;
+        }
+        node = it.value();
+        if (m_nodes.at(node).marked) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QStringList PathTrie::valuesAt(const QString &path) const
+{
+    const int node = find(normalize(path));
+    return node > 0 ? m_nodes.at(node).values : QStringList();
+}
+
+QStringList PathTrie::valuesUnder(const QString &path) const
+{
+    QStringList values;
+    const int start = find(normalize(path));
+    if (start <= 0) {
+        return values;
+    }
+
+    QList<int> stack;
+    stack.append(start);
+    while (!stack.isEmpty()) {
+        const Node &node = m_nodes.at(stack.takeLast());
+        values.append(node.values);
+        for (int child : node.children) {
+            stack.append(child);
+        }
+    }
+    return values;
+}
+
+QStringList PathTrie::paths() const
+{
+    return m_paths;
+}
+
+int PathTrie::size() const
+{
+    return m_paths.size();
+}
+
+bool PathTrie::isEmpty() const
+{
+    return m_paths.isEmpty();
+}
+
+int PathTrie::find(const QString &path) const
+{
+    int node = 0;
+    for (QStringView part : QStringView(path).tokenize(u'/', Qt::SkipEmptyParts)) {
+        auto it = m_nodes.at(node).children.constFind(part.toString());
+        if (it == m_nodes.at(node).children.constEnd()) {
+            return -1;
+        }
+        node = it.value();
+    }
+    return node;
+}
+
+int PathTrie::findOrCreate(const QString &path)
+{
+    int node = 0;
+    for (QStringView part : QStringView(path).tokenize(u'/', Qt::SkipEmptyParts)) {
+        const QString key = part.toString();
+        auto it = m_nodes.at(node).children.constFind(key);
+        if (it != m_nodes.at(node).children.constEnd()) {
+            node = it.value();
+            continue;
+        }
+        m_nodes.append(Node());
+        const int created = m_nodes.size() - 1;
+        m_nodes[node].children.insert(key, created);
+        node = created;
+    }
+    return node;
+}
@@ -0,0 +1,48 @@
+#ifndef PATHTRIE_H
+#define PATHTRIE_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+
+// パスを区切りごとの要素で辿るトライ
+//
+// パスは normalize() で小文字・'/'区切り・末尾区切り無しにそろえてから扱う（Windowsのパスは大文字小文字を区別しない）。
+// 「このパス自身または上位フォルダが登録されているか」と「このフォルダに属する値（アプリIDなど）」を
+// 登録数によらず、パスの深さに比例する時間で答える。
+class PathTrie
+{
+public:
+    PathTrie();
+
+    static QString normalize(const QString &path);
+
+    void insert(const QString &path);                           // パスを登録する
+    void insert(const QString &path, const QString &value);     // フォルダに値を結び付ける（登録はしない）
+    void clear();
+
+    bool contains(const QString &path) const;       // このパス自身が登録されているか
+    bool coversPath(const QString &path) const;     // このパスか上位フォルダのどれかが登録されているか
+    QStringList valuesAt(const QString &path) const;        // このフォルダに直接結び付いた値
+    QStringList valuesUnder(const QString &path) const;     // このフォルダ以下すべての値
+
+    QStringList paths() const;      // 登録したパス（登録順）
+    int size() const;
+    bool isEmpty() const;
+
+private:
+    struct Node {
+        QHash<QString, int> children;
+        bool marked = false;
+        QStringList values;
+    };
+
+    QList<Node> m_nodes;            // 0 が根
+    QStringList m_paths;
+
+    int find(const QString &path) const;
+    int findOrCreate(const QString &path);
+};
+
+#endif // PATHTRIE_H
@@ -0,0 +1,442 @@
+#include "searchindex.h"
+#include <QDebug>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+// フィールド区切り（検索語には現れないのでフィールドをまたいだ一致は起きない）
+const QChar FieldSeparator(0x1f);
+// 削除済み文書（または不要になったキーの文字数）がこれを超え、かつ生存分より多くなったら詰め直す
+const int CompactionMinimum = 1024;
+
+// カタカナ（ァ〜ヶ）とひらがな（ぁ〜ゖ）の差
+const char16_t KatakanaFirst = 0x30A1;
+const char16_t KatakanaLast = 0x30F6;
+const char16_t KanaOffset = 0x60;
+
+}
+
+SearchIndex::SearchIndex()
+    : m_deadCount(0)
+    , m_garbageLength(0)
+    , m_revision(0)
+{
+}
+
+void SearchIndex::clear()
+{
+    m_documents.clear();
+    m_documentIds.clear();
+    m_postings.clear();
+    m_keys.clear();
+    m_categories.clear();
+    m_categoryOrder.clear();
+    m_deadCount = 0;
+    m_garbageLength = 0;
+    ++m_revision;
+}
+
+void SearchIndex::rebuild(const AppStore &store)
+{
+    clear();
+    m_documents.reserve(store.size());
+    m_documentIds.reserve(store.size());
+    m_keys.reserve(store.size() * 64);
+    for (int row = 0; row < store.size(); ++row) {
+        addApp(store.at(row));
+    }
+}
+
+void SearchIndex::addApp(const AppInfo &app)
+{
+    // 追加はカタログ末尾なので、同じIDが残っていれば古い文書を無効にして新しい文書IDを振る
+    // （古い文書IDのまま更新すると、文書IDの順序とカタログの並び順がずれる）
+    removeApp(app.id);
+
+    const QString key = buildKey(app);
+    const quint32 docId = m_documents.size();
+    ++m_revision;
+    m_documents.append(Document{app.id, appendKey(key), int(key.size()), int(key.indexOf(FieldSeparator)),
+                                app.category, true});
+    m_documentIds.insert(app.id, docId);
+    addPostings(docId, keyOf(m_documents.last()));
+    addToCategory(docId, app.category);
+}
+
+void SearchIndex::updateApp(const QString &appId, const AppInfo &app)
+{
+    auto it = m_documentIds.constFind(appId);
+    if (it == m_documentIds.constEnd()) {
+        addApp(app);
+        return;
+    }
+
+    // 文書IDは変えずにキーを差し替える（並び順を保つため）
+    const quint32 docId = it.value();
+    ++m_revision;
+    if (appId != app.id) {
+        m_documentIds.remove(appId);
+        m_documentIds.insert(app.id, docId);
+    }
+
+    m_documents[docId].appId = app.id;
+    if (m_documents.at(docId).category != app.category) {
+        removeFromCategory(docId, m_documents.at(docId).category);
+        m_documents[docId].category = app.category;
+        addToCategory(docId, app.category);
+    }
+
+    const QString key = buildKey(app);
+    if (keyOf(m_documents.at(docId)) == key) {
+        return;
+    }
+
+    // 新しいキーはバッファ末尾に追記し、古い領域は詰め直しまで放置する
+    const int keyOffset = appendKey(key);
+    Document &doc = m_documents[docId];
+    m_garbageLength += doc.keyLength;
+    doc.keyOffset = keyOffset;
+    doc.keyLength = key.size();
+    doc.nameLength = key.indexOf(FieldSeparator);
+    addPostings(docId, keyOf(doc));
+    compactIfNeeded();
+}
+
+void SearchIndex::removeApp(const QString &appId)
+{
+    auto it = m_documentIds.find(appId);
+    if (it == m_documentIds.end()) {
+        return;
+    }
+
+    // ポスティングからは消さず、文書を無効にするだけ（検索時に読み飛ばす）
+    ++m_revision;
+    Document &doc = m_documents[it.value()];
+    doc.alive = false;
+    removeFromCategory(it.value(), doc.category);
+    m_garbageLength += doc.keyLength;
+    m_documentIds.erase(it);
+    ++m_deadCount;
+    compactIfNeeded();
+}
+
+void SearchIndex::updateCategory(const QString &appId, const QString &category)
+{
+    auto it = m_documentIds.constFind(appId);
+    if (it == m_documentIds.constEnd()) {
+        return;
+    }
+
+    // カテゴリは検索キーに含まれないので、所属の付け替えだけ行う（版番号も進めない）
+    Document &doc = m_documents[it.value()];
+    if (doc.category != category) {
+        removeFromCategory(it.value(), doc.category);
+        doc.category = category;
+        addToCategory(it.value(), category);
+    }
+}
+
+QStringList SearchIndex::search(const QString &keyword) const
+{
+    return appIds(searchDocuments(normalize(keyword)));
+}
+
+QVector<quint32> SearchIndex::searchDocuments(const QString &query) const
+{
+    QVector<quint32> results;
+
+    // トライグラムが作れない短い検索語は全件を走査
+    if (query.size() < 3) {
+        for (int docId = 0; docId < m_documents.size(); ++docId) {
+            const Document &doc = m_documents.at(docId);
+            if (doc.alive && keyOf(doc).contains(query)) {
+                results.append(docId);
+            }
+        }
+        return results;
+    }
+
+    // 検索語の各トライグラムのポスティングリストを集める
+    QVector<const QVector<quint32> *> lists;
+    for (int pos = 0; pos + 3 <= query.size(); ++pos) {
+        auto it = m_postings.constFind(trigramAt(query, pos));
+        if (it == m_postings.constEnd()) {
+            return results;
+        }
+        if (!lists.contains(&it.value())) {
+            lists.append(&it.value());
+        }
+    }
+
+    // 短いリストから順に積集合をとる
+    std::sort(lists.begin(), lists.end(), [](const QVector<quint32> *a, const QVector<quint32> *b) {
+        return a->size() < b->size();
+    });
+    QVector<quint32> candidates = *lists.first();
+    QVector<quint32> intersection;
+    for (int i = 1; i < lists.size() && !candidates.isEmpty(); ++i) {
+        intersection.clear();
+        std::set_intersection(candidates.cbegin(), candidates.cend(),
+                              lists.at(i)->cbegin(), lists.at(i)->cend(),
+                              std::back_inserter(intersection));
+        candidates.swap(intersection);
+    }
+
+    // トライグラムの一致は必要条件なので、実際の部分一致を確認する
+    return filterDocuments(candidates, query);
+}
+
+QVector<quint32> SearchIndex::filterDocuments(const QVector<quint32> &docIds, const QString &query) const
+{
+    QVector<quint32> results;
+    results.reserve(docIds.size());
+    for (quint32 docId : docIds) {
+        if (docId >= quint32(m_documents.size())) {
+            continue;
+        }
+        const Document &doc = m_documents.at(docId);
+        if (doc.alive && keyOf(doc).contains(query)) {
+            results.append(docId);
+        }
+    }
+    return results;
+}
+
+QStringList SearchIndex::appIds(const QVector<quint32> &docIds) const
+{
+    QStringList results;
+    results.reserve(docIds.size());
+    for (quint32 docId : docIds) {
+        results.append(m_documents.at(docId).appId);
+    }
+    return results;
+}
+
+QVector<int> SearchIndex::documentRows() const
+{
+    // 生存文書はカタログと同じ順に並ぶので、手前の生存文書数がそのままカタログ上の行になる
+    QVector<int> rows(m_documents.size(), -1);
+    int row = 0;
+    for (int docId = 0; docId < m_documents.size(); ++docId) {
+        if (m_documents.at(docId).alive) {
+            rows[docId] = row++;
+        }
+    }
+    return rows;
+}
+
+int SearchIndex::documentCount() const
+{
+    return m_documents.size();
+}
+
+bool SearchIndex::isAlive(quint32 docId) const
+{
+    return docId < quint32(m_documents.size()) && m_documents.at(docId).alive;
+}
+
+QStringView SearchIndex::nameKey(quint32 docId) const
+{
+    if (docId >= quint32(m_documents.size())) {
+        return QStringView();
+    }
+    const Document &doc = m_documents.at(docId);
+    return QStringView(m_keys).mid(doc.keyOffset, doc.nameLength);
+}
+
+int SearchIndex::categoryCount(const QString &category) const
+{
+    auto it = m_categories.constFind(category);
+    return it == m_categories.constEnd() ? 0 : it->count;
+}
+
+QStringList SearchIndex::categories() const
+{
+    QStringList results;
+    for (const QString &category : m_categoryOrder) {
+        if (categoryCount(category) > 0) {
+            results.append(category);
+        }
+    }
+    return results;
+}
+
+QVector<quint32> SearchIndex::categoryDocuments(const QString &category) const
+{
+    QVector<quint32> results;
+    auto it = m_categories.constFind(category);
+    if (it == m_categories.constEnd()) {
+        return results;
+    }
+
+    results.reserve(it->count);
+    const QBitArray &members = it->members;
+    for (int docId = 0; docId < members.size() && results.size() < it->count; ++docId) {
+        if (members.testBit(docId)) {
+            results.append(docId);
+        }
+    }
+    return results;
+}
+
+QVector<quint32> SearchIndex::filterCategory(const QVector<quint32> &docIds, const QString &category) const
+{
+    QVector<quint32> results;
+    auto it = m_categories.constFind(category);
+    if (it == m_categories.constEnd()) {
+        return results;
+    }
+
+    const QBitArray &members = it->members;
+    results.reserve(qMin(int(docIds.size()), it->count));
+    for (quint32 docId : docIds) {
+        if (docId < quint32(members.size()) && members.testBit(docId)) {
+            results.append(docId);
+        }
+    }
+    return results;
+}
+
+quint64 SearchIndex::revision() const
+{
+    return m_revision;
+}
+
+int SearchIndex::size() const
+{
+    return m_documentIds.size();
+}
+
+QString SearchIndex::normalize(const QString &text)
+{
+    // ASCIIのみなら小文字化だけで十分（NFKCは比較的重いので省略）
+    bool asciiOnly = true;
+    for (QChar ch : text) {
+        if (ch.unicode() >= 0x80) {
+            asciiOnly = false;
+            break;
+        }
+    }
+    if (asciiOnly) {
+        return text.toLower();
+    }
+
+    // 全角英数・半角カナなどを統一してから大文字小文字を畳み込む
+    QString result = text.normalized(QString::NormalizationForm_KC).toCaseFolded();
+    for (QChar &ch : result) {
+        const char16_t code = ch.unicode();
+        if (code >= KatakanaFirst && code <= KatakanaLast) {
+            ch = QChar(char16_t(code - KanaOffset));
+        }
+    }
+    return result;
+}
+
+QStringView SearchIndex::keyOf(const Document &doc) const
+{
+    return QStringView(m_keys).mid(doc.keyOffset, doc.keyLength);
+}
+
+int SearchIndex::appendKey(const QString &key)
+{
+    const int offset = m_keys.size();
+    m_keys.append(key);
+    return offset;
+}
+
+QString SearchIndex::buildKey(const AppInfo &app)
+{
+    return normalize(app.name) + FieldSeparator + normalize(app.description) + FieldSeparator +
+           normalize(app.path);
+}
+
+quint64 SearchIndex::trigramAt(QStringView text, int pos)
+{
+    return (quint64(text.at(pos).unicode()) << 32) |
+           (quint64(text.at(pos + 1).unicode()) << 16) |
+           quint64(text.at(pos + 2).unicode());
+}
+
+void SearchIndex::addPostings(quint32 docId, QStringView key)
+{
+    for (int pos = 0; pos + 3 <= key.size(); ++pos) {
+        if (key.at(pos) == FieldSeparator || key.at(pos + 1) == FieldSeparator ||
+            key.at(pos + 2) == FieldSeparator) {
+            continue;
+        }
+
+        QVector<quint32> &list = m_postings[trigramAt(key, pos)];
+        if (list.isEmpty() || list.last() < docId) {
+            list.append(docId);
+        } else if (list.last() != docId) {
+            // 更新された既存文書は途中に挿入する
+            auto it = std::lower_bound(list.begin(), list.end(), docId);
+            if (it == list.end() || *it != docId) {
+                list.insert(it, docId);
+            }
+        }
+    }
+}
+
+void SearchIndex::addToCategory(quint32 docId, const QString &category)
+{
+    auto it = m_categories.find(category);
+    if (it == m_categories.end()) {
+        it = m_categories.insert(category, CategorySet());
+        m_categoryOrder.append(category);
+    }
+
+    // ビットマップは文書数に合わせて倍々で伸ばす
+    QBitArray &members = it->members;
+    if (docId >= quint32(members.size())) {
+        members.resize(qMax(int(docId) + 1, int(members.size()) * 2));
+    }
+    if (!members.testBit(docId)) {
+        members.setBit(docId);
+        ++it->count;
+    }
+}
+
+void SearchIndex::removeFromCategory(quint32 docId, const QString &category)
+{
+    auto it = m_categories.find(category);
+    if (it == m_categories.end() || docId >= quint32(it->members.size()) || !it->members.testBit(docId)) {
+        return;
+    }
+    it->members.clearBit(docId);
+    --it->count;
+}
+
+void SearchIndex::compactIfNeeded()
+{
+    const int aliveCount = m_documentIds.size();
+    const int liveKeyLength = m_keys.size() - m_garbageLength;
+    const bool tooManyDead = m_deadCount >= CompactionMinimum && m_deadCount > aliveCount;
+    const bool tooMuchGarbage = m_garbageLength >= CompactionMinimum && m_garbageLength > liveKeyLength;
+    if (!tooManyDead && !tooMuchGarbage) {
+        return;
+    }
+
+    // 生存文書だけで振り直し、キーも文書順に詰め直す（相対的な順序は変わらない）
+    const QVector<Document> documents = m_documents;
+    const QString keys = m_keys;
+
+    clear();
+    m_documents.reserve(aliveCount);
+    m_keys.reserve(liveKeyLength);
+    for (const Document &doc : documents) {
+        if (!doc.alive) {
+            continue;
+        }
+        const quint32 docId = m_documents.size();
+        const int keyOffset = m_keys.size();
+        m_keys.append(QStringView(keys).mid(doc.keyOffset, doc.keyLength));
+        m_documents.append(Document{doc.appId, keyOffset, doc.keyLength, doc.nameLength, doc.category, true});
+        m_documentIds.insert(doc.appId, docId);
+        addPostings(docId, keyOf(m_documents.last()));
+        addToCategory(docId, doc.category);
+    }
+    qDebug() << "Compacted search index to" << m_documents.size() << "documents";
+}
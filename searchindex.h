@@ -0,0 +1,98 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QString>
+#include <QStringView>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include <QBitArray>
+#include "appinfo.h"
+#include "appstore.h"
+
+// アプリ名・説明・パスに対するトライグラム転置インデックス
+//
+// 各アプリには単調増加する文書IDを振り、削除されても再利用しない。
+// 追加はカタログ末尾、更新は同じ文書IDのままなので、文書IDの順序はカタログの並び順と一致する。
+// ポスティングリストは文書IDの昇順で、更新時に消えたトライグラムは残る（候補の検証で除外する）。
+// 正規化済みの検索キーはAppInfoには持たせず、1本の連続したバッファに詰めて保持する。
+// カテゴリごとの所属は文書IDのビットマップと件数で持ち、件数の参照と検索結果の絞り込みに使う。
+class SearchIndex
+{
+public:
+    SearchIndex();
+
+    void clear();
+    void rebuild(const AppStore &store);
+
+    // 差分更新
+    void addApp(const AppInfo &app);
+    void updateApp(const QString &appId, const AppInfo &app);
+    void removeApp(const QString &appId);
+    void updateCategory(const QString &appId, const QString &category);
+
+    // 部分一致検索（一致したアプリIDをカタログ順で返す）
+    QStringList search(const QString &keyword) const;
+
+    // 文書ID単位の検索（queryは normalize() 済みであること。結果は文書ID＝カタログ順）
+    QVector<quint32> searchDocuments(const QString &query) const;
+    QVector<quint32> filterDocuments(const QVector<quint32> &docIds, const QString &query) const;
+    QStringList appIds(const QVector<quint32> &docIds) const;
+    QVector<int> documentRows() const;     // 文書ID → カタログ上の行（削除済みは-1）
+
+    // 文書単位の参照（あいまい検索などでの全件走査用）
+    int documentCount() const;
+    bool isAlive(quint32 docId) const;
+    QStringView nameKey(quint32 docId) const;   // 正規化済みの名前
+
+    // カテゴリ別の所属（件数はO(1)。結果は文書ID＝カタログ順）
+    int categoryCount(const QString &category) const;
+    QStringList categories() const;        // 所属のあるカテゴリ（最初に現れた順）
+    QVector<quint32> categoryDocuments(const QString &category) const;
+    QVector<quint32> filterCategory(const QVector<quint32> &docIds, const QString &category) const;
+
+    // 変更のたびに増える版番号（文書IDの振り直しも含む）
+    quint64 revision() const;
+
+    int size() const;
+
+    // 検索キーの正規化（NFKC・ケースフォールディング・カタカナをひらがなに統一）
+    static QString normalize(const QString &text);
+
+private:
+    struct Document {
+        QString appId;
+        int keyOffset;      // m_keys 内の位置（「名前 \x1f 説明 \x1f パス」を正規化したもの）
+        int keyLength;
+        int nameLength;     // キー先頭の名前部分の長さ
+        QString category;
+        bool alive;
+    };
+
+    struct CategorySet {
+        QBitArray members;  // 文書ID → 所属
+        int count = 0;
+    };
+
+    QVector<Document> m_documents;              // 文書ID → 文書
+    QHash<QString, quint32> m_documentIds;      // アプリID → 文書ID
+    QHash<quint64, QVector<quint32>> m_postings; // トライグラム → 文書ID（昇順）
+    QString m_keys;                             // 全文書の検索キーを連結したバッファ
+    QHash<QString, CategorySet> m_categories;   // カテゴリ → 所属文書
+    QStringList m_categoryOrder;                // カテゴリが最初に現れた順
+    int m_deadCount;
+    int m_garbageLength;                        // 更新・削除で参照されなくなったキーの長さ
+    quint64 m_revision;
+
+    QStringView keyOf(const Document &doc) const;
+    int appendKey(const QString &key);
+    static QString buildKey(const AppInfo &app);
+    static quint64 trigramAt(QStringView text, int pos);
+    void addPostings(quint32 docId, QStringView key);
+    void addToCategory(quint32 docId, const QString &category);
+    void removeFromCategory(quint32 docId, const QString &category);
+    void compactIfNeeded();
+};
+
+#endif // SEARCHINDEX_H
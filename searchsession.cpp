@@ -0,0 +1,92 @@
+#include "searchsession.h"
+#include "searchindex.h"
+
+SearchSession::SearchSession(const SearchIndex *index, int cacheSize)
+    : m_index(index)
+    , m_revision(index ? index->revision() : 0)
+    , m_cacheSize(qMax(1, cacheSize))
+{
+}
+
+QStringList SearchSession::search(const QString &keyword)
+{
+    return m_index ? m_index->appIds(searchDocuments(keyword)) : QStringList();
+}
+
+QVector<quint32> SearchSession::searchDocuments(const QString &keyword)
+{
+    if (!m_index) {
+        return QVector<quint32>();
+    }
+
+    // アプリの追加・更新・削除があった場合は以前の結果を使えない
+    if (m_index->revision() != m_revision) {
+        reset();
+    }
+
+    const QString query = SearchIndex::normalize(keyword);
+
+    QVector<quint32> hits;
+    const CacheEntry *base = findBase(query);
+    if (base && base->query == query) {
+        // 同じ検索語（バックスペースで戻った場合など）
+        hits = base->hits;
+    } else if (base) {
+        // 検索語が伸びた場合は前の結果だけを確認する
+        hits = m_index->filterDocuments(base->hits, query);
+    } else {
+        hits = m_index->searchDocuments(query);
+    }
+
+    remember(query, hits);
+    return hits;
+}
+
+void SearchSession::reset()
+{
+    m_cache.clear();
+    m_revision = m_index ? m_index->revision() : 0;
+}
+
+void SearchSession::setCacheSize(int cacheSize)
+{
+    m_cacheSize = qMax(1, cacheSize);
+    while (m_cache.size() > m_cacheSize) {
+        m_cache.removeLast();
+    }
+}
+
+int SearchSession::cacheSize() const
+{
+    return m_cacheSize;
+}
+
+const SearchSession::CacheEntry *SearchSession::findBase(const QString &query) const
+{
+    // 完全一致を優先し、なければ検索語を含む中で最も結果の少ないものを使う
+    const CacheEntry *best = nullptr;
+    for (const CacheEntry &entry : m_cache) {
+        if (entry.query == query) {
+            return &entry;
+        }
+        if (query.contains(entry.query) && (!best || entry.hits.size() < best->hits.size())) {
+            best = &entry;
+        }
+    }
+    return best;
+}
+
+void SearchSession::remember(const QString &query, const QVector<quint32> &hits)
+{
+    for (int i = 0; i < m_cache.size(); ++i) {
+        if (m_cache.at(i).query == query) {
+            m_cache.removeAt(i);
+            break;
+        }
+    }
+
+    m_cache.prepend(CacheEntry{query, hits});
+    while (m_cache.size() > m_cacheSize) {
+        m_cache.removeLast();
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef SEARCHSESSION_H
+#define SEARCHSESSION_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+
+class SearchIndex;
+
+// 入力中の検索を絞り込みで処理する検索セッション
+// 新しい検索語が前回（またはキャッシュ済み）の検索語を含む場合は、その結果だけを再確認する。
+// 結果は SearchIndex の文書ID（カタログ順）で保持し、インデックスが変更されたら破棄する。
+class SearchSession
+{
+public:
+    explicit SearchSession(const SearchIndex *index, int cacheSize = 8);
+
+    QStringList search(const QString &keyword);
+    QVector<quint32> searchDocuments(const QString &keyword);
+    void reset();
+
+    void setCacheSize(int cacheSize);
+    int cacheSize() const;
+
+private:
+    struct CacheEntry {
+        QString query;              // 正規化済み
+        QVector<quint32> hits;
+    };
+
+    const SearchIndex *m_index;
+    quint64 m_revision;
+    QList<CacheEntry> m_cache;      // 先頭ほど新しい（先頭が前回の検索）
+    int m_cacheSize;
+
+    const CacheEntry *findBase(const QString &query) const;
+    void remember(const QString &query, const QVector<quint32> &hits);
+};
+
+#endif // SEARCHSESSION_H
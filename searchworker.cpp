@@ -0,0 +1,172 @@
+#include "searchworker.h"
+#include "fuzzymatcher.h"
+#include <QMutexLocker>
+#include <QDebug>
+
+namespace {
+
+// 1回に渡す行数（最初のチャンクで1ページ分は埋まる程度）
+const int DefaultChunkSize = 512;
+// あいまい検索で返す最大件数（これより下位の一致はほぼ意味を持たない）
+const int DefaultFuzzyLimit = 1000;
+const quint64 NoRevision = ~quint64(0);
+
+}
+
+SearchWorker::SearchWorker(QObject *parent)
+    : QObject(parent)
+    , m_worker(new QObject)
+    , m_hasPending(false)
+    , m_generation(0)
+    , m_chunkSize(DefaultChunkSize)
+    , m_fuzzyLimit(DefaultFuzzyLimit)
+    , m_session(&m_index)
+    , m_documentRowsRevision(NoRevision)
+{
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread.setObjectName("SearchWorker");
+    m_thread.start();
+}
+
+SearchWorker::~SearchWorker()
+{
+    cancel();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+quint64 SearchWorker::search(const SearchIndex &index, const QString &keyword, Mode mode)
+{
+    quint64 generation;
+    bool wasPending;
+    {
+        QMutexLocker locker(&m_mutex);
+        generation = m_generation.fetchAndAddOrdered(1) + 1;
+        wasPending = m_hasPending;
+        // 未着手の要求は最新のもので上書きする（速い入力では途中の検索語を飛ばす）
+        m_pending.generation = generation;
+        m_pending.keyword = keyword;
+        m_pending.mode = mode;
+        m_pending.index = index;
+        m_hasPending = true;
+    }
+
+    if (!wasPending) {
+        QMetaObject::invokeMethod(m_worker, [this]() { processPending(); }, Qt::QueuedConnection);
+    }
+    return generation;
+}
+
+void SearchWorker::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_generation.fetchAndAddOrdered(1);
+    m_pending = Request();
+    m_hasPending = false;
+}
+
+quint64 SearchWorker::currentGeneration() const
+{
+    return m_generation.loadAcquire();
+}
+
+void SearchWorker::setChunkSize(int rows)
+{
+    QMutexLocker locker(&m_mutex);
+    m_chunkSize = qMax(1, rows);
+}
+
+int SearchWorker::chunkSize() const
+{
+    return m_chunkSize;
+}
+
+void SearchWorker::setFuzzyLimit(int rows)
+{
+    QMutexLocker locker(&m_mutex);
+    m_fuzzyLimit = qMax(1, rows);
+}
+
+int SearchWorker::fuzzyLimit() const
+{
+    return m_fuzzyLimit;
+}
+
+void SearchWorker::processPending()
+{
+    Request request;
+    int chunkSize;
+    int fuzzyLimit;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_hasPending) {
+            return;
+        }
+        request = m_pending;
+        m_pending = Request();
+        m_hasPending = false;
+        chunkSize = m_chunkSize;
+        fuzzyLimit = m_fuzzyLimit;
+    }
+
+    // 前回と同じ版のインデックスなら SearchSession の絞り込みがそのまま効く
+    m_index = request.index;
+    request.index = SearchIndex();
+    if (m_documentRowsRevision != m_index.revision()) {
+        m_documentRows = m_index.documentRows();
+        m_documentRowsRevision = m_index.revision();
+    }
+
+    // あいまい検索は毎回全件を採点する（SearchSession の絞り込み結果は使わない）
+    const QVector<quint32> hits = request.mode == Fuzzy
+            ? fuzzyDocuments(request.keyword, fuzzyLimit)
+            : m_session.searchDocuments(request.keyword);
+
+    // 文書IDをカタログ上の行に変換しながら分割して渡す
+    QVector<int> chunk;
+    chunk.reserve(qMin(int(hits.size()), chunkSize));
+    bool first = true;
+    for (quint32 docId : hits) {
+        const int row = m_documentRows.value(docId, -1);
+        if (row >= 0) {
+            chunk.append(row);
+        }
+        if (chunk.size() >= chunkSize) {
+            // より新しい検索が来ていれば残りは捨てる
+            if (m_generation.loadAcquire() != request.generation) {
+                m_index = SearchIndex();
+                return;
+            }
+            deliver(request.generation, chunk, first, false);
+            first = false;
+            chunk.clear();
+        }
+    }
+    deliver(request.generation, chunk, first, true);
+
+    // 検索の間はインデックスを共有しない（保持したままだと、次の変更でGUI側が丸ごと複製する）。
+    // 絞り込みの再利用は版の番号で判定するので、次の検索で同じ版を受け取れば引き続き効く
+    m_index = SearchIndex();
+}
+
+QVector<quint32> SearchWorker::fuzzyDocuments(const QString &keyword, int limit) const
+{
+    const QVector<FuzzyMatcher::Match> matches = FuzzyMatcher::search(m_index, keyword, limit);
+    QVector<quint32> docIds;
+    docIds.reserve(matches.size());
+    for (const FuzzyMatcher::Match &match : matches) {
+        docIds.append(match.docId);
+    }
+    return docIds;
+}
+
+void SearchWorker::deliver(quint64 generation, const QVector<int> &rows, bool first, bool last)
+{
+    QMetaObject::invokeMethod(this, [this, generation, rows, first, last]() {
+        // GUIスレッドに届いた時点でも世代を確認する
+        if (generation == m_generation.loadAcquire()) {
+            emit resultsReady(generation, rows, first, last);
+        }
+    }, Qt::QueuedConnection);
+}
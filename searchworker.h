@@ -0,0 +1,76 @@
+#ifndef SEARCHWORKER_H
+#define SEARCHWORKER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QThread>
+#include <QMutex>
+#include <QAtomicInteger>
+#include "searchindex.h"
+#include "searchsession.h"
+
+// 検索をワーカースレッドで実行し、結果をカタログ上の行番号のリストとして分割して返す
+//
+// search() ごとに世代番号を進め、新しい検索が来た時点で古い検索の結果は破棄する。
+// SearchIndex は暗黙共有のコンテナだけで構成されているので、検索ごとの複製は安価。
+// ワーカー側でも SearchSession を持ち、入力途中の絞り込みはワーカー上で行う。
+// あいまい検索（FuzzyMatcher）ではスコアの高い順に上位 fuzzyLimit() 件を返す。
+class SearchWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode {
+        Substring,      // 部分一致（カタログ順）
+        Fuzzy           // あいまい検索（スコア順）
+    };
+    Q_ENUM(Mode)
+
+    explicit SearchWorker(QObject *parent = nullptr);
+    ~SearchWorker();
+
+    // 検索要求（戻り値は世代番号）
+    quint64 search(const SearchIndex &index, const QString &keyword, Mode mode = Substring);
+    void cancel();
+    quint64 currentGeneration() const;
+
+    void setChunkSize(int rows);
+    int chunkSize() const;
+    void setFuzzyLimit(int rows);
+    int fuzzyLimit() const;
+
+signals:
+    // GUIスレッドで発行される。first で結果の差し替え、last で検索完了を示す
+    void resultsReady(quint64 generation, const QVector<int> &rows, bool first, bool last);
+
+private:
+    struct Request {
+        quint64 generation = 0;
+        QString keyword;
+        Mode mode = Substring;
+        SearchIndex index;
+    };
+
+    QThread m_thread;
+    QObject *m_worker;      // m_thread 上で動作するコンテキスト
+
+    QMutex m_mutex;
+    Request m_pending;
+    bool m_hasPending;
+    QAtomicInteger<quint64> m_generation;
+    int m_chunkSize;
+    int m_fuzzyLimit;
+
+    // ワーカースレッド側の状態
+    SearchIndex m_index;            // 検索中だけ保持する
+    SearchSession m_session;
+    QVector<int> m_documentRows;
+    quint64 m_documentRowsRevision;
+
+    void processPending();
+    QVector<quint32> fuzzyDocuments(const QString &keyword, int limit) const;
+    void deliver(quint64 generation, const QVector<int> &rows, bool first, bool last);
+};
+
+#endif // SEARCHWORKER_H
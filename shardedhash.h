@@ -0,0 +1,84 @@
+#ifndef SHARDEDHASH_H
+#define SHARDEDHASH_H
+
+#include <QHash>
+#include <QVector>
+
+// キーのハッシュ値で ShardCount 個の QHash に振り分けた連想配列（カタログの版が共有する索引用）
+//
+// 複製は各分割の暗黙共有のハンドルを増やすだけで、複製後の追加・削除で複製されるのは
+// そのキーの入る分割だけになる。同じ値の再登録・無いキーの削除では何も複製しない。
+template <typename Key, typename T>
+class ShardedHash
+{
+public:
+    static const int ShardCount = 64;
+
+    ShardedHash() : m_shards(ShardCount) {}
+
+    int size() const
+    {
+        int total = 0;
+        for (const QHash<Key, T> &shard : m_shards) {
+            total += shard.size();
+        }
+        return total;
+    }
+
+    bool isEmpty() const { return size() == 0; }
+
+    void clear()
+    {
+        m_shards = QVector<QHash<Key, T>>(ShardCount);
+    }
+
+    // 足りない分割だけを広げる（足りている分割は共有したまま）
+    void reserve(int count)
+    {
+        const int perShard = count / ShardCount + 1;
+        for (int i = 0; i < ShardCount; ++i) {
+            if (m_shards.at(i).capacity() < perShard) {
+                m_shards[i].reserve(perShard);
+            }
+        }
+    }
+
+    T value(const Key &key, const T &defaultValue = T()) const
+    {
+        return m_shards.at(shardOf(key)).value(key, defaultValue);
+    }
+
+    bool contains(const Key &key) const
+    {
+        return m_shards.at(shardOf(key)).contains(key);
+    }
+
+    void insert(const Key &key, const T &value)
+    {
+        const int shard = shardOf(key);
+        const QHash<Key, T> &current = m_shards.at(shard);
+        auto it = current.constFind(key);
+        if (it != current.constEnd() && it.value() == value) {
+            return;
+        }
+        m_shards[shard].insert(key, value);
+    }
+
+    void remove(const Key &key)
+    {
+        const int shard = shardOf(key);
+        if (m_shards.at(shard).contains(key)) {
+            m_shards[shard].remove(key);
+        }
+    }
+
+private:
+    QVector<QHash<Key, T>> m_shards;
+
+    static int shardOf(const Key &key)
+    {
+        return int(qHash(key) % ShardCount);
+    }
+};
+
+#endif // SHARDEDHASH_H